@@ -1805,7 +1805,7 @@ static void test_kmeans(void)
 		}
 	}
 
-	r = lwgeom_cluster_kmeans((const LWGEOM **)geoms, N, num_clusters, 0.0);
+	r = lwgeom_cluster_kmeans((const LWGEOM **)geoms, N, num_clusters, 0.0, 0);
 
 	// for (i = 0; i < k; i++)
 	// {
@@ -1821,6 +1821,115 @@ static void test_kmeans(void)
 	return;
 }
 
+static void test_kmeans_many_clusters(void)
+{
+	static int N = 3000;
+	static int num_clusters = 60;
+	LWGEOM **geoms;
+	double *cx, *cy;
+	int *count;
+	int i, j;
+	int *r;
+
+	geoms = lwalloc(sizeof(LWGEOM*) * N);
+	for (i = 0; i < N; i++)
+	{
+		double x = 10 * (rand() % 8) + 5.0 * rand() / RAND_MAX;
+		double y = 10 * (rand() % 8) + 5.0 * rand() / RAND_MAX;
+		geoms[i] = lwpoint_as_lwgeom(lwpoint_make2d(SRID_UNKNOWN, x, y));
+	}
+
+	r = lwgeom_cluster_kmeans((const LWGEOM **)geoms, N, num_clusters, 0.0, 0);
+	CU_ASSERT_FATAL(r != NULL);
+
+	/* Converged result: every point is nearest to the centroid of its own cluster */
+	cx = lwalloc0(sizeof(double) * num_clusters);
+	cy = lwalloc0(sizeof(double) * num_clusters);
+	count = lwalloc0(sizeof(int) * num_clusters);
+	for (i = 0; i < N; i++)
+	{
+		const POINT2D *pt = getPoint2d_cp(lwgeom_as_lwpoint(geoms[i])->point, 0);
+		CU_ASSERT_FATAL(r[i] >= 0 && r[i] < num_clusters);
+		cx[r[i]] += pt->x;
+		cy[r[i]] += pt->y;
+		count[r[i]]++;
+	}
+	for (j = 0; j < num_clusters; j++)
+	{
+		if (!count[j])
+			continue;
+		cx[j] /= count[j];
+		cy[j] /= count[j];
+	}
+	for (i = 0; i < N; i++)
+	{
+		const POINT2D *pt = getPoint2d_cp(lwgeom_as_lwpoint(geoms[i])->point, 0);
+		double own = (pt->x - cx[r[i]]) * (pt->x - cx[r[i]]) + (pt->y - cy[r[i]]) * (pt->y - cy[r[i]]);
+		for (j = 0; j < num_clusters; j++)
+		{
+			double d;
+			if (!count[j])
+				continue;
+			d = (pt->x - cx[j]) * (pt->x - cx[j]) + (pt->y - cy[j]) * (pt->y - cy[j]);
+			CU_ASSERT(own <= d + 1e-9);
+		}
+	}
+
+	/* Clean up */
+	lwfree(count);
+	lwfree(cy);
+	lwfree(cx);
+	lwfree(r);
+	for (i = 0; i < N; i++)
+		lwgeom_free(geoms[i]);
+	lwfree(geoms);
+}
+
+static void test_kmeans_minibatch(void)
+{
+	static int N = 4000;
+	static int num_blobs = 4;
+	LWGEOM **geoms;
+	int blob_cluster[4];
+	int i, j;
+	int *r;
+
+	/* Well separated blobs, so any sensible sampling finds them */
+	geoms = lwalloc(sizeof(LWGEOM*) * N);
+	for (i = 0; i < N; i++)
+	{
+		double x = 100 * (i % num_blobs) + 1.0 * rand() / RAND_MAX;
+		double y = 1.0 * rand() / RAND_MAX;
+		geoms[i] = lwpoint_as_lwgeom(lwpoint_make2d(SRID_UNKNOWN, x, y));
+	}
+
+	r = lwgeom_cluster_kmeans((const LWGEOM **)geoms, N, num_blobs, 0.0, 100);
+	CU_ASSERT_FATAL(r != NULL);
+	for (i = 0; i < N; i++)
+		CU_ASSERT_EQUAL(r[i], r[i % num_blobs]);
+	for (i = 0; i < num_blobs; i++)
+		for (j = i + 1; j < num_blobs; j++)
+			CU_ASSERT_NOT_EQUAL(r[i], r[j]);
+	lwfree(r);
+
+	/* The radius limit splits a single cluster along the blobs */
+	r = lwgeom_cluster_kmeans((const LWGEOM **)geoms, N, 1, 10.0, 100);
+	CU_ASSERT_FATAL(r != NULL);
+	for (i = 0; i < num_blobs; i++)
+		blob_cluster[i] = r[i];
+	for (i = 0; i < N; i++)
+		CU_ASSERT_EQUAL(r[i], blob_cluster[i % num_blobs]);
+	for (i = 0; i < num_blobs; i++)
+		for (j = i + 1; j < num_blobs; j++)
+			CU_ASSERT_NOT_EQUAL(blob_cluster[i], blob_cluster[j]);
+	lwfree(r);
+
+	/* Clean up */
+	for (i = 0; i < N; i++)
+		lwgeom_free(geoms[i]);
+	lwfree(geoms);
+}
+
 static void test_trim_bits(void)
 {
 	POINTARRAY *pta = ptarray_construct_empty(LW_TRUE, LW_TRUE, 2);
@@ -1915,6 +2024,8 @@ void algorithms_suite_setup(void)
 	PG_ADD_TEST(suite,test_lw_arc_center);
 	PG_ADD_TEST(suite,test_point_density);
 	PG_ADD_TEST(suite,test_kmeans);
+	PG_ADD_TEST(suite,test_kmeans_many_clusters);
+	PG_ADD_TEST(suite,test_kmeans_minibatch);
 	PG_ADD_TEST(suite,test_median_handles_3d_correctly);
 	PG_ADD_TEST(suite,test_median_robustness);
 	PG_ADD_TEST(suite,test_lwpoly_construct_circle);
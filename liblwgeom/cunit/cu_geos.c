@@ -186,6 +186,77 @@ static void test_geos_subdivide(void)
 	lwgeom_free(geom1);
 }
 
+static void
+test_geos_partitioned_overlay(void)
+{
+	LWGEOM *geom1, *near, *far, *edge, *plain, *part;
+	uint32_t i;
+
+	geom1 = lwgeom_from_wkt(
+	    "MULTIPOLYGON(((0 0,1 0,1 1,0 1,0 0)),((10 0,11 0,11 1,10 1,10 0)),"
+	    "((20 0,21 0,21 1,20 1,20 0)),((30 0,31 0,31 1,30 1,30 0)))",
+	    LW_PARSER_CHECK_NONE);
+	near = lwgeom_from_wkt("POLYGON((0.5 0.5,1.5 0.5,1.5 1.5,0.5 1.5,0.5 0.5))", LW_PARSER_CHECK_NONE);
+	far = lwgeom_from_wkt("POLYGON((100 100,101 100,101 101,100 101,100 100))", LW_PARSER_CHECK_NONE);
+
+	/* Same area as the whole overlay, from one part */
+	plain = lwgeom_intersection_prec(geom1, near, -1);
+	part = lwgeom_intersection_partitioned(geom1, near, -1);
+	ASSERT_DOUBLE_EQUAL(lwgeom_area(part), lwgeom_area(plain));
+	ASSERT_DOUBLE_EQUAL(lwgeom_area(part), 0.25);
+	lwgeom_free(plain);
+	lwgeom_free(part);
+
+	/* Untouched parts come through the difference as they were */
+	plain = lwgeom_difference_prec(geom1, near, -1);
+	part = lwgeom_difference_partitioned(geom1, near, -1);
+	ASSERT_DOUBLE_EQUAL(lwgeom_area(part), lwgeom_area(plain));
+	ASSERT_INT_EQUAL(part->type, MULTIPOLYGONTYPE);
+	ASSERT_INT_EQUAL(lwgeom_as_lwcollection(part)->ngeoms, 4);
+	for (i = 0; i < 3; i++)
+		CU_ASSERT(lwgeom_same(lwgeom_as_lwcollection(part)->geoms[i], lwgeom_as_lwcollection(geom1)->geoms[i + 1]));
+	lwgeom_free(plain);
+	lwgeom_free(part);
+
+	/* Nothing in reach still gets the empty type GEOS picks */
+	plain = lwgeom_intersection_prec(geom1, far, -1);
+	part = lwgeom_intersection_partitioned(geom1, far, -1);
+	CU_ASSERT(lwgeom_is_empty(part));
+	ASSERT_INT_EQUAL(part->type, plain->type);
+	lwgeom_free(plain);
+	lwgeom_free(part);
+
+	part = lwgeom_difference_partitioned(geom1, far, -1);
+	ASSERT_DOUBLE_EQUAL(lwgeom_area(part), 4.0);
+	ASSERT_INT_EQUAL(lwgeom_as_lwcollection(part)->ngeoms, 4);
+	lwgeom_free(part);
+
+	/* A part within the grid size of the other input snaps into reach */
+	edge = lwgeom_from_wkt("POLYGON((11.2 0,12 0,12 1,11.2 1,11.2 0))", LW_PARSER_CHECK_NONE);
+	plain = lwgeom_intersection_prec(geom1, edge, 1);
+	part = lwgeom_intersection_partitioned(geom1, edge, 1);
+	ASSERT_INT_EQUAL(part->type, plain->type);
+	ASSERT_DOUBLE_EQUAL(lwgeom_length(part), lwgeom_length(plain));
+	lwgeom_free(plain);
+	lwgeom_free(part);
+	lwgeom_free(edge);
+
+	/* With a grid size every part of the difference is snapped */
+	edge = lwgeom_from_wkt(
+	    "MULTIPOLYGON(((0.2 0.2,1.2 0.2,1.2 1.2,0.2 1.2,0.2 0.2)),((10.3 0.3,11.3 0.3,11.3 1.3,10.3 1.3,10.3 0.3)))",
+	    LW_PARSER_CHECK_NONE);
+	plain = lwgeom_difference_prec(edge, near, 0.5);
+	part = lwgeom_difference_partitioned(edge, near, 0.5);
+	CU_ASSERT(lwgeom_same(part, plain));
+	lwgeom_free(plain);
+	lwgeom_free(part);
+	lwgeom_free(edge);
+
+	lwgeom_free(geom1);
+	lwgeom_free(near);
+	lwgeom_free(far);
+}
+
 /*
 ** Used by test harness to register the tests in this file.
 */
@@ -199,4 +270,5 @@ void geos_suite_setup(void)
 	PG_ADD_TEST(suite, test_geos_offsetcurve);
 	PG_ADD_TEST(suite, test_geos_offsetcurve_crash);
 	PG_ADD_TEST(suite, test_geos_makevalid);
+	PG_ADD_TEST(suite, test_geos_partitioned_overlay);
 }
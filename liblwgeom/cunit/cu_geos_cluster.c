@@ -367,6 +367,93 @@ static void dbscan_test_3612c(void)
 	do_dbscan_test(test);
 }
 
+/* Point inputs go through the DBSCAN grid, while the same points
+ * wrapped as multipoints go through the STRtree; both must give
+ * the same clusters, numbered the same way. */
+static void dbscan_grid_test(void)
+{
+	const uint32_t num_geoms = 600;
+	const double eps_values[] = { 0.0, 0.5, 2.0, 15.0 };
+	const uint32_t min_points_values[] = { 1, 3, 6 };
+	LWGEOM** points = lwalloc(num_geoms * sizeof(LWGEOM*));
+	LWGEOM** multipoints = lwalloc(num_geoms * sizeof(LWGEOM*));
+	uint32_t seed = 12345;
+	uint32_t i, e, m;
+
+	for (i = 0; i < num_geoms; i++)
+	{
+		double x, y;
+		LWPOINT* pt;
+		LWMPOINT* mpt;
+
+		if (i % 97 == 13)
+		{
+			points[i] = lwpoint_as_lwgeom(lwpoint_construct_empty(SRID_UNKNOWN, 0, 0));
+			multipoints[i] = lwmpoint_as_lwgeom(lwmpoint_construct_empty(SRID_UNKNOWN, 0, 0));
+			continue;
+		}
+
+		/* Repeat some points, so there are exact duplicates */
+		if (i % 11 == 5)
+		{
+			const POINT2D* prev = getPoint2d_cp(lwgeom_as_lwpoint(points[i - 1])->point, 0);
+			x = prev->x;
+			y = prev->y;
+		}
+		else
+		{
+			seed = seed * 1103515245 + 12345;
+			x = (seed >> 8) % 10000 / 100.0;
+			seed = seed * 1103515245 + 12345;
+			y = (seed >> 8) % 10000 / 100.0;
+		}
+
+		pt = lwpoint_make2d(SRID_UNKNOWN, x, y);
+		mpt = lwmpoint_construct_empty(SRID_UNKNOWN, 0, 0);
+		lwmpoint_add_lwpoint(mpt, lwpoint_make2d(SRID_UNKNOWN, x, y));
+		points[i] = lwpoint_as_lwgeom(pt);
+		multipoints[i] = lwmpoint_as_lwgeom(mpt);
+	}
+
+	for (e = 0; e < sizeof(eps_values) / sizeof(double); e++)
+	{
+		for (m = 0; m < sizeof(min_points_values) / sizeof(uint32_t); m++)
+		{
+			UNIONFIND* uf_grid = UF_create(num_geoms);
+			UNIONFIND* uf_tree = UF_create(num_geoms);
+			uint8_t *in_cluster_grid, *in_cluster_tree;
+			uint32_t *ids_grid, *ids_tree;
+
+			union_dbscan(points, num_geoms, uf_grid, eps_values[e], min_points_values[m], &in_cluster_grid);
+			union_dbscan(multipoints, num_geoms, uf_tree, eps_values[e], min_points_values[m], &in_cluster_tree);
+			ids_grid = UF_get_collapsed_cluster_ids(uf_grid, in_cluster_grid);
+			ids_tree = UF_get_collapsed_cluster_ids(uf_tree, in_cluster_tree);
+
+			for (i = 0; i < num_geoms; i++)
+			{
+				ASSERT_INT_EQUAL(in_cluster_grid[i], in_cluster_tree[i]);
+				if (in_cluster_grid[i])
+					ASSERT_INT_EQUAL(ids_grid[i], ids_tree[i]);
+			}
+
+			UF_destroy(uf_grid);
+			UF_destroy(uf_tree);
+			lwfree(in_cluster_grid);
+			lwfree(in_cluster_tree);
+			lwfree(ids_grid);
+			lwfree(ids_tree);
+		}
+	}
+
+	for (i = 0; i < num_geoms; i++)
+	{
+		lwgeom_free(points[i]);
+		lwgeom_free(multipoints[i]);
+	}
+	lwfree(points);
+	lwfree(multipoints);
+}
+
 void geos_cluster_suite_setup(void);
 void geos_cluster_suite_setup(void)
 {
@@ -381,4 +468,5 @@ void geos_cluster_suite_setup(void)
 	PG_ADD_TEST(suite, dbscan_test_3612a);
 	PG_ADD_TEST(suite, dbscan_test_3612b);
 	PG_ADD_TEST(suite, dbscan_test_3612c);
+	PG_ADD_TEST(suite, dbscan_grid_test);
 }
@@ -794,6 +794,150 @@ test_gserialized2_wkb_roundtrip_float_rounded_box(void)
 	lwfree(wkb);
 }
 
+static void
+test_gserialized2_cursor(void)
+{
+	uint32_t i;
+
+	const char *wkt[] =
+	{
+		"POINT EMPTY",
+		"POINT(1 2)",
+		"LINESTRING(0 0,1 1,3 0)",
+		"POLYGON((0 0,10 0,10 10,0 10,0 0),(1 1,2 1,2 2,1 1),(5 5,6 5,6 6,5 5))",
+		"POLYGON((0 0,10 0,10 10,0 10,0 0),(1 1,2 1,2 2,1 1))",
+		"MULTIPOLYGON(((0 0,1 0,1 1,0 0)),EMPTY,((5 5,9 5,9 9,5 9,5 5),(6 6,7 6,7 7,6 6)))",
+		"MULTILINESTRING Z ((0 0 0,1 1 1),EMPTY,(2 2 2,-3 -4 5,6 7 8))",
+		"GEOMETRYCOLLECTION(POINT(1 1),GEOMETRYCOLLECTION(LINESTRING(0 0,-1 5),POLYGON((2 2,3 2,3 3,2 2))))",
+		"CIRCULARSTRING(0 0,1 1,2 0)",
+		"TIN(((0 0 0,0 0 1,0 1 0,0 0 0)),((0 0 0,0 1 0,1 1 0,0 0 0)))"
+	};
+
+	for (i = 0; i < (sizeof wkt / sizeof(char *)); i++)
+	{
+		LWGEOM *lwgeom = lwgeom_from_wkt(wkt[i], LW_PARSER_CHECK_NONE);
+		GSERIALIZED *g;
+		GSERIALIZED_CURSOR cursor;
+		uint32_t npoints = 0;
+		double area = 0.0, part = 0.0;
+		GBOX box, expected;
+
+		lwgeom_drop_bbox(lwgeom);
+		g = gserialized2_from_lwgeom(lwgeom, NULL);
+		CU_ASSERT_EQUAL_FATAL(gserialized_cursor_init(&cursor, g), LW_SUCCESS);
+
+		while (gserialized_cursor_next(&cursor))
+		{
+			npoints += cursor.pa.npoints;
+			if (cursor.type == POLYGONTYPE)
+			{
+				if (cursor.ring == 0)
+				{
+					area += part;
+					part = 0.0;
+				}
+				if (cursor.pa.npoints >= 3)
+					part += (cursor.ring ? -1 : 1) * fabs(ptarray_signed_area(&cursor.pa));
+			}
+		}
+		area += part;
+		CU_ASSERT_EQUAL(npoints, lwgeom_count_vertices(lwgeom));
+		if (lwgeom->type == POLYGONTYPE || lwgeom->type == MULTIPOLYGONTYPE)
+			CU_ASSERT_EQUAL(area, lwgeom_area(lwgeom));
+
+		/* Boxes of linear geometries are calculated from the cursor */
+		if (lwgeom_calculate_gbox(lwgeom, &expected) == LW_SUCCESS)
+		{
+			gbox_float_round(&expected);
+			CU_ASSERT_EQUAL(gserialized2_get_gbox_p(g, &box), LW_SUCCESS);
+			CU_ASSERT_TRUE(gbox_same(&box, &expected));
+		}
+
+		lwgeom_free(lwgeom);
+		lwfree(g);
+	}
+}
+
+static void
+test_gserialized2_from_wkb(void)
+{
+	uint32_t i, j;
+	const uint8_t variants[] = {WKB_NDR | WKB_EXTENDED, WKB_NDR | WKB_ISO, WKB_XDR | WKB_EXTENDED};
+
+	const char *wkt[] =
+	{
+		"POINT EMPTY",
+		"POINT(1 2)",
+		"SRID=4326;POINT ZM(1 2 3 4)",
+		"LINESTRING EMPTY",
+		"LINESTRING(0 0,1 1)",
+		"SRID=3857;LINESTRING M(0 0 1,1 1 2,3 0 3)",
+		"POLYGON EMPTY",
+		"POLYGON((0 0,10 0,10 10,0 10,0 0),(1 1,2 1,2 2,1 1))",
+		"POLYGON Z ((0 0 1,10 0 2,10 10 3,0 0 1),(1 1 9,2 1 9,2 2 9,1 1 9),(5 5 0,6 5 0,6 6 0,5 5 0))",
+		"MULTIPOINT(1 1)",
+		"MULTIPOINT(1 1,EMPTY,-2 5)",
+		"MULTIPOINT(EMPTY,EMPTY)",
+		"MULTILINESTRING((0 0,1 1))",
+		"MULTILINESTRING Z ((0 0 0,1 1 1),EMPTY,(2 2 2,-3 -4 5,6 7 8))",
+		"MULTIPOLYGON(((0 0,1 0,1 1,0 0)),EMPTY,((5 5,9 5,9 9,5 9,5 5),(6 6,7 6,7 7,6 6)))",
+		"GEOMETRYCOLLECTION EMPTY",
+		"GEOMETRYCOLLECTION(POINT EMPTY,LINESTRING EMPTY)",
+		"SRID=4326;GEOMETRYCOLLECTION(POINT(1 1),GEOMETRYCOLLECTION(LINESTRING(0 0,-1 5),POLYGON((2 2,3 2,3 3,2 2))))",
+		"CIRCULARSTRING(0 0,1 1,2 0)",
+		"TIN(((0 0 0,0 0 1,0 1 0,0 0 0)),((0 0 0,0 1 0,1 1 0,0 0 0)))",
+		"GEOMETRYCOLLECTION(POINT(1 1),CIRCULARSTRING(0 0,1 1,2 0))"
+	};
+
+	for (i = 0; i < (sizeof wkt / sizeof(char *)); i++)
+	{
+		LWGEOM *lwgeom = lwgeom_from_wkt(wkt[i], LW_PARSER_CHECK_NONE);
+		for (j = 0; j < (sizeof variants / sizeof(uint8_t)); j++)
+		{
+			lwvarlena_t *wkb = lwgeom_to_wkb_varlena(lwgeom, variants[j]);
+			size_t wkb_size = LWSIZE_GET(wkb->size) - LWVARHDRSZ;
+			size_t size, expected_size;
+			GSERIALIZED *g = gserialized_from_wkb((uint8_t *)wkb->data, wkb_size, LW_PARSER_CHECK_ALL, &size);
+
+			/* Curves, surfaces and swapped bytes go through the parser */
+			if (lwgeom_has_arc(lwgeom) || lwgeom->type == TINTYPE || (variants[j] & WKB_XDR))
+				CU_ASSERT_PTR_NULL(g);
+
+			if (g)
+			{
+				LWGEOM *parsed = lwgeom_from_wkb((uint8_t *)wkb->data, wkb_size, LW_PARSER_CHECK_ALL);
+				GSERIALIZED *expected;
+				if (lwgeom_needs_bbox(parsed))
+					lwgeom_add_bbox(parsed);
+				expected = gserialized2_from_lwgeom(parsed, &expected_size);
+				CU_ASSERT_EQUAL(size, expected_size);
+				CU_ASSERT_EQUAL(memcmp(g, expected, size), 0);
+				lwgeom_free(parsed);
+				lwfree(expected);
+				lwfree(g);
+			}
+			lwfree(wkb);
+		}
+		lwgeom_free(lwgeom);
+	}
+
+	/* Input the parser checks would reject, or truncated, is left to the parser */
+	{
+		LWGEOM *lwgeom = lwgeom_from_wkt("POLYGON((0 0,10 0,10 10,0 10))", LW_PARSER_CHECK_NONE);
+		lwvarlena_t *wkb = lwgeom_to_wkb_varlena(lwgeom, WKB_NDR | WKB_EXTENDED);
+		size_t wkb_size = LWSIZE_GET(wkb->size) - LWVARHDRSZ;
+		GSERIALIZED *g;
+
+		CU_ASSERT_PTR_NULL(gserialized_from_wkb((uint8_t *)wkb->data, wkb_size, LW_PARSER_CHECK_ALL, NULL));
+		CU_ASSERT_PTR_NULL(gserialized_from_wkb((uint8_t *)wkb->data, wkb_size - 1, LW_PARSER_CHECK_NONE, NULL));
+		g = gserialized_from_wkb((uint8_t *)wkb->data, wkb_size, LW_PARSER_CHECK_NONE, NULL);
+		CU_ASSERT_PTR_NOT_NULL(g);
+		lwfree(g);
+		lwfree(wkb);
+		lwgeom_free(lwgeom);
+	}
+}
+
 /*
 ** Used by test harness to register the tests in this file.
 */
@@ -820,4 +964,6 @@ void gserialized2_suite_setup(void)
 	PG_ADD_TEST(suite, test_gserialized2_malformed_declared_size);
 	PG_ADD_TEST(suite, test_gserialized2_malformed_short_allocation);
 	PG_ADD_TEST(suite, test_gserialized2_wkb_roundtrip_float_rounded_box);
+	PG_ADD_TEST(suite, test_gserialized2_cursor);
+	PG_ADD_TEST(suite, test_gserialized2_from_wkb);
 }
@@ -406,6 +406,40 @@ static void test_wkt_double(void)
 	lwgeom_parser_result_free(&p);
 }
 
+static void test_wkt_double_rounding(void)
+{
+	/* Ordinates must come out as strtod reads them, whichever path parses them */
+	const char *ordinates[] = {
+		"0.1", "-0", "1e22", "1e23", "123.456789012345", "-.5", "7.", "5e-324",
+		"9007199254740993", "0.30000000000000004", "12345678901234567890",
+		"2.2250738585072011e-308", "179.99999999999997", "1.7976931348623157e308"
+	};
+	uint32_t i;
+
+	for (i = 0; i < sizeof(ordinates) / sizeof(char *); i++)
+	{
+		char wkt[128];
+		LWGEOM_PARSER_RESULT p;
+		const POINT2D *pt;
+		double expected = strtod(ordinates[i], NULL);
+
+		snprintf(wkt, sizeof(wkt), "POINT(%s %s)", ordinates[i], ordinates[i]);
+		lwgeom_parser_result_init(&p);
+		CU_ASSERT_EQUAL_FATAL(lwgeom_parse_wkt(&p, wkt, LW_PARSER_CHECK_ALL), LW_SUCCESS);
+		pt = getPoint2d_cp(lwgeom_as_lwpoint(p.geom)->point, 0);
+		CU_ASSERT_EQUAL(memcmp(&pt->x, &expected, sizeof(double)), 0);
+		CU_ASSERT_EQUAL(memcmp(&pt->y, &expected, sizeof(double)), 0);
+		lwgeom_parser_result_free(&p);
+	}
+
+	/* The lexer takes no exponent after a bare decimal point */
+	{
+		char *err = cu_wkt_in("POINT(1.e5 2)", WKT_EXTENDED);
+		ASSERT_STRING_EQUAL(err, "parse error - invalid geometry");
+		lwfree(err);
+	}
+}
+
 static void test_wkt_leak(void)
 {
 	/* OSS-FUZZ: https://trac.osgeo.org/postgis/ticket/4537 */
@@ -444,5 +478,6 @@ void wkt_in_suite_setup(void)
 	PG_ADD_TEST(suite, test_wkt_in_polyhedralsurface);
 	PG_ADD_TEST(suite, test_wkt_in_errlocation);
 	PG_ADD_TEST(suite, test_wkt_double);
+	PG_ADD_TEST(suite, test_wkt_double_rounding);
 	PG_ADD_TEST(suite, test_wkt_leak);
 }
@@ -14,6 +14,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "CUnit/Basic.h"
 
 #include "liblwgeom_internal.h"
@@ -508,6 +509,11 @@ static int tree_inter(const char *wkt1, const char *wkt2)
 	RECT_NODE *t1 = rect_tree_from_lwgeom(g1);
 	RECT_NODE *t2 = rect_tree_from_lwgeom(g2);
 	int result = rect_tree_intersects_tree(t1, t2);
+	/* Packed trees must agree with the pointer trees */
+	t1 = rect_tree_pack(t1);
+	t2 = rect_tree_pack(t2);
+	CU_ASSERT_EQUAL(rect_tree_intersects_tree(t1, t2), result);
+	CU_ASSERT_EQUAL(rect_tree_intersects_tree(t2, t1), result);
 	rect_tree_free(t1);
 	rect_tree_free(t2);
 	lwgeom_free(g1);
@@ -591,6 +597,13 @@ test_rect_tree_distance_tree_case(const char *wkt1, const char *wkt2)
 
 	double dist = rect_tree_distance_tree(n1, n2, 0.0);
 	// printf("%g\n", dist);
+
+	/* Packed trees must agree with the pointer trees */
+	n1 = rect_tree_pack(n1);
+	n2 = rect_tree_pack(n2);
+	CU_ASSERT_EQUAL(rect_tree_distance_tree(n1, n2, 0.0), dist);
+	CU_ASSERT_EQUAL(rect_tree_distance_tree(n2, n1, 0.0), dist);
+
 	rect_tree_free(n1);
 	rect_tree_free(n2);
 	lwgeom_free(lw1);
@@ -660,6 +673,81 @@ test_rect_tree_distance_tree(void)
 	TDT(wkt, "POLYGON((5 5,5 5.5,5.5 5.5,5.5 5, 5 5))", 0.5);
 }
 
+/*
+* Compare pointer and packed trees on a large "coastline" polygon
+* queried repeatedly, as happens with a cached tree. Timings are
+* only printed when PGIS_CU_BENCHMARK is set in the environment.
+*/
+static void
+test_rect_tree_pack_benchmark(void)
+{
+	const uint32_t npoints = 20000;
+	const int nqueries = 200;
+	POINTARRAY **rings = lwalloc(sizeof(POINTARRAY*));
+	POINTARRAY *pa = ptarray_construct_empty(0, 0, npoints + 1);
+	LWGEOM *poly, *line;
+	RECT_NODE *tree, *packed;
+	clock_t t_tree = 0, t_packed = 0, t;
+	uint32_t i;
+	int q;
+
+	/* Jagged star shape, so edges at all angles and scales */
+	for (i = 0; i < npoints; i++)
+	{
+		double a = 2 * M_PI * i / npoints;
+		double r = 100.0 + 10.0 * sin(37 * a) + ((i % 7) * 0.3);
+		POINT4D p = {r * cos(a), r * sin(a), 0, 0};
+		ptarray_append_point(pa, &p, LW_TRUE);
+	}
+	ptarray_append_point(pa, getPoint4d_cp(pa, 0), LW_TRUE);
+	rings[0] = pa;
+	poly = (LWGEOM*)lwpoly_construct(0, NULL, 1, rings);
+
+	tree = rect_tree_from_lwgeom(poly);
+	packed = rect_tree_pack(rect_tree_from_lwgeom(poly));
+
+	for (q = 0; q < nqueries; q++)
+	{
+		double a = 2 * M_PI * q / nqueries;
+		double r = 80.0 + (q % 40);
+		double d1, d2;
+		int i1, i2;
+		RECT_NODE *n;
+		char wkt[256];
+
+		snprintf(wkt, sizeof(wkt), "LINESTRING(%g %g,%g %g)",
+			r * cos(a), r * sin(a), (r + 5) * cos(a + 0.01), (r + 5) * sin(a + 0.01));
+		line = lwgeom_from_wkt(wkt, LW_PARSER_CHECK_NONE);
+		n = rect_tree_from_lwgeom(line);
+
+		t = clock();
+		d1 = rect_tree_distance_tree(n, tree, 0.0);
+		i1 = rect_tree_intersects_tree(n, tree);
+		t_tree += clock() - t;
+
+		t = clock();
+		d2 = rect_tree_distance_tree(n, packed, 0.0);
+		i2 = rect_tree_intersects_tree(n, packed);
+		t_packed += clock() - t;
+
+		CU_ASSERT_EQUAL(d1, d2);
+		CU_ASSERT_EQUAL(i1, i2);
+
+		rect_tree_free(n);
+		lwgeom_free(line);
+	}
+
+	if (getenv("PGIS_CU_BENCHMARK"))
+	{
+		printf("\n  rect_tree pointer: %.3fs, packed: %.3fs\n",
+			(double)t_tree / CLOCKS_PER_SEC,
+			(double)t_packed / CLOCKS_PER_SEC);
+	}
+
+	rect_tree_free(tree);
+	rect_tree_free(packed);
+	lwgeom_free(poly);
+}
 
 static void
 test_lwgeom_segmentize2d(void)
@@ -1611,4 +1699,5 @@ void measures_suite_setup(void)
 	PG_ADD_TEST(suite, test_lwgeom_tcpa);
 	PG_ADD_TEST(suite, test_lwgeom_is_trajectory);
 	PG_ADD_TEST(suite, test_rect_tree_distance_tree);
+	PG_ADD_TEST(suite, test_rect_tree_pack_benchmark);
 }
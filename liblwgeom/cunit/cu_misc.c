@@ -347,6 +347,40 @@ static void test_stringlist(void)
 }
 
 
+static const void *test_arena_mem = NULL;
+
+static int test_arena_owner(const void *mem)
+{
+	return mem == test_arena_mem;
+}
+
+static void test_arena(void)
+{
+	const char *wkt = "MULTIPOLYGON(((0 0,10 0,10 10,0 10,0 0),(1 1,2 1,2 2,1 1)),((20 20,30 20,30 30,20 20)))";
+	LWGEOM *geom = lwgeom_from_wkt(wkt, LW_PARSER_CHECK_NONE);
+	LWGEOM *other = lwgeom_from_wkt(wkt, LW_PARSER_CHECK_NONE);
+
+	/* Without an owner nothing is arena memory */
+	CU_ASSERT(!lwgeom_arena_owns(geom));
+
+	lwgeom_set_arena_owner(test_arena_owner);
+	test_arena_mem = geom;
+	CU_ASSERT(lwgeom_arena_owns(geom));
+	CU_ASSERT(!lwgeom_arena_owns(other));
+	CU_ASSERT(!lwgeom_arena_owns(NULL));
+
+	/* Freeing an owned geometry is left to the arena */
+	lwgeom_free(geom);
+	lwgeom_free(other);
+
+	/* Once the owner is gone the geometry is freed for real */
+	lwgeom_set_arena_owner(NULL);
+	test_arena_mem = NULL;
+	CU_ASSERT(!lwgeom_arena_owns(geom));
+	lwgeom_free(geom);
+}
+
+
 /*
 ** Used by the test harness to register the tests in this file.
 */
@@ -366,4 +400,5 @@ void misc_suite_setup(void)
 	PG_ADD_TEST(suite, test_gbox_serialized_size);
 	PG_ADD_TEST(suite, test_optionlist);
 	PG_ADD_TEST(suite, test_stringlist);
+	PG_ADD_TEST(suite, test_arena);
 }
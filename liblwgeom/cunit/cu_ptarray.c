@@ -16,6 +16,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
 #include "CUnit/Basic.h"
 #include "CUnit/CUnit.h"
 
@@ -1008,6 +1009,137 @@ static void test_ptarray_closest_point_on_segment(void)
 }
 
 
+/*
+* Scalar references for the bounding box and length kernels, written as
+* the loops were before they were vectorized.
+*/
+static void
+ptarray_kernels_gbox_ref(const POINTARRAY *pa, GBOX *gbox)
+{
+	POINT4D p;
+	getPoint4d_p(pa, 0, &p);
+	gbox->xmin = gbox->xmax = p.x;
+	gbox->ymin = gbox->ymax = p.y;
+	gbox->zmin = gbox->zmax = p.z;
+	gbox->mmin = gbox->mmax = p.m;
+	for (uint32_t i = 1; i < pa->npoints; i++)
+	{
+		getPoint4d_p(pa, i, &p);
+		gbox->xmin = FP_MIN(gbox->xmin, p.x);
+		gbox->xmax = FP_MAX(gbox->xmax, p.x);
+		gbox->ymin = FP_MIN(gbox->ymin, p.y);
+		gbox->ymax = FP_MAX(gbox->ymax, p.y);
+		gbox->zmin = FP_MIN(gbox->zmin, p.z);
+		gbox->zmax = FP_MAX(gbox->zmax, p.z);
+		gbox->mmin = FP_MIN(gbox->mmin, p.m);
+		gbox->mmax = FP_MAX(gbox->mmax, p.m);
+	}
+}
+
+static double
+ptarray_kernels_length_ref(const POINTARRAY *pa)
+{
+	double dist = 0.0;
+	for (uint32_t i = 1; i < pa->npoints; i++)
+	{
+		const POINT2D *frm = getPoint2d_cp(pa, i - 1);
+		const POINT2D *to = getPoint2d_cp(pa, i);
+		dist += sqrt(((frm->x - to->x) * (frm->x - to->x)) + ((frm->y - to->y) * (frm->y - to->y)));
+	}
+	return dist;
+}
+
+/*
+* Check the bounding box and length kernels give bit-identical results to
+* the scalar loops for every layout and for odd and even point counts.
+* The kernels are only timed, on larger arrays, when PGIS_CU_BENCHMARK is
+* set in the environment, as "make benchmark" does.
+*/
+static void
+test_ptarray_kernels_benchmark(void)
+{
+	const int benchmark = getenv("PGIS_CU_BENCHMARK") != NULL;
+	const uint32_t npoints = benchmark ? 100001 : 1001;
+	const int iterations = 200;
+	int dims;
+
+	for (dims = 0; dims < 4; dims++)
+	{
+		int hasz = dims == 1 || dims == 3;
+		int hasm = dims >= 2;
+		POINTARRAY *pa = ptarray_construct(hasz, hasm, npoints);
+		clock_t t_gbox = 0, t_gbox_ref = 0, t_len = 0, t_len_ref = 0, t;
+		GBOX box, ref;
+		double len = 0.0, len_ref = 0.0;
+		uint32_t n;
+		int it;
+
+		for (uint32_t i = 0; i < npoints; i++)
+		{
+			double a = 2 * M_PI * i / npoints;
+			double r = 1000.0 + 100.0 * sin(37 * a) + ((i % 7) * 0.3);
+			POINT4D p = {r * cos(a), r * sin(a), (i % 13) * 0.1 - r, (i % 11) * 0.7 + r};
+			ptarray_set_point4d(pa, i, &p);
+		}
+
+		/* Odd and even point counts exercise the scalar tail of the length kernel */
+		for (n = npoints - 1; n <= npoints; n++)
+		{
+			pa->npoints = n;
+			ptarray_calculate_gbox_cartesian(pa, &box);
+			ptarray_kernels_gbox_ref(pa, &ref);
+			CU_ASSERT_EQUAL(box.xmin, ref.xmin);
+			CU_ASSERT_EQUAL(box.xmax, ref.xmax);
+			CU_ASSERT_EQUAL(box.ymin, ref.ymin);
+			CU_ASSERT_EQUAL(box.ymax, ref.ymax);
+			if (hasz)
+			{
+				CU_ASSERT_EQUAL(box.zmin, ref.zmin);
+				CU_ASSERT_EQUAL(box.zmax, ref.zmax);
+			}
+			if (hasm)
+			{
+				CU_ASSERT_EQUAL(box.mmin, ref.mmin);
+				CU_ASSERT_EQUAL(box.mmax, ref.mmax);
+			}
+			CU_ASSERT_EQUAL(ptarray_length_2d(pa), ptarray_kernels_length_ref(pa));
+		}
+
+		for (it = 0; benchmark && it < iterations; it++)
+		{
+			t = clock();
+			ptarray_calculate_gbox_cartesian(pa, &box);
+			t_gbox += clock() - t;
+
+			t = clock();
+			ptarray_kernels_gbox_ref(pa, &ref);
+			t_gbox_ref += clock() - t;
+
+			t = clock();
+			len += ptarray_length_2d(pa);
+			t_len += clock() - t;
+
+			t = clock();
+			len_ref += ptarray_kernels_length_ref(pa);
+			t_len_ref += clock() - t;
+		}
+		CU_ASSERT_EQUAL(len, len_ref);
+
+		if (benchmark)
+		{
+			printf("%s  %s gbox: %.3fs, reference: %.3fs; length: %.3fs, reference: %.3fs\n",
+				dims ? "" : "\n",
+				hasz ? (hasm ? "XYZM" : "XYZ") : (hasm ? "XYM" : "XY"),
+				(double)t_gbox / CLOCKS_PER_SEC,
+				(double)t_gbox_ref / CLOCKS_PER_SEC,
+				(double)t_len / CLOCKS_PER_SEC,
+				(double)t_len_ref / CLOCKS_PER_SEC);
+		}
+
+		ptarray_free(pa);
+	}
+}
+
 /*
 ** Used by the test harness to register the tests in this file.
 */
@@ -1028,4 +1160,5 @@ void ptarray_suite_setup(void)
 	PG_ADD_TEST(suite, test_ptarray_closest_vertex_2d);
 	PG_ADD_TEST(suite, test_ptarray_closest_segment_2d);
 	PG_ADD_TEST(suite, test_ptarray_closest_point_on_segment);
+	PG_ADD_TEST(suite, test_ptarray_kernels_benchmark);
 }
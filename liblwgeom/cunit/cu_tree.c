@@ -173,6 +173,35 @@ static void test_tree_circ_pip2(void)
 }
 
 
+static void test_tree_circ_edges_within(void)
+{
+	LWGEOM* g = lwgeom_from_wkt("POLYGON((0 0,0 1,1 1,1 0,0 0))", LW_PARSER_CHECK_NONE);
+	CIRC_NODE* c = lwgeom_calculate_circ_tree(g);
+	double tolerance = deg2rad(0.01);
+	GEOGRAPHIC_POINT gpt;
+
+	/* Deep inside is far from every edge, even though it is in the polygon */
+	geographic_point_init(0.5, 0.5, &gpt);
+	CU_ASSERT_FALSE(circ_tree_edges_within(c, &gpt, tolerance));
+
+	/* Near an edge, inside or outside */
+	geographic_point_init(0.5, 0.995, &gpt);
+	CU_ASSERT_TRUE(circ_tree_edges_within(c, &gpt, tolerance));
+	geographic_point_init(1.005, 0.5, &gpt);
+	CU_ASSERT_TRUE(circ_tree_edges_within(c, &gpt, tolerance));
+
+	/* On a vertex */
+	geographic_point_init(0, 0, &gpt);
+	CU_ASSERT_TRUE(circ_tree_edges_within(c, &gpt, 0));
+
+	/* Well outside */
+	geographic_point_init(2, 2, &gpt);
+	CU_ASSERT_FALSE(circ_tree_edges_within(c, &gpt, tolerance));
+
+	circ_tree_free(c);
+	lwgeom_free(g);
+}
+
 static void test_tree_circ_distance(void)
 {
 	LWGEOM *lwg1, *lwg2;
@@ -530,6 +559,54 @@ static void test_itree_hole_spike(void)
 	test_itree_once(wktPoly, 11, 2.0, ITREE_OUTSIDE);
 }
 
+static void test_itree_batch(void)
+{
+	/* Shell with a spike and a hole, and a second polygon inside the hole */
+	const char *wktPoly =
+		"MULTIPOLYGON("
+		"((-10 -10, 6 -10, 7 -10, 7.5 2, 8 -10, 9 -10, 10 -10, 10 10, -10 10, -10 2, -10 2, -10 -10),"
+		"(-5 -5, -5 5, 5 5, 5 -5, -5 -5)),"
+		"((-2 -2, 2 -2, 2 2, -2 2, -2 -2)),"
+		"EMPTY)";
+	LWGEOM *poly = lwgeom_from_wkt(wktPoly, LW_PARSER_CHECK_NONE);
+	IntervalTree *itree = itree_from_lwgeom(poly);
+	uint32_t npts = 0, nfail = 0, ninside = 0;
+	POINT2D pts[50 * 50 + 1];
+	IntervalTreeResult results[50 * 50 + 1];
+
+	/* Half unit grid, hitting plenty of edges and vertices */
+	for (int i = 0; i < 50; i++)
+	{
+		for (int j = 0; j < 50; j++)
+		{
+			pts[npts].x = -12.0 + 0.5 * ((i * 7 + j * 3) % 50);
+			pts[npts].y = -12.0 + 0.5 * j;
+			npts++;
+		}
+	}
+	pts[npts].x = NAN;
+	pts[npts].y = 0.0;
+	npts++;
+
+	itree_points_in_multipolygon(itree, pts, npts, results);
+
+	for (uint32_t i = 0; i < npts; i++)
+	{
+		LWPOINT *pt = lwpoint_make2d(SRID_DEFAULT, pts[i].x, pts[i].y);
+		if (results[i] != itree_point_in_multipolygon(itree, pt))
+			nfail++;
+		if (results[i] == ITREE_INSIDE)
+			ninside++;
+		lwpoint_free(pt);
+	}
+	CU_ASSERT_EQUAL(nfail, 0);
+	CU_ASSERT(ninside > 0);
+	CU_ASSERT_EQUAL(results[npts - 1], ITREE_OUTSIDE);
+
+	itree_free(itree);
+	lwgeom_free(poly);
+}
+
 static void test_itree_multipoly_empty(void)
 {
 
@@ -623,6 +700,60 @@ static void test_itree_degenerate_poly(void)
 }
 
 
+static void test_tree_circ_pack(void)
+{
+	LWGEOM *lwg1, *lwg2, *lwg3;
+	CIRC_NODE *c1, *c2, *c3, *u1, *u3;
+	CIRC_TREE_PACKED *p1, *p3;
+	POINT2D pt, pt_outside;
+	SPHEROID s;
+	double d1, d2;
+	int on_boundary;
+
+	spheroid_init(&s, 1.0, 1.0);
+
+	lwg1 = lwgeom_from_wkt("MULTIPOLYGON(((0 0,0 10,10 10,10 0,0 0),(2 2,2 4,4 4,4 2,2 2)),((20 20,20 25,25 25,20 20)))", LW_PARSER_CHECK_NONE);
+	lwg2 = lwgeom_from_wkt("LINESTRING(-5 -5,-3 -4,-6 -2,-1 -1)", LW_PARSER_CHECK_NONE);
+	lwg3 = lwgeom_from_wkt("POINT(15 15)", LW_PARSER_CHECK_NONE);
+	c1 = lwgeom_calculate_circ_tree(lwg1);
+	c2 = lwgeom_calculate_circ_tree(lwg2);
+	c3 = lwgeom_calculate_circ_tree(lwg3);
+
+	/* The packed trees no longer need the geometries they came from */
+	p1 = circ_tree_pack(c1);
+	p3 = circ_tree_pack(c3);
+	CU_ASSERT_EQUAL(p3->num_nodes, 1);
+	CU_ASSERT_EQUAL(p3->num_points, 1);
+	d1 = circ_tree_distance_tree(c1, c2, &s, 0.0);
+	d2 = circ_tree_distance_tree(c3, c2, &s, 0.0);
+	circ_tree_free(c1);
+	circ_tree_free(c3);
+	lwgeom_free(lwg1);
+	lwgeom_free(lwg3);
+
+	u1 = circ_tree_unpack(p1);
+	u3 = circ_tree_unpack(p3);
+	CU_ASSERT_EQUAL(u1->geom_type, MULTIPOLYGONTYPE);
+	CU_ASSERT_EQUAL(u3->p1, u3->p2);
+	CU_ASSERT_DOUBLE_EQUAL(circ_tree_distance_tree(u1, c2, &s, 0.0), d1, 0.00000001);
+	CU_ASSERT_DOUBLE_EQUAL(circ_tree_distance_tree(u3, c2, &s, 0.0), d2, 0.00000001);
+
+	/* Point in the hole and point in the shell */
+	pt_outside.x = -1.0;
+	pt_outside.y = 15.0;
+	pt.x = 3.0;
+	pt.y = 3.0;
+	CU_ASSERT_EQUAL(circ_tree_contains_point(u1, &pt, &pt_outside, 0, &on_boundary), LW_FALSE);
+	pt.x = 7.0;
+	pt.y = 7.0;
+	CU_ASSERT_EQUAL(circ_tree_contains_point(u1, &pt, &pt_outside, 0, &on_boundary), LW_TRUE);
+
+	lwfree(p1);
+	lwfree(p3);
+	circ_tree_free(c2);
+	lwgeom_free(lwg2);
+}
+
 static void test_geography_tree_closestpoint(void)
 {
 	LWGEOM *lwg1, *lwg2, *lwg3;
@@ -656,10 +787,13 @@ void tree_suite_setup(void)
 	PG_ADD_TEST(suite, test_itree_hole_spike);
 	PG_ADD_TEST(suite, test_itree_multipoly_empty);
 	PG_ADD_TEST(suite, test_itree_degenerate_poly);
+	PG_ADD_TEST(suite, test_itree_batch);
 	PG_ADD_TEST(suite, test_tree_circ_create);
 	PG_ADD_TEST(suite, test_tree_circ_pip);
 	PG_ADD_TEST(suite, test_tree_circ_pip2);
+	PG_ADD_TEST(suite, test_tree_circ_edges_within);
 	PG_ADD_TEST(suite, test_tree_circ_distance);
 	PG_ADD_TEST(suite, test_tree_circ_distance_threshold);
+	PG_ADD_TEST(suite, test_tree_circ_pack);
 	PG_ADD_TEST(suite, test_geography_tree_closestpoint);
 }
@@ -29,6 +29,10 @@
 #include <stdlib.h>
 #include <math.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 typedef struct {
 	double x;
 	double y;
@@ -553,11 +557,33 @@ static int lw_arc_calculate_gbox_cartesian(const POINT4D *p1, const POINT4D *p2,
 	return rv;
 }
 
+/*
+ * The SSE2 kernels keep X and Y (and Z and M) side by side in one register,
+ * as they are laid out in the point. _mm_min_pd(a, b) and _mm_max_pd(a, b)
+ * return b unless a compares less (greater), exactly like FP_MIN(a, b) and
+ * FP_MAX(a, b), and the points are still visited in order, so the box is
+ * bit-identical to the scalar loop's, NaN handling included.
+ */
 static void
 ptarray_calculate_gbox_cartesian_2d(const POINTARRAY *pa, GBOX *gbox)
 {
 	const POINT2D *p = getPoint2d_cp(pa, 0);
 
+#if defined(__SSE2__)
+	__m128d xymin = _mm_loadu_pd((const double *)p);
+	__m128d xymax = xymin;
+
+	for (uint32_t i = 1; i < pa->npoints; i++)
+	{
+		__m128d xy = _mm_loadu_pd((const double *)getPoint2d_cp(pa, i));
+		xymin = _mm_min_pd(xymin, xy);
+		xymax = _mm_max_pd(xymax, xy);
+	}
+	gbox->xmin = _mm_cvtsd_f64(xymin);
+	gbox->ymin = _mm_cvtsd_f64(_mm_unpackhi_pd(xymin, xymin));
+	gbox->xmax = _mm_cvtsd_f64(xymax);
+	gbox->ymax = _mm_cvtsd_f64(_mm_unpackhi_pd(xymax, xymax));
+#else
 	gbox->xmax = gbox->xmin = p->x;
 	gbox->ymax = gbox->ymin = p->y;
 
@@ -569,6 +595,7 @@ ptarray_calculate_gbox_cartesian_2d(const POINTARRAY *pa, GBOX *gbox)
 		gbox->ymin = FP_MIN(gbox->ymin, p->y);
 		gbox->ymax = FP_MAX(gbox->ymax, p->y);
 	}
+#endif
 }
 
 /* Works with X/Y/Z. Needs to be adjusted after if X/Y/M was required */
@@ -577,6 +604,26 @@ ptarray_calculate_gbox_cartesian_3d(const POINTARRAY *pa, GBOX *gbox)
 {
 	const POINT3D *p = getPoint3d_cp(pa, 0);
 
+#if defined(__SSE2__)
+	__m128d xymin = _mm_loadu_pd((const double *)p);
+	__m128d xymax = xymin;
+
+	gbox->zmax = gbox->zmin = p->z;
+
+	for (uint32_t i = 1; i < pa->npoints; i++)
+	{
+		p = getPoint3d_cp(pa, i);
+		__m128d xy = _mm_loadu_pd((const double *)p);
+		xymin = _mm_min_pd(xymin, xy);
+		xymax = _mm_max_pd(xymax, xy);
+		gbox->zmin = FP_MIN(gbox->zmin, p->z);
+		gbox->zmax = FP_MAX(gbox->zmax, p->z);
+	}
+	gbox->xmin = _mm_cvtsd_f64(xymin);
+	gbox->ymin = _mm_cvtsd_f64(_mm_unpackhi_pd(xymin, xymin));
+	gbox->xmax = _mm_cvtsd_f64(xymax);
+	gbox->ymax = _mm_cvtsd_f64(_mm_unpackhi_pd(xymax, xymax));
+#else
 	gbox->xmax = gbox->xmin = p->x;
 	gbox->ymax = gbox->ymin = p->y;
 	gbox->zmax = gbox->zmin = p->z;
@@ -591,6 +638,7 @@ ptarray_calculate_gbox_cartesian_3d(const POINTARRAY *pa, GBOX *gbox)
 		gbox->zmin = FP_MIN(gbox->zmin, p->z);
 		gbox->zmax = FP_MAX(gbox->zmax, p->z);
 	}
+#endif
 }
 
 static void
@@ -598,6 +646,31 @@ ptarray_calculate_gbox_cartesian_4d(const POINTARRAY *pa, GBOX *gbox)
 {
 	const POINT4D *p = getPoint4d_cp(pa, 0);
 
+#if defined(__SSE2__)
+	__m128d xymin = _mm_loadu_pd(&p->x);
+	__m128d xymax = xymin;
+	__m128d zmmin = _mm_loadu_pd(&p->z);
+	__m128d zmmax = zmmin;
+
+	for (uint32_t i = 1; i < pa->npoints; i++)
+	{
+		p = getPoint4d_cp(pa, i);
+		__m128d xy = _mm_loadu_pd(&p->x);
+		__m128d zm = _mm_loadu_pd(&p->z);
+		xymin = _mm_min_pd(xymin, xy);
+		xymax = _mm_max_pd(xymax, xy);
+		zmmin = _mm_min_pd(zmmin, zm);
+		zmmax = _mm_max_pd(zmmax, zm);
+	}
+	gbox->xmin = _mm_cvtsd_f64(xymin);
+	gbox->ymin = _mm_cvtsd_f64(_mm_unpackhi_pd(xymin, xymin));
+	gbox->xmax = _mm_cvtsd_f64(xymax);
+	gbox->ymax = _mm_cvtsd_f64(_mm_unpackhi_pd(xymax, xymax));
+	gbox->zmin = _mm_cvtsd_f64(zmmin);
+	gbox->mmin = _mm_cvtsd_f64(_mm_unpackhi_pd(zmmin, zmmin));
+	gbox->zmax = _mm_cvtsd_f64(zmmax);
+	gbox->mmax = _mm_cvtsd_f64(_mm_unpackhi_pd(zmmax, zmmax));
+#else
 	gbox->xmax = gbox->xmin = p->x;
 	gbox->ymax = gbox->ymin = p->y;
 	gbox->zmax = gbox->zmin = p->z;
@@ -615,6 +688,7 @@ ptarray_calculate_gbox_cartesian_4d(const POINTARRAY *pa, GBOX *gbox)
 		gbox->mmin = FP_MIN(gbox->mmin, p->m);
 		gbox->mmax = FP_MAX(gbox->mmax, p->m);
 	}
+#endif
 }
 
 int
@@ -253,6 +253,15 @@ GSERIALIZED* gserialized_from_lwgeom(LWGEOM *geom, size_t *size)
 	return gserialized2_from_lwgeom(geom, size);
 }
 
+/**
+* Allocate a new #GSERIALIZED straight from WKB, or NULL if the WKB
+* has to go through lwgeom_from_wkb().
+*/
+GSERIALIZED* gserialized_from_wkb(const uint8_t *wkb, size_t wkb_size, char check, size_t *size)
+{
+	return gserialized2_from_wkb(wkb, wkb_size, check, size);
+}
+
 /**
 * Return the memory size a GSERIALIZED will occupy for a given LWGEOM.
 */
@@ -291,6 +300,22 @@ gserialized_peek_first_point(const GSERIALIZED *g, POINT4D *out_point)
 		return gserialized1_peek_first_point(g, out_point);
 }
 
+int
+gserialized_cursor_init(GSERIALIZED_CURSOR *cursor, const GSERIALIZED *g)
+{
+	/* Version 1 serializations are read through an LWGEOM */
+	if (GFLAGS_GET_VERSION(g->gflags))
+		return gserialized2_cursor_init(cursor, g);
+	else
+		return LW_FAILURE;
+}
+
+int
+gserialized_cursor_next(GSERIALIZED_CURSOR *cursor)
+{
+	return gserialized2_cursor_next(cursor);
+}
+
 /**
 * Return -1 if g1 is "less than" g2, 1 if g1 is "greater than"
 * g2 and 0 if g1 and g2 are the "same". Equality is evaluated
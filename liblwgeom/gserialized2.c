@@ -47,6 +47,7 @@
 #include "lwgeodetic.h"
 #include "gserialized2.h"
 
+#include <limits.h>
 #include <stddef.h>
 #if defined(__has_feature)
 #if __has_feature(address_sanitizer)
@@ -1000,6 +1001,128 @@ gserialized2_peek_first_point(const GSERIALIZED *g, POINT4D *out_point)
 	return LW_SUCCESS;
 }
 
+int
+gserialized2_cursor_init(GSERIALIZED_CURSOR *cursor, const GSERIALIZED *g)
+{
+	uint8_t *data_ptr = NULL;
+	lwflags_t flags = gserialized2_get_lwflags(g);
+	size_t size = 0;
+
+	if (gserialized2_payload_bounds(g, &data_ptr, NULL) == LW_FAILURE)
+		return LW_FAILURE;
+	/* Check the layout once, so the walk itself can trust it */
+	if (gserialized2_validate_geometry_buffer(data_ptr, (uint8_t *)g + gserialized2_buffer_size(g), flags, &size) ==
+	    LW_FAILURE)
+		return LW_FAILURE;
+
+	memset(cursor, 0, sizeof(GSERIALIZED_CURSOR));
+	cursor->pa.flags = lwflags(FLAGS_GET_Z(flags), FLAGS_GET_M(flags), 0);
+	FLAGS_SET_READONLY(cursor->pa.flags, 1);
+	cursor->ptr = data_ptr;
+	cursor->end = data_ptr + size;
+	return LW_SUCCESS;
+}
+
+static inline void
+gserialized2_cursor_set_pa(GSERIALIZED_CURSOR *cursor, const uint8_t *points, uint32_t npoints)
+{
+	cursor->pa.npoints = cursor->pa.maxpoints = npoints;
+	cursor->pa.serialized_pointlist = (uint8_t *)points;
+	cursor->ptr = points + npoints * ptarray_point_size(&cursor->pa);
+}
+
+int
+gserialized2_cursor_next(GSERIALIZED_CURSOR *cursor)
+{
+	/* The rest of the rings of a polygon follow on from the last one */
+	if (cursor->ring + 1 < cursor->nrings)
+	{
+		cursor->ring++;
+		gserialized2_cursor_set_pa(
+		    cursor, cursor->ptr, gserialized2_get_uint32_t(cursor->ring_counts + cursor->ring * sizeof(uint32_t)));
+		return LW_TRUE;
+	}
+	cursor->ring = cursor->nrings = 0;
+
+	while (cursor->ptr < cursor->end)
+	{
+		uint32_t type = gserialized2_get_uint32_t(cursor->ptr);
+		uint32_t count = gserialized2_get_uint32_t(cursor->ptr + sizeof(uint32_t));
+		const uint8_t *data_ptr = cursor->ptr + 2 * sizeof(uint32_t);
+
+		switch (type)
+		{
+		case POINTTYPE:
+		case LINETYPE:
+		case CIRCSTRINGTYPE:
+		case TRIANGLETYPE:
+			cursor->type = type;
+			gserialized2_cursor_set_pa(cursor, data_ptr, count);
+			return LW_TRUE;
+
+		case POLYGONTYPE:
+			if (count == 0)
+			{
+				cursor->ptr = data_ptr;
+				continue;
+			}
+			cursor->type = type;
+			cursor->ring_counts = data_ptr;
+			cursor->nrings = count;
+			/* Ring point counts are padded to a double boundary */
+			data_ptr += (count + count % 2) * sizeof(uint32_t);
+			gserialized2_cursor_set_pa(cursor, data_ptr, gserialized2_get_uint32_t(cursor->ring_counts));
+			return LW_TRUE;
+
+		case NURBSCURVETYPE: {
+			/* Control points follow the header, weights and knots */
+			uint32_t nweights = gserialized2_get_uint32_t(cursor->ptr + 3 * sizeof(uint32_t));
+			uint32_t nknots = gserialized2_get_uint32_t(cursor->ptr + 4 * sizeof(uint32_t));
+			cursor->type = type;
+			data_ptr = cursor->ptr + 6 * sizeof(uint32_t) + ((size_t)nweights + nknots) * sizeof(double);
+			gserialized2_cursor_set_pa(cursor, data_ptr, count);
+			return LW_TRUE;
+		}
+
+		default:
+			/* Collections: their members follow the header directly */
+			cursor->ptr = data_ptr;
+			continue;
+		}
+	}
+	return LW_FALSE;
+}
+
+/*
+* Calculate the cartesian box of a linear geometry straight off the
+* serialization. Curves need their arcs, so they fail like empties do.
+*/
+static int
+gserialized2_cursor_gbox_p(const GSERIALIZED *g, GBOX *gbox)
+{
+	GSERIALIZED_CURSOR cursor;
+	GBOX tmp;
+	int first = LW_TRUE;
+
+	if (gserialized2_is_geodetic(g) || gserialized2_cursor_init(&cursor, g) == LW_FAILURE)
+		return LW_FAILURE;
+
+	while (gserialized2_cursor_next(&cursor))
+	{
+		if (cursor.type == CIRCSTRINGTYPE || cursor.type == NURBSCURVETYPE)
+			return LW_FAILURE;
+		/* Holes are inside the shell */
+		if (cursor.ring > 0)
+			continue;
+		if (ptarray_calculate_gbox_cartesian(&cursor.pa, first ? gbox : &tmp) == LW_FAILURE)
+			continue;
+		if (!first)
+			gbox_merge(&tmp, gbox);
+		first = LW_FALSE;
+	}
+	return first ? LW_FAILURE : LW_SUCCESS;
+}
+
 /**
 * Read the bounding box off a serialization and calculate one if
 * it is not already there.
@@ -1017,6 +1140,12 @@ int gserialized2_get_gbox_p(const GSERIALIZED *g, GBOX *box)
 	{
 		return LW_SUCCESS;
 	}
+	/* Or walk the coordinates in place, for linear geometries */
+	else if (gserialized2_cursor_gbox_p(g, box) == LW_SUCCESS)
+	{
+		gbox_float_round(box);
+		return LW_SUCCESS;
+	}
 	/* Damn! Nothing for it but to create an lwgeom... */
 	/* See http://trac.osgeo.org/postgis/ticket/1023 */
 	else
@@ -1943,6 +2072,390 @@ GSERIALIZED* gserialized2_from_lwgeom(LWGEOM *geom, size_t *size)
 	return g;
 }
 
+/***********************************************************************
+* Serialize WKB directly into GSERIALIZED, without building an LWGEOM.
+*
+* Only the linear types in the native byte order are handled, and only
+* when the WKB parser would build them as-is: anything it would reject,
+* repair or need to swap makes gserialized2_from_wkb() return NULL and
+* the caller goes through lwgeom_from_wkb() instead.
+*/
+
+/* Same limits as the WKB parser */
+#define GSERIALIZED2_WKB_MAX_DEPTH 200
+#define GSERIALIZED2_WKB_MAX_POINTS (UINT_MAX / WKB_DOUBLE_SIZE / 4)
+
+typedef struct
+{
+	const uint8_t *pos;
+	const uint8_t *end;
+	char check;
+	uint8_t depth;
+	lwflags_t flags;    /* dimensionality of the outermost geometry */
+	int32_t srid;       /* SRID of the outermost geometry */
+	size_t size;        /* serialized size of the geometry body */
+	uint32_t ngeoms;    /* outermost collection size, for lwgeom_needs_bbox() */
+	uint32_t nvertices; /* vertex count, for lwgeom_needs_bbox() */
+} gserialized2_wkb_state;
+
+static inline uint32_t
+gserialized2_wkb_uint32(const uint8_t *ptr)
+{
+	uint32_t u;
+	memcpy(&u, ptr, sizeof(uint32_t));
+	return u;
+}
+
+/* Map a WKB type number to a linear lwtype, or 0 for everything else */
+static uint32_t
+gserialized2_wkb_type(uint32_t wkb_type, int *has_z, int *has_m, int *has_srid)
+{
+	uint32_t iso_type;
+
+	*has_z = (wkb_type & WKBZOFFSET) != 0;
+	*has_m = (wkb_type & WKBMOFFSET) != 0;
+	*has_srid = (wkb_type & WKBSRIDFLAG) != 0;
+
+	iso_type = wkb_type & 0x0FFFFFFF;
+	if (iso_type >= 4000)
+		return 0;
+	if (iso_type >= 3000)
+		*has_z = *has_m = LW_TRUE;
+	else if (iso_type >= 2000)
+		*has_m = LW_TRUE;
+	else if (iso_type >= 1000)
+		*has_z = LW_TRUE;
+
+	switch (iso_type % 1000)
+	{
+	case WKB_POINT_TYPE:
+		return POINTTYPE;
+	case WKB_LINESTRING_TYPE:
+		return LINETYPE;
+	case WKB_POLYGON_TYPE:
+		return POLYGONTYPE;
+	case WKB_MULTIPOINT_TYPE:
+		return MULTIPOINTTYPE;
+	case WKB_MULTILINESTRING_TYPE:
+		return MULTILINETYPE;
+	case WKB_MULTIPOLYGON_TYPE:
+		return MULTIPOLYGONTYPE;
+	case WKB_GEOMETRYCOLLECTION_TYPE:
+		return COLLECTIONTYPE;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * First pass: check that the WKB can be copied as-is and work out the
+ * serialized size. Returns LW_FAILURE for anything the fast path leaves
+ * to the WKB parser.
+ */
+static int
+gserialized2_wkb_scan(gserialized2_wkb_state *s, uint32_t parent_type, uint32_t *out_type, int *is_empty)
+{
+	int has_z, has_m, has_srid;
+	uint32_t type;
+	size_t ptsize;
+
+	if (!gserialized2_range_available(s->pos, s->end, 1 + WKB_INT_SIZE))
+		return LW_FAILURE;
+	if (*s->pos != (IS_BIG_ENDIAN ? 0 : 1))
+		return LW_FAILURE;
+	type = gserialized2_wkb_type(gserialized2_wkb_uint32(s->pos + 1), &has_z, &has_m, &has_srid);
+	s->pos += 1 + WKB_INT_SIZE;
+	if (!type)
+		return LW_FAILURE;
+
+	if (has_srid)
+	{
+		if (!gserialized2_range_available(s->pos, s->end, WKB_INT_SIZE))
+			return LW_FAILURE;
+		if (!parent_type)
+			s->srid = clamp_srid((int32_t)gserialized2_wkb_uint32(s->pos));
+		s->pos += WKB_INT_SIZE;
+	}
+
+	if (!parent_type)
+		s->flags = lwflags(has_z, has_m, 0);
+	else if (has_z != FLAGS_GET_Z(s->flags) || has_m != FLAGS_GET_M(s->flags))
+		return LW_FAILURE;
+	else if (!lwcollection_allows_subtype(parent_type, type))
+		return LW_FAILURE;
+
+	ptsize = sizeof(double) * FLAGS_NDIMS(s->flags);
+	*out_type = type;
+
+	switch (type)
+	{
+	case POINTTYPE:
+	{
+		double xy[2];
+		if (!gserialized2_range_available(s->pos, s->end, ptsize))
+			return LW_FAILURE;
+		memcpy(xy, s->pos, sizeof(xy));
+		s->pos += ptsize;
+		/* POINT(NaN NaN) is how WKB spells POINT EMPTY */
+		*is_empty = isnan(xy[0]) && isnan(xy[1]);
+		s->size += 2 * sizeof(uint32_t) + (*is_empty ? 0 : ptsize);
+		s->nvertices += *is_empty ? 0 : 1;
+		return LW_SUCCESS;
+	}
+	case LINETYPE:
+	{
+		uint32_t npoints;
+		if (!gserialized2_range_available(s->pos, s->end, WKB_INT_SIZE))
+			return LW_FAILURE;
+		npoints = gserialized2_wkb_uint32(s->pos);
+		s->pos += WKB_INT_SIZE;
+		if (npoints > GSERIALIZED2_WKB_MAX_POINTS ||
+		    !gserialized2_range_available(s->pos, s->end, npoints * ptsize))
+			return LW_FAILURE;
+		if (npoints && npoints < 2 && (s->check & LW_PARSER_CHECK_MINPOINTS))
+			return LW_FAILURE;
+		s->pos += npoints * ptsize;
+		*is_empty = npoints == 0;
+		s->size += 2 * sizeof(uint32_t) + npoints * ptsize;
+		s->nvertices += npoints;
+		return LW_SUCCESS;
+	}
+	case POLYGONTYPE:
+	{
+		uint32_t nrings;
+		if (!gserialized2_range_available(s->pos, s->end, WKB_INT_SIZE))
+			return LW_FAILURE;
+		nrings = gserialized2_wkb_uint32(s->pos);
+		s->pos += WKB_INT_SIZE;
+		s->size += 2 * sizeof(uint32_t) + (size_t)nrings * sizeof(uint32_t) + (nrings % 2 ? sizeof(uint32_t) : 0);
+		for (uint32_t i = 0; i < nrings; i++)
+		{
+			uint32_t npoints;
+			if (!gserialized2_range_available(s->pos, s->end, WKB_INT_SIZE))
+				return LW_FAILURE;
+			npoints = gserialized2_wkb_uint32(s->pos);
+			s->pos += WKB_INT_SIZE;
+			/* The parser drops empty rings, leave that to it */
+			if (!npoints || npoints > GSERIALIZED2_WKB_MAX_POINTS ||
+			    !gserialized2_range_available(s->pos, s->end, npoints * ptsize))
+				return LW_FAILURE;
+			if (npoints < 4 && (s->check & LW_PARSER_CHECK_MINPOINTS))
+				return LW_FAILURE;
+			if ((s->check & LW_PARSER_CHECK_CLOSURE) &&
+			    memcmp(s->pos, s->pos + (npoints - 1) * ptsize, sizeof(POINT2D)))
+				return LW_FAILURE;
+			s->pos += npoints * ptsize;
+			s->size += npoints * ptsize;
+			s->nvertices += npoints;
+		}
+		*is_empty = nrings == 0;
+		return LW_SUCCESS;
+	}
+	default:
+	{
+		uint32_t ngeoms;
+		if (!gserialized2_range_available(s->pos, s->end, WKB_INT_SIZE))
+			return LW_FAILURE;
+		ngeoms = gserialized2_wkb_uint32(s->pos);
+		s->pos += WKB_INT_SIZE;
+		s->size += 2 * sizeof(uint32_t);
+		if (!parent_type)
+			s->ngeoms = ngeoms;
+		*is_empty = LW_TRUE;
+		if (ngeoms && ++s->depth >= GSERIALIZED2_WKB_MAX_DEPTH)
+			return LW_FAILURE;
+		for (uint32_t i = 0; i < ngeoms; i++)
+		{
+			uint32_t subtype;
+			int sub_empty;
+			if (gserialized2_wkb_scan(s, type, &subtype, &sub_empty) == LW_FAILURE)
+				return LW_FAILURE;
+			*is_empty = *is_empty && sub_empty;
+		}
+		if (ngeoms)
+			s->depth--;
+		return LW_SUCCESS;
+	}
+	}
+}
+
+/*
+ * Second pass: copy the WKB checked by gserialized2_wkb_scan() into buf and
+ * compute the bounding box the same way lwgeom_calculate_gbox_cartesian()
+ * would, from the aligned copy. Returns the number of bytes written.
+ */
+static size_t
+gserialized2_wkb_write(const uint8_t **wkb, lwflags_t flags, uint8_t *buf, GBOX *gbox, int *has_box)
+{
+	const uint8_t *pos = *wkb;
+	size_t ptsize = sizeof(double) * FLAGS_NDIMS(flags);
+	uint8_t *loc = buf;
+	int has_z, has_m, has_srid;
+	uint32_t type = gserialized2_wkb_type(gserialized2_wkb_uint32(pos + 1), &has_z, &has_m, &has_srid);
+	uint32_t count;
+	POINTARRAY pa;
+
+	pos += 1 + WKB_INT_SIZE + (has_srid ? WKB_INT_SIZE : 0);
+	pa.flags = flags;
+	*has_box = LW_FALSE;
+
+	memcpy(loc, &type, sizeof(uint32_t));
+	loc += sizeof(uint32_t);
+
+	switch (type)
+	{
+	case POINTTYPE:
+	{
+		double xy[2];
+		memcpy(xy, pos, sizeof(xy));
+		count = (isnan(xy[0]) && isnan(xy[1])) ? 0 : 1;
+		memcpy(loc, &count, sizeof(uint32_t));
+		loc += sizeof(uint32_t);
+		pa.npoints = pa.maxpoints = count;
+		pa.serialized_pointlist = loc;
+		memcpy(loc, pos, count * ptsize);
+		loc += count * ptsize;
+		pos += ptsize;
+		*has_box = ptarray_calculate_gbox_cartesian(&pa, gbox) == LW_SUCCESS;
+		break;
+	}
+	case LINETYPE:
+	{
+		count = gserialized2_wkb_uint32(pos);
+		pos += WKB_INT_SIZE;
+		memcpy(loc, &count, sizeof(uint32_t));
+		loc += sizeof(uint32_t);
+		pa.npoints = pa.maxpoints = count;
+		pa.serialized_pointlist = loc;
+		memcpy(loc, pos, count * ptsize);
+		loc += count * ptsize;
+		pos += count * ptsize;
+		*has_box = ptarray_calculate_gbox_cartesian(&pa, gbox) == LW_SUCCESS;
+		break;
+	}
+	case POLYGONTYPE:
+	{
+		uint8_t *npoints_loc;
+		count = gserialized2_wkb_uint32(pos);
+		pos += WKB_INT_SIZE;
+		memcpy(loc, &count, sizeof(uint32_t));
+		loc += sizeof(uint32_t);
+		npoints_loc = loc;
+		loc += count * sizeof(uint32_t);
+		if (count % 2)
+		{
+			memset(loc, 0, sizeof(uint32_t));
+			loc += sizeof(uint32_t);
+		}
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t npoints = gserialized2_wkb_uint32(pos);
+			pos += WKB_INT_SIZE;
+			memcpy(npoints_loc, &npoints, sizeof(uint32_t));
+			npoints_loc += sizeof(uint32_t);
+			memcpy(loc, pos, npoints * ptsize);
+			/* Just need to check outer ring */
+			if (i == 0)
+			{
+				pa.npoints = pa.maxpoints = npoints;
+				pa.serialized_pointlist = loc;
+				*has_box = ptarray_calculate_gbox_cartesian(&pa, gbox) == LW_SUCCESS;
+			}
+			loc += npoints * ptsize;
+			pos += npoints * ptsize;
+		}
+		break;
+	}
+	default:
+	{
+		GBOX subbox = {0};
+		count = gserialized2_wkb_uint32(pos);
+		pos += WKB_INT_SIZE;
+		memcpy(loc, &count, sizeof(uint32_t));
+		loc += sizeof(uint32_t);
+		subbox.flags = flags;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			int sub_has_box;
+			loc += gserialized2_wkb_write(&pos, flags, loc, &subbox, &sub_has_box);
+			if (!sub_has_box)
+				continue;
+			if (*has_box)
+				gbox_merge(&subbox, gbox);
+			else
+				gbox_duplicate(&subbox, gbox);
+			*has_box = LW_TRUE;
+		}
+		break;
+	}
+	}
+
+	*wkb = pos;
+	return (size_t)(loc - buf);
+}
+
+GSERIALIZED *
+gserialized2_from_wkb(const uint8_t *wkb, size_t wkb_size, char check, size_t *size)
+{
+	gserialized2_wkb_state s;
+	uint32_t type;
+	int is_empty, needs_bbox, has_box;
+	lwflags_t flags;
+	size_t header_size, box_size = 0;
+	const uint8_t *pos = wkb;
+	uint8_t *ptr;
+	GSERIALIZED *g;
+	GBOX gbox;
+
+	if (!wkb || !wkb_size)
+		return NULL;
+
+	s.pos = wkb;
+	s.end = wkb + wkb_size;
+	s.check = check;
+	s.depth = 1;
+	s.flags = 0;
+	s.srid = SRID_UNKNOWN;
+	s.size = 0;
+	s.ngeoms = 0;
+	s.nvertices = 0;
+	if (gserialized2_wkb_scan(&s, 0, &type, &is_empty) == LW_FAILURE)
+		return NULL;
+
+	/* Same rules as lwgeom_needs_bbox(), from the counts of the scan */
+	if (is_empty || type == POINTTYPE)
+		needs_bbox = LW_FALSE;
+	else if (type == LINETYPE)
+		needs_bbox = s.nvertices > 2;
+	else if (type == MULTIPOINTTYPE)
+		needs_bbox = s.ngeoms != 1;
+	else if (type == MULTILINETYPE)
+		needs_bbox = s.ngeoms != 1 || s.nvertices > 2;
+	else
+		needs_bbox = LW_TRUE;
+
+	flags = s.flags;
+	FLAGS_SET_BBOX(flags, needs_bbox);
+	if (needs_bbox)
+		box_size = gbox_serialized_size(flags);
+	header_size = 8 + box_size;
+
+	ptr = lwalloc(header_size + s.size);
+	g = (GSERIALIZED *)ptr;
+	gserialized2_set_srid(g, s.srid);
+	LWSIZE_SET(g->size, header_size + s.size);
+	g->gflags = lwflags_get_g2flags(flags);
+
+	gbox.flags = flags;
+	gserialized2_wkb_write(&pos, flags, ptr + header_size, &gbox, &has_box);
+	if (needs_bbox)
+		gserialized2_from_gbox(&gbox, ptr + 8);
+
+	if (size)
+		*size = header_size + s.size;
+	return g;
+}
+
 /***********************************************************************
 * De-serialize GSERIALIZED into an LWGEOM.
 */
@@ -159,6 +159,11 @@ GSERIALIZED* gserialized2_from_lwgeom(LWGEOM *geom, size_t *size);
 */
 size_t gserialized2_from_lwgeom_size(const LWGEOM *geom);
 
+/**
+* Serialize linear WKB without going through an LWGEOM, see gserialized_from_wkb()
+*/
+GSERIALIZED* gserialized2_from_wkb(const uint8_t *wkb, size_t wkb_size, char check, size_t *size);
+
 /**
 * Allocate a new #LWGEOM from a #GSERIALIZED. The resulting #LWGEOM will have coordinates
 * that are double aligned and suitable for direct reading using getPoint2d_cp
@@ -173,3 +178,9 @@ const float * gserialized2_get_float_box_p(const GSERIALIZED *g, size_t *ndims);
 int gserialized2_peek_gbox_p(const GSERIALIZED *g, GBOX *gbox);
 
 int gserialized2_peek_first_point(const GSERIALIZED *g, POINT4D *out_point);
+
+/**
+* Walk the point arrays of a serialization in place, see #GSERIALIZED_CURSOR
+*/
+int gserialized2_cursor_init(GSERIALIZED_CURSOR *cursor, const GSERIALIZED *g);
+int gserialized2_cursor_next(GSERIALIZED_CURSOR *cursor);
@@ -521,5 +521,226 @@ itree_point_in_multipolygon(const IntervalTree *itree, const LWPOINT *point)
 }
 
 
+/*
+ * Batched point-in-polygon.
+ *
+ * The points are sorted by y, so the ones that fall in the y range
+ * of a tree node form a contiguous run of the sorted array. Each
+ * ring tree is then walked once for the whole batch, narrowing the
+ * run at every node, instead of once for every point.
+ */
+typedef struct
+{
+	POINT2D pt;
+	uint32_t index;          /* position in the caller's array */
+	int winding_number;      /* for the ring being evaluated */
+	IntervalTreeResult ring; /* result against the ring being evaluated */
+	IntervalTreeResult result;
+	uint8_t candidate;       /* inside the current exterior ring */
+} IntervalTreeBatchPoint;
+
+static int
+itree_batch_point_cmp(const void *a, const void *b)
+{
+	const IntervalTreeBatchPoint *pa = a;
+	const IntervalTreeBatchPoint *pb = b;
+	if (pa->pt.y < pb->pt.y) return -1;
+	if (pa->pt.y > pb->pt.y) return 1;
+	return 0;
+}
+
+/* First point of the sorted run that is not below min */
+static uint32_t
+itree_batch_lower(const IntervalTreeBatchPoint *pts, uint32_t npts, double min)
+{
+	uint32_t lo = 0, hi = npts;
+	while (lo < hi)
+	{
+		uint32_t mid = lo + (hi - lo) / 2;
+		if (FP_LTEQ(min, pts[mid].pt.y))
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return lo;
+}
+
+/* First point of the sorted run that is above max */
+static uint32_t
+itree_batch_upper(const IntervalTreeBatchPoint *pts, uint32_t npts, double max)
+{
+	uint32_t lo = 0, hi = npts;
+	while (lo < hi)
+	{
+		uint32_t mid = lo + (hi - lo) / 2;
+		if (FP_LTEQ(pts[mid].pt.y, max))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static void
+itree_points_in_ring_recursive(
+	const IntervalTreeNode *node,
+	const POINTARRAY *pa,
+	IntervalTreeBatchPoint *pts,
+	uint32_t npts)
+{
+	uint32_t lo, hi;
+
+	if (!node || !npts) return;
+
+	/* Narrow down to the points within the y range of the node */
+	lo = itree_batch_lower(pts, npts, node->min);
+	hi = lo + itree_batch_upper(pts + lo, npts - lo, node->max);
+	if (lo == hi)
+		return;
+
+	/* This is a leaf node, so evaluate winding numbers */
+	if (node->numChildren == 0)
+	{
+		const POINT2D *seg1 = getPoint2d_cp(pa, node->edgeIndex);
+		const POINT2D *seg2 = getPoint2d_cp(pa, node->edgeIndex + 1);
+
+		for (uint32_t i = lo; i < hi; i++)
+		{
+			IntervalTreeBatchPoint *bp = pts + i;
+			const POINT2D *pt = &(bp->pt);
+			double side;
+
+			if (bp->ring != ITREE_OK)
+				continue;
+
+			/* Same tests as itree_point_in_ring_recursive */
+			side = itree_segment_side(seg1, seg2, pt);
+			if (side == 0.0 && itree_point_on_segment(seg1, seg2, pt) == 1)
+				bp->ring = ITREE_BOUNDARY;
+			else if ((seg1->y <= pt->y) && (pt->y < seg2->y) && (side > 0))
+				bp->winding_number++;
+			else if ((seg2->y <= pt->y) && (pt->y < seg1->y) && (side < 0))
+				bp->winding_number--;
+		}
+		return;
+	}
+
+	/* This is an interior node, so recurse downwards */
+	for (uint32_t i = 0; i < node->numChildren; i++)
+		itree_points_in_ring_recursive(node->children[i], pa, pts + lo, hi - lo);
+}
+
+/*
+ * Set the ring result against one ring of the points still in play:
+ * the undecided points for an exterior ring, or the points inside
+ * the exterior ring for a hole. The others are left outside.
+ */
+static void
+itree_points_in_ring(const IntervalTree *itree, uint32_t ringNumber, IntervalTreeBatchPoint *pts, uint32_t npts, int hole)
+{
+	for (uint32_t i = 0; i < npts; i++)
+	{
+		int active = hole ? pts[i].candidate : pts[i].result == ITREE_OK;
+		pts[i].winding_number = 0;
+		pts[i].ring = active ? ITREE_OK : ITREE_OUTSIDE;
+	}
+
+	itree_points_in_ring_recursive(itree->indexes[ringNumber], itree->indexArrays[ringNumber], pts, npts);
+
+	for (uint32_t i = 0; i < npts; i++)
+	{
+		if (pts[i].ring == ITREE_OK)
+			pts[i].ring = pts[i].winding_number ? ITREE_INSIDE : ITREE_OUTSIDE;
+	}
+}
+
+/*
+ * Test many points against the multipolygon at once, writing the
+ * result of itree_point_in_multipolygon for pts[i] into results[i].
+ * Non-finite points are outside.
+ */
+void
+itree_points_in_multipolygon(const IntervalTree *itree, const POINT2D *pts, uint32_t npts, IntervalTreeResult *results)
+{
+	IntervalTreeBatchPoint *bpts;
+	uint32_t nbpts = 0;
+	uint32_t i = 0;
+
+	if (!npts)
+		return;
+
+	/* Non-finite points are decided up front and left out of the sweep */
+	bpts = lwalloc(npts * sizeof(IntervalTreeBatchPoint));
+	for (uint32_t j = 0; j < npts; j++)
+	{
+		results[j] = ITREE_OUTSIDE;
+		if (!(isfinite(pts[j].x) && isfinite(pts[j].y)))
+			continue;
+		bpts[nbpts].pt = pts[j];
+		bpts[nbpts].index = j;
+		bpts[nbpts].result = ITREE_OK;
+		bpts[nbpts].candidate = 0;
+		nbpts++;
+	}
+	qsort(bpts, nbpts, sizeof(IntervalTreeBatchPoint), itree_batch_point_cmp);
+
+	for (uint32_t p = 0; p < itree->numPolys; p++)
+	{
+		uint32_t ringCount = itree->ringCounts[p];
+		uint8_t any_candidate = 0;
+
+		/* Skip empty polygons */
+		if (ringCount == 0) continue;
+
+		/* Check undecided points against the exterior ring */
+		itree_points_in_ring(itree, i, bpts, nbpts, 0);
+		for (uint32_t j = 0; j < nbpts; j++)
+		{
+			IntervalTreeBatchPoint *bp = bpts + j;
+			bp->candidate = 0;
+			if (bp->result != ITREE_OK)
+				continue;
+			/* Boundary condition is a hard stop */
+			if (bp->ring == ITREE_BOUNDARY)
+				bp->result = ITREE_BOUNDARY;
+			else if (bp->ring == ITREE_INSIDE)
+				bp->candidate = any_candidate = 1;
+		}
+
+		/* Points inside the exterior ring must be outside all the holes */
+		for (uint32_t r = 1; any_candidate && r < ringCount; r++)
+		{
+			itree_points_in_ring(itree, i+r, bpts, nbpts, 1);
+			for (uint32_t j = 0; j < nbpts; j++)
+			{
+				IntervalTreeBatchPoint *bp = bpts + j;
+				if (!bp->candidate)
+					continue;
+				if (bp->ring == ITREE_BOUNDARY)
+				{
+					bp->result = ITREE_BOUNDARY;
+					bp->candidate = 0;
+				}
+				/* Inside a hole, other polygons may still hold the point */
+				else if (bp->ring == ITREE_INSIDE)
+					bp->candidate = 0;
+			}
+		}
 
+		for (uint32_t j = 0; j < nbpts; j++)
+		{
+			if (bpts[j].candidate)
+				bpts[j].result = ITREE_INSIDE;
+		}
 
+		/* Move to first ring of next polygon */
+		i += ringCount;
+	}
+
+	for (uint32_t j = 0; j < nbpts; j++)
+	{
+		if (bpts[j].result != ITREE_OK)
+			results[bpts[j].index] = bpts[j].result;
+	}
+	lwfree(bpts);
+}
@@ -71,6 +71,7 @@ typedef struct IntervalTree
 IntervalTree *itree_from_lwgeom(const LWGEOM *geom);
 void itree_free(IntervalTree *itree);
 IntervalTreeResult itree_point_in_multipolygon(const IntervalTree *itree, const LWPOINT *point);
+void itree_points_in_multipolygon(const IntervalTree *itree, const POINT2D *pts, uint32_t npts, IntervalTreeResult *results);
 
 
 
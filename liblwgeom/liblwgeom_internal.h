@@ -529,4 +529,7 @@ POINT4D* lwmpoint_extract_points_4d(const LWMPOINT* g, uint32_t* npoints, int* i
 char* lwstrdup(const char* a);
 void* lwalloc0(size_t sz);
 
+/* True if mem was allocated in an arena, see lwgeom_set_arena_owner() */
+int lwgeom_arena_owns(const void *mem);
+
 #endif /* _LIBLWGEOM_INTERNAL_H */
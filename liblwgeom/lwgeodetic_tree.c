@@ -585,6 +585,40 @@ int circ_tree_contains_point(const CIRC_NODE* node, const POINT2D* pt, const POI
 	return 0;
 }
 
+/**
+* Does any edge of the tree pass within tolerance (radians) of the point?
+* Unlike the tree/tree distance this does not stop at zero when a polygon
+* contains the point, so it measures the distance to the boundary.
+*/
+int
+circ_tree_edges_within(const CIRC_NODE* node, const GEOGRAPHIC_POINT* pt, double tolerance)
+{
+	uint32_t i;
+
+	if ( sphere_distance(&(node->center), pt) > node->radius + tolerance )
+		return LW_FALSE;
+
+	if ( circ_node_is_leaf(node) )
+	{
+		GEOGRAPHIC_EDGE e;
+		GEOGRAPHIC_POINT closest;
+
+		geographic_point_init(node->p1->x, node->p1->y, &(e.start));
+		if ( node->p1 == node->p2 )
+			return sphere_distance(&(e.start), pt) <= tolerance;
+
+		geographic_point_init(node->p2->x, node->p2->y, &(e.end));
+		return edge_distance_to_point(&e, pt, &closest) <= tolerance;
+	}
+
+	for ( i = 0; i < node->num_nodes; i++ )
+	{
+		if ( circ_tree_edges_within(node->nodes[i], pt, tolerance) )
+			return LW_TRUE;
+	}
+	return LW_FALSE;
+}
+
 static double
 circ_node_min_distance(const CIRC_NODE* n1, const CIRC_NODE* n2)
 {
@@ -866,6 +900,145 @@ circ_tree_distance_tree_internal(const CIRC_NODE* n1, const CIRC_NODE* n2, doubl
 
 
 
+/***********************************************************************
+ * Packed trees, copied into a single block.
+ ***********************************************************************/
+
+#define CIRC_PACK_OFFSET(base, ptr) ((void*)((uint8_t*)(ptr) - (base)))
+#define CIRC_PACK_POINTER(base, off) ((void*)((base) + (uintptr_t)(off)))
+
+typedef struct
+{
+	uint8_t* base;
+	CIRC_NODE* nodes;
+	CIRC_NODE** children;
+	POINT2D* points;
+	uint32_t num_nodes;
+	uint32_t num_children;
+	uint32_t num_points;
+} CIRC_PACK_STATE;
+
+static void
+circ_tree_pack_count(const CIRC_NODE* node, CIRC_PACK_STATE* state)
+{
+	uint32_t i;
+
+	state->num_nodes++;
+	state->num_children += node->num_nodes;
+	if (node->p1)
+		state->num_points++;
+	if (node->p2 && node->p2 != node->p1)
+		state->num_points++;
+
+	for (i = 0; i < node->num_nodes; i++)
+		circ_tree_pack_count(node->nodes[i], state);
+}
+
+static POINT2D*
+circ_tree_pack_point(const POINT2D* pt, CIRC_PACK_STATE* state)
+{
+	POINT2D* packed = state->points + state->num_points++;
+	*packed = *pt;
+	return CIRC_PACK_OFFSET(state->base, packed);
+}
+
+/* Copy the node and its children, returning the offset of the copy */
+static CIRC_NODE*
+circ_tree_pack_node(const CIRC_NODE* node, CIRC_PACK_STATE* state)
+{
+	CIRC_NODE* packed = state->nodes + state->num_nodes++;
+	uint32_t i;
+
+	*packed = *node;
+	if (node->p1)
+		packed->p1 = circ_tree_pack_point(node->p1, state);
+	if (node->p2)
+		packed->p2 = (node->p2 == node->p1) ? packed->p1 : circ_tree_pack_point(node->p2, state);
+
+	if (node->num_nodes)
+	{
+		CIRC_NODE** children = state->children + state->num_children;
+		state->num_children += node->num_nodes;
+		packed->nodes = CIRC_PACK_OFFSET(state->base, children);
+		for (i = 0; i < node->num_nodes; i++)
+			children[i] = circ_tree_pack_node(node->nodes[i], state);
+	}
+
+	return CIRC_PACK_OFFSET(state->base, packed);
+}
+
+/**
+* Copy a tree, and the edge end points it references, into a
+* single allocation that can be freed with lwfree. The copy is
+* position independent until circ_tree_unpack is called on it.
+*/
+CIRC_TREE_PACKED*
+circ_tree_pack(const CIRC_NODE* node)
+{
+	CIRC_TREE_PACKED* packed;
+	CIRC_PACK_STATE state;
+	size_t size;
+
+	memset(&state, 0, sizeof(CIRC_PACK_STATE));
+	if (node)
+		circ_tree_pack_count(node, &state);
+
+	size = sizeof(CIRC_TREE_PACKED) +
+	       state.num_nodes * sizeof(CIRC_NODE) +
+	       state.num_children * sizeof(CIRC_NODE*) +
+	       state.num_points * sizeof(POINT2D);
+	packed = lwalloc(size);
+	packed->size = size;
+	packed->num_nodes = state.num_nodes;
+	packed->num_children = state.num_children;
+	packed->num_points = state.num_points;
+	packed->padding = 0;
+
+	state.base = (uint8_t*)packed;
+	state.nodes = (CIRC_NODE*)(state.base + sizeof(CIRC_TREE_PACKED));
+	state.children = (CIRC_NODE**)(state.nodes + state.num_nodes);
+	state.points = (POINT2D*)(state.children + state.num_children);
+	state.num_nodes = state.num_children = state.num_points = 0;
+	if (node)
+		circ_tree_pack_node(node, &state);
+
+	return packed;
+}
+
+/**
+* Turn the offsets of a packed tree into pointers, in place, and
+* return its root. No spherical calculations are redone. The tree
+* lives inside the block, so free the block (not the tree) with
+* lwfree when done, and copy the block first to unpack it again.
+*/
+CIRC_NODE*
+circ_tree_unpack(CIRC_TREE_PACKED* packed)
+{
+	uint8_t* base = (uint8_t*)packed;
+	CIRC_NODE* nodes = (CIRC_NODE*)(base + sizeof(CIRC_TREE_PACKED));
+	CIRC_NODE** children = (CIRC_NODE**)(nodes + packed->num_nodes);
+	uint32_t i;
+
+	if (!packed->num_nodes)
+		return NULL;
+
+	for (i = 0; i < packed->num_nodes; i++)
+	{
+		CIRC_NODE* node = nodes + i;
+		if (node->nodes)
+			node->nodes = CIRC_PACK_POINTER(base, node->nodes);
+		if (node->p1)
+			node->p1 = CIRC_PACK_POINTER(base, node->p1);
+		if (node->p2)
+			node->p2 = CIRC_PACK_POINTER(base, node->p2);
+	}
+	for (i = 0; i < packed->num_children; i++)
+		children[i] = CIRC_PACK_POINTER(base, children[i]);
+
+	return nodes;
+}
+
+
 void circ_tree_print(const CIRC_NODE* node, int depth)
 {
 	uint32_t i;
@@ -47,15 +47,34 @@ typedef struct circ_node
 	POINT2D* p2;
 } CIRC_NODE;
 
+/**
+* A tree copied into one position independent block by circ_tree_pack.
+* The nodes (root first), their child arrays and the edge end points
+* follow this header, with every pointer stored as a byte offset from
+* the start of the block, so the block can be copied around or kept
+* apart from the geometry the tree was built on.
+*/
+typedef struct
+{
+	uint64_t size;
+	uint32_t num_nodes;
+	uint32_t num_children;
+	uint32_t num_points;
+	uint32_t padding;
+} CIRC_TREE_PACKED;
+
 void circ_tree_print(const CIRC_NODE* node, int depth);
 CIRC_NODE* circ_tree_new(const POINTARRAY* pa);
 void circ_tree_free(CIRC_NODE* node);
 int circ_tree_contains_point(const CIRC_NODE* node, const POINT2D* pt, const POINT2D* pt_outside, int level, int* on_boundary);
+int circ_tree_edges_within(const CIRC_NODE* node, const GEOGRAPHIC_POINT* pt, double tolerance);
 double circ_tree_distance_tree(const CIRC_NODE* n1, const CIRC_NODE* n2, const SPHEROID *spheroid, double threshold);
 double circ_tree_distance_tree_internal(const CIRC_NODE* n1, const CIRC_NODE* n2, double threshold, double* min_dist, double* max_dist, GEOGRAPHIC_POINT* closest1, GEOGRAPHIC_POINT* closest2);
 CIRC_NODE* lwgeom_calculate_circ_tree(const LWGEOM* lwgeom);
 int circ_tree_get_point(const CIRC_NODE* node, POINT2D* pt);
 int circ_tree_get_point_outside(const CIRC_NODE* node, POINT2D* pt);
+CIRC_TREE_PACKED* circ_tree_pack(const CIRC_NODE* node);
+CIRC_NODE* circ_tree_unpack(CIRC_TREE_PACKED* packed);
 
 LWGEOM * geography_tree_closestpoint(const LWGEOM* g1, const LWGEOM* g2, double threshold);
 LWGEOM * geography_tree_shortestline(const LWGEOM* g1, const LWGEOM* g2, double threshold, const SPHEROID *spheroid);
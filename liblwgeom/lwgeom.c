@@ -1420,6 +1420,9 @@ void lwgeom_free(LWGEOM *lwgeom)
 	/* There's nothing here to free... */
 	if( ! lwgeom ) return;
 
+	/* ...or it goes with its arena, so don't walk it */
+	if (lwgeom_arena_owns(lwgeom)) return;
+
 	LWDEBUGF(5,"freeing a %s",lwtype_name(lwgeom->type));
 
 	switch (lwgeom->type)
@@ -2783,6 +2786,137 @@ lwgeom_grid(const LWGEOM *lwgeom, gridspec *grid)
 }
 
 
+/* Does the bounding box of the segment p1-p2 reach the box? */
+static inline int
+subdivide_segment_in_box(const POINT2D *p1, const POINT2D *p2, const GBOX *box)
+{
+	return !(FP_MAX(p1->x, p2->x) < box->xmin || FP_MIN(p1->x, p2->x) > box->xmax ||
+		 FP_MAX(p1->y, p2->y) < box->ymin || FP_MIN(p1->y, p2->y) > box->ymax);
+}
+
+/*
+ * Build a shallow copy of geom without the parts whose bounds miss the clip
+ * box: holes outside the box, points outside the box, and the runs of
+ * segments at either end of a line that do not reach the box. Those parts
+ * cannot contribute to the intersection with the box, so GEOS returns the
+ * same result for the reduced geometry, without having to node the parts
+ * the earlier levels already cut away. Returns NULL if nothing of the
+ * geometry reaches the box, and geom itself if nothing could be dropped.
+ */
+static const LWGEOM *
+lwgeom_subdivide_reduce(const LWGEOM *geom, const GBOX *box)
+{
+	switch (geom->type)
+	{
+	case POLYGONTYPE:
+	{
+		const LWPOLY *poly = (const LWPOLY *)geom;
+		POINTARRAY **rings;
+		uint32_t nrings = 1;
+		GBOX ringbox;
+
+		if (poly->nrings < 2)
+			return geom;
+
+		rings = lwalloc(sizeof(POINTARRAY *) * poly->nrings);
+		rings[0] = poly->rings[0];
+		for (uint32_t i = 1; i < poly->nrings; i++)
+		{
+			ptarray_calculate_gbox_cartesian(poly->rings[i], &ringbox);
+			if (ringbox.xmax < box->xmin || ringbox.xmin > box->xmax ||
+			    ringbox.ymax < box->ymin || ringbox.ymin > box->ymax)
+				continue;
+			rings[nrings++] = poly->rings[i];
+		}
+		if (nrings == poly->nrings)
+		{
+			lwfree(rings);
+			return geom;
+		}
+		return (LWGEOM *)lwpoly_construct(geom->srid, NULL, nrings, rings);
+	}
+	case LINETYPE:
+	{
+		const POINTARRAY *pa = ((const LWLINE *)geom)->points;
+		uint32_t first, last;
+		size_t ptsize;
+
+		if (pa->npoints < 2)
+			return geom;
+
+		for (first = 0; first < pa->npoints - 1; first++)
+			if (subdivide_segment_in_box(getPoint2d_cp(pa, first), getPoint2d_cp(pa, first + 1), box))
+				break;
+		if (first == pa->npoints - 1)
+			return NULL;
+		for (last = pa->npoints - 1; last > first + 1; last--)
+			if (subdivide_segment_in_box(getPoint2d_cp(pa, last - 1), getPoint2d_cp(pa, last), box))
+				break;
+		if (first == 0 && last == pa->npoints - 1)
+			return geom;
+
+		ptsize = ptarray_point_size(pa);
+		return (LWGEOM *)lwline_construct(
+		    geom->srid,
+		    NULL,
+		    ptarray_construct_reference_data(FLAGS_GET_Z(pa->flags),
+						     FLAGS_GET_M(pa->flags),
+						     last - first + 1,
+						     pa->serialized_pointlist + first * ptsize));
+	}
+	case MULTIPOINTTYPE:
+	{
+		const LWCOLLECTION *mpoint = (const LWCOLLECTION *)geom;
+		LWGEOM **points = lwalloc(sizeof(LWGEOM *) * mpoint->ngeoms);
+		uint32_t npoints = 0;
+		POINT4D pt;
+
+		for (uint32_t i = 0; i < mpoint->ngeoms; i++)
+		{
+			if (!lwpoint_getPoint4d_p((LWPOINT *)mpoint->geoms[i], &pt))
+				continue;
+			if (pt.x < box->xmin || pt.x > box->xmax || pt.y < box->ymin || pt.y > box->ymax)
+				continue;
+			points[npoints++] = mpoint->geoms[i];
+		}
+		if (npoints == mpoint->ngeoms)
+		{
+			lwfree(points);
+			return geom;
+		}
+		if (npoints == 0)
+		{
+			lwfree(points);
+			return NULL;
+		}
+		return (LWGEOM *)lwcollection_construct(MULTIPOINTTYPE, geom->srid, NULL, npoints, points);
+	}
+	default:
+		return geom;
+	}
+}
+
+/* Free a reduced geometry, leaving the parts it shares with the original */
+static void
+lwgeom_subdivide_reduce_free(const LWGEOM *reduced, const LWGEOM *geom)
+{
+	if (!reduced || reduced == geom)
+		return;
+	switch (reduced->type)
+	{
+	case POLYGONTYPE:
+		lwfree(((LWPOLY *)reduced)->rings);
+		break;
+	case LINETYPE:
+		ptarray_free(((LWLINE *)reduced)->points);
+		break;
+	case MULTIPOINTTYPE:
+		lwfree(((LWCOLLECTION *)reduced)->geoms);
+		break;
+	}
+	lwfree((LWGEOM *)reduced);
+}
+
 /* Prototype for recursion */
 static void lwgeom_subdivide_recursive(const LWGEOM *geom,
 				       uint8_t dimension,
@@ -2947,11 +3081,17 @@ lwgeom_subdivide_recursive(const LWGEOM *geom,
 	++depth;
 
 	{
-		LWGEOM *subbox = (LWGEOM *)lwpoly_construct_envelope(
-		    geom->srid, subbox1.xmin, subbox1.ymin, subbox1.xmax, subbox1.ymax);
-		LWGEOM *clipped = lwgeom_intersection_prec(geom, subbox, gridSize);
-		lwgeom_simplify_in_place(clipped, 0.0, LW_TRUE);
-		lwgeom_free(subbox);
+		const LWGEOM *reduced = lwgeom_subdivide_reduce(geom, &subbox1);
+		LWGEOM *subbox, *clipped = NULL;
+		if (reduced)
+		{
+			subbox = (LWGEOM *)lwpoly_construct_envelope(
+			    geom->srid, subbox1.xmin, subbox1.ymin, subbox1.xmax, subbox1.ymax);
+			clipped = lwgeom_intersection_prec(reduced, subbox, gridSize);
+			lwgeom_simplify_in_place(clipped, 0.0, LW_TRUE);
+			lwgeom_free(subbox);
+			lwgeom_subdivide_reduce_free(reduced, geom);
+		}
 		if (clipped && !lwgeom_is_empty(clipped))
 		{
 			lwgeom_subdivide_recursive(clipped, dimension, maxvertices, depth, col, gridSize);
@@ -2959,11 +3099,17 @@ lwgeom_subdivide_recursive(const LWGEOM *geom,
 		}
 	}
 	{
-		LWGEOM *subbox = (LWGEOM *)lwpoly_construct_envelope(
-		    geom->srid, subbox2.xmin, subbox2.ymin, subbox2.xmax, subbox2.ymax);
-		LWGEOM *clipped = lwgeom_intersection_prec(geom, subbox, gridSize);
-		lwgeom_simplify_in_place(clipped, 0.0, LW_TRUE);
-		lwgeom_free(subbox);
+		const LWGEOM *reduced = lwgeom_subdivide_reduce(geom, &subbox2);
+		LWGEOM *subbox, *clipped = NULL;
+		if (reduced)
+		{
+			subbox = (LWGEOM *)lwpoly_construct_envelope(
+			    geom->srid, subbox2.xmin, subbox2.ymin, subbox2.xmax, subbox2.ymax);
+			clipped = lwgeom_intersection_prec(reduced, subbox, gridSize);
+			lwgeom_simplify_in_place(clipped, 0.0, LW_TRUE);
+			lwgeom_free(subbox);
+			lwgeom_subdivide_reduce_free(reduced, geom);
+		}
 		if (clipped && !lwgeom_is_empty(clipped))
 		{
 			lwgeom_subdivide_recursive(clipped, dimension, maxvertices, depth, col, gridSize);
@@ -811,6 +811,109 @@ lwgeom_intersection_prec(const LWGEOM* geom1, const LWGEOM* geom2, double prec)
 	return result;
 }
 
+/*
+* Shallow collection of the parts of col whose boxes overlap box
+* (or, with overlapping false, do not overlap it). Empty parts are
+* left out of both. The parts still
+* belong to col: free the result with lwgeom_overlay_parts_free().
+*/
+static LWCOLLECTION*
+lwgeom_overlay_parts(const LWCOLLECTION* col, const GBOX* box, int overlapping)
+{
+	LWGEOM** geoms = lwalloc(sizeof(LWGEOM*) * (col->ngeoms ? col->ngeoms : 1));
+	uint32_t i, ngeoms = 0;
+	GBOX part_box;
+
+	for (i = 0; i < col->ngeoms; i++)
+	{
+		LWGEOM* part = col->geoms[i];
+		int overlaps;
+		if (lwgeom_is_empty(part) || lwgeom_calculate_gbox(part, &part_box) == LW_FAILURE)
+			continue;
+		overlaps = gbox_overlaps_2d(&part_box, box);
+		if (overlaps == overlapping)
+			geoms[ngeoms++] = part;
+	}
+
+	return lwcollection_construct(col->type, col->srid, NULL, ngeoms, geoms);
+}
+
+static void
+lwgeom_overlay_parts_free(LWCOLLECTION* parts)
+{
+	lwfree(parts->geoms);
+	lwcollection_release(parts);
+}
+
+/*
+* Drop the parts of a collection that cannot reach the other input,
+* even after snapping to a grid of size prec. Returns NULL when nothing
+* would be dropped. At least one part is always kept so GEOS still
+* picks the type of an empty result.
+*/
+static LWCOLLECTION*
+lwgeom_overlay_prune(const LWGEOM* geom, const LWGEOM* other, double prec)
+{
+	const LWCOLLECTION* col;
+	LWCOLLECTION* parts;
+	GBOX box;
+
+	/* Curves and surfaces are not free to lose parts */
+	if (geom->type != MULTIPOINTTYPE && geom->type != MULTILINETYPE &&
+	    geom->type != MULTIPOLYGONTYPE && geom->type != COLLECTIONTYPE)
+		return NULL;
+
+	if (lwgeom_calculate_gbox(other, &box) == LW_FAILURE)
+		return NULL;
+	if (prec > 0)
+		gbox_expand(&box, prec);
+
+	col = (const LWCOLLECTION*)geom;
+	parts = lwgeom_overlay_parts(col, &box, LW_TRUE);
+	if (parts->ngeoms == col->ngeoms)
+	{
+		lwgeom_overlay_parts_free(parts);
+		return NULL;
+	}
+	if (parts->ngeoms == 0)
+	{
+		parts->geoms[0] = col->geoms[0];
+		parts->ngeoms = 1;
+		parts->flags = col->flags;
+		FLAGS_SET_BBOX(parts->flags, 0);
+	}
+	return parts;
+}
+
+/*
+* Intersection that only hands GEOS the parts of collection inputs
+* whose boxes overlap the other input. Parts further away contribute
+* nothing to the result, but still cost noding time, so a large
+* multipolygon cut by a small area overlays only the neighborhood of
+* that area.
+*/
+LWGEOM*
+lwgeom_intersection_partitioned(const LWGEOM* geom1, const LWGEOM* geom2, double prec)
+{
+	LWCOLLECTION* parts1;
+	LWCOLLECTION* parts2;
+	LWGEOM* result;
+
+	if (lwgeom_is_empty(geom1) || lwgeom_is_empty(geom2))
+		return lwgeom_intersection_prec(geom1, geom2, prec);
+
+	parts1 = lwgeom_overlay_prune(geom1, geom2, prec);
+	parts2 = lwgeom_overlay_prune(geom2, geom1, prec);
+
+	result = lwgeom_intersection_prec(parts1 ? lwcollection_as_lwgeom(parts1) : geom1,
+	                                  parts2 ? lwcollection_as_lwgeom(parts2) : geom2,
+	                                  prec);
+
+	if (parts1) lwgeom_overlay_parts_free(parts1);
+	if (parts2) lwgeom_overlay_parts_free(parts2);
+	return result;
+}
+
 LWGEOM*
 lwgeom_linemerge(const LWGEOM* geom)
 {
@@ -949,6 +1052,94 @@ lwgeom_difference_prec(const LWGEOM* geom1, const LWGEOM* geom2, double prec)
 	return result;
 }
 
+/*
+* Difference that only hands GEOS the parts of a multipolygon whose
+* boxes overlap the subtracted geometry. Parts of a valid multipolygon
+* meet at points at most, so the others are copied to the result
+* unchanged instead of being noded, and nothing needs to be unioned
+* back together. Other inputs, and any grid size, which would have to
+* snap the copied parts too, take the plain lwgeom_difference_prec().
+*/
+LWGEOM*
+lwgeom_difference_partitioned(const LWGEOM* geom1, const LWGEOM* geom2, double prec)
+{
+	const LWCOLLECTION* col;
+	LWCOLLECTION* touched;
+	LWCOLLECTION* untouched;
+	LWCOLLECTION* result;
+	LWGEOM* diff;
+	GBOX box2;
+	uint32_t i;
+	int32_t srid = RESULT_SRID(geom1, geom2);
+
+	if (srid == SRID_INVALID) return NULL;
+
+	/* GEOS drops M and adds the Z of either input, the copied parts would not */
+	if (prec > 0 || geom1->type != MULTIPOLYGONTYPE || FLAGS_GET_M(geom1->flags) ||
+	    (FLAGS_GET_Z(geom2->flags) && !FLAGS_GET_Z(geom1->flags)) ||
+	    lwgeom_is_empty(geom1) || lwgeom_is_empty(geom2) ||
+	    lwgeom_calculate_gbox(geom2, &box2) == LW_FAILURE)
+		return lwgeom_difference_prec(geom1, geom2, prec);
+
+	col = (const LWCOLLECTION*)geom1;
+	touched = lwgeom_overlay_parts(col, &box2, LW_TRUE);
+	if (touched->ngeoms == col->ngeoms)
+	{
+		lwgeom_overlay_parts_free(touched);
+		return lwgeom_difference_prec(geom1, geom2, prec);
+	}
+
+	if (touched->ngeoms)
+	{
+		diff = lwgeom_difference_prec(lwcollection_as_lwgeom(touched), geom2, prec);
+		lwgeom_overlay_parts_free(touched);
+		if (!diff) return NULL;
+		if (diff->type != POLYGONTYPE && diff->type != MULTIPOLYGONTYPE && !lwgeom_is_empty(diff))
+		{
+			lwgeom_free(diff);
+			return lwgeom_difference_prec(geom1, geom2, prec);
+		}
+	}
+	else
+	{
+		lwgeom_overlay_parts_free(touched);
+		diff = NULL;
+	}
+
+	result = lwcollection_construct_empty(MULTIPOLYGONTYPE, srid,
+	                                      FLAGS_GET_Z(geom1->flags), 0);
+
+	untouched = lwgeom_overlay_parts(col, &box2, LW_FALSE);
+	for (i = 0; i < untouched->ngeoms; i++)
+		lwcollection_add_lwgeom(result, lwgeom_clone_deep(untouched->geoms[i]));
+	lwgeom_overlay_parts_free(untouched);
+
+	if (diff && diff->type == POLYGONTYPE)
+	{
+		if (!lwgeom_is_empty(diff))
+		{
+			lwgeom_set_srid(diff, srid);
+			lwcollection_add_lwgeom(result, diff);
+			diff = NULL;
+		}
+	}
+	else if (diff && diff->type == MULTIPOLYGONTYPE)
+	{
+		LWCOLLECTION* diff_col = (LWCOLLECTION*)diff;
+		for (i = 0; i < diff_col->ngeoms; i++)
+		{
+			lwgeom_set_srid(diff_col->geoms[i], srid);
+			lwcollection_add_lwgeom(result, diff_col->geoms[i]);
+		}
+		lwfree(diff_col->geoms);
+		lwcollection_release(diff_col);
+		diff = NULL;
+	}
+	if (diff) lwgeom_free(diff);
+
+	return lwcollection_as_lwgeom(result);
+}
+
 LWGEOM*
 lwgeom_symdifference(const LWGEOM* geom1, const LWGEOM* geom2)
 {
@@ -358,8 +358,284 @@ cluster_intersecting(GEOSGeometry** geoms, uint32_t num_geoms, GEOSGeometry*** c
 	return cluster_success;
 }
 
+/*
+ * Uniform grid over point inputs, used by DBSCAN to find the
+ * candidates of a query when every input is a point. Points are
+ * bucketed into square cells at least eps wide, and grouped by
+ * cell in one array, so a neighbor query only scans the few cells
+ * its envelope touches, without building a GEOS query envelope
+ * or walking the tree.
+ *
+ * The candidates still have to come out in the order the STRtree
+ * would visit them, since the order of the cluster unions decides
+ * which border points go to which cluster, and how the clusters
+ * are numbered. The STRtree visits the leaves of any query in the
+ * order of a depth-first walk over the tree, so we record that
+ * order once, by querying the whole extent, and the grid returns
+ * its candidates sorted by their rank in it.
+ */
+struct DBSCANGrid
+{
+	double xmin;
+	double ymin;
+	double cell_size;
+	uint32_t num_cols;
+	uint32_t num_rows;
+	uint32_t num_cells;
+	uint64_t* cell_keys;   /* sorted, one per non-empty cell */
+	uint32_t* cell_starts; /* num_cells + 1 offsets into ranks */
+	uint32_t* ranks;       /* STRtree visit ranks, grouped by cell */
+	void** leaf_items;     /* STRtree items, in visit order */
+	uint32_t* found;       /* ranks matched by the current query */
+	uint32_t found_size;
+};
+
+/* Keep the key space small enough that cell keys fit easily in 64 bits */
+static const double DBSCAN_GRID_MAX_CELLS_PER_AXIS = 16777216.0;
+
+struct DBSCANGridItem
+{
+	uint64_t key;
+	uint32_t rank;
+};
+
+static int
+dbscan_grid_item_cmp(const void* a, const void* b)
+{
+	const struct DBSCANGridItem* i1 = a;
+	const struct DBSCANGridItem* i2 = b;
+	if (i1->key != i2->key)
+		return i1->key < i2->key ? -1 : 1;
+	return i1->rank < i2->rank ? -1 : (i1->rank > i2->rank ? 1 : 0);
+}
+
+static int
+dbscan_rank_cmp(const void* a, const void* b)
+{
+	uint32_t r1 = *((const uint32_t*) a);
+	uint32_t r2 = *((const uint32_t*) b);
+	return r1 < r2 ? -1 : (r1 > r2 ? 1 : 0);
+}
+
+/*
+ * Cell number of an ordinate, clamped to the grid. Monotonic in
+ * the ordinate, so the cells touched by a query envelope are
+ * exactly those between the cells of its corners.
+ */
+static inline uint32_t
+dbscan_grid_cell(double v, double origin, double cell_size, uint32_t num_cells)
+{
+	double c = floor((v - origin) / cell_size);
+	if (!(c > 0))
+		return 0;
+	if (c >= num_cells - 1)
+		return num_cells - 1;
+	return (uint32_t) c;
+}
+
+static void
+destroy_dbscan_grid(struct DBSCANGrid* grid)
+{
+	if (grid->cell_keys)
+		lwfree(grid->cell_keys);
+	if (grid->cell_starts)
+		lwfree(grid->cell_starts);
+	if (grid->ranks)
+		lwfree(grid->ranks);
+	if (grid->leaf_items)
+		lwfree(grid->leaf_items);
+	if (grid->found)
+		lwfree(grid->found);
+}
+
+/*
+ * Can the inputs go on a grid? They have to be all points, with
+ * finite coordinates. Returns the number of non-empty points, and
+ * their extent, or -1 if the STRtree has to answer the queries.
+ */
+static int64_t
+dbscan_grid_extent(LWGEOM** geoms, uint32_t num_geoms, GBOX* extent)
+{
+	int64_t num_items = 0;
+	uint32_t i;
+
+	extent->xmin = extent->ymin = DBL_MAX;
+	extent->xmax = extent->ymax = -DBL_MAX;
+	for (i = 0; i < num_geoms; i++)
+	{
+		const POINT2D* pt;
+		if (geoms[i]->type != POINTTYPE)
+			return -1;
+		if (lwgeom_is_empty(geoms[i]))
+			continue;
+		pt = getPoint2d_cp(lwgeom_as_lwpoint(geoms[i])->point, 0);
+		if (!isfinite(pt->x) || !isfinite(pt->y))
+			return -1;
+		extent->xmin = FP_MIN(extent->xmin, pt->x);
+		extent->ymin = FP_MIN(extent->ymin, pt->y);
+		extent->xmax = FP_MAX(extent->xmax, pt->x);
+		extent->ymax = FP_MAX(extent->ymax, pt->y);
+		num_items++;
+	}
+	return num_items;
+}
+
+/*
+ * Build a grid over the point inputs, ranked in the visit order
+ * of the STRtree already built over them.
+ */
+static int
+make_dbscan_grid(LWGEOM** geoms, GEOSSTRtree* tree, uint32_t num_items, const GBOX* extent, double eps, struct DBSCANGrid* grid)
+{
+	struct DBSCANGridItem* items;
+	struct QueryContext cxt =
+	{
+		.items_found = NULL,
+		.num_items_found = 0,
+		.items_found_size = 0
+	};
+	GEOSGeometry* query_envelope;
+	double size;
+	uint32_t i;
+
+	memset(grid, 0, sizeof(struct DBSCANGrid));
+
+	/* Every leaf matches a query over the whole extent, in visit order */
+	query_envelope = make_geos_segment(extent->xmin, extent->ymin, extent->xmax, extent->ymax);
+	if (!query_envelope)
+		return LW_FAILURE;
+	GEOSSTRtree_query(tree, query_envelope, &query_accumulate, &cxt);
+	GEOSGeom_destroy(query_envelope);
+	if (cxt.num_items_found != num_items)
+	{
+		if (cxt.items_found)
+			lwfree(cxt.items_found);
+		return LW_FAILURE;
+	}
+	grid->leaf_items = cxt.items_found;
+
+	/* Cells no narrower than eps, and no more of them than we can key */
+	size = FP_MAX(extent->xmax - extent->xmin, extent->ymax - extent->ymin);
+	grid->cell_size = eps;
+	if (size / DBSCAN_GRID_MAX_CELLS_PER_AXIS > grid->cell_size)
+		grid->cell_size = size / DBSCAN_GRID_MAX_CELLS_PER_AXIS;
+	if (!(grid->cell_size > 0) || !isfinite(grid->cell_size))
+		grid->cell_size = 1.0;
+
+	grid->xmin = extent->xmin;
+	grid->ymin = extent->ymin;
+	grid->num_cols = (uint32_t) floor((extent->xmax - extent->xmin) / grid->cell_size) + 1;
+	grid->num_rows = (uint32_t) floor((extent->ymax - extent->ymin) / grid->cell_size) + 1;
+
+	items = lwalloc(sizeof(struct DBSCANGridItem) * num_items);
+	for (i = 0; i < num_items; i++)
+	{
+		uint32_t id = *((uint32_t*) grid->leaf_items[i]);
+		const POINT2D* pt = getPoint2d_cp(lwgeom_as_lwpoint(geoms[id])->point, 0);
+		uint64_t col = dbscan_grid_cell(pt->x, grid->xmin, grid->cell_size, grid->num_cols);
+		uint64_t row = dbscan_grid_cell(pt->y, grid->ymin, grid->cell_size, grid->num_rows);
+		items[i].key = col * grid->num_rows + row;
+		items[i].rank = i;
+	}
+	qsort(items, num_items, sizeof(struct DBSCANGridItem), dbscan_grid_item_cmp);
+
+	grid->ranks = lwalloc(sizeof(uint32_t) * num_items);
+	grid->cell_keys = lwalloc(sizeof(uint64_t) * num_items);
+	grid->cell_starts = lwalloc(sizeof(uint32_t) * (num_items + 1));
+	for (i = 0; i < num_items; i++)
+	{
+		grid->ranks[i] = items[i].rank;
+		if (i == 0 || items[i].key != items[i-1].key)
+		{
+			grid->cell_keys[grid->num_cells] = items[i].key;
+			grid->cell_starts[grid->num_cells] = i;
+			grid->num_cells++;
+		}
+	}
+	grid->cell_starts[grid->num_cells] = num_items;
+
+	lwfree(items);
+	return LW_SUCCESS;
+}
+
+/* Index of the non-empty cell with a given key, or -1 */
+static int64_t
+dbscan_grid_find_cell(const struct DBSCANGrid* grid, uint64_t key)
+{
+	uint32_t lo = 0, hi = grid->num_cells;
+	while (lo < hi)
+	{
+		uint32_t mid = lo + (hi - lo) / 2;
+		if (grid->cell_keys[mid] < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo < grid->num_cells && grid->cell_keys[lo] == key)
+		return lo;
+	return -1;
+}
+
+/*
+ * Collect the points whose location falls in the query envelope
+ * of point p, using the same inclusive envelope test the STRtree
+ * applies, and return them in the order the STRtree would.
+ */
+static void
+dbscan_grid_query(struct DBSCANGrid* grid, struct QueryContext* cxt, LWGEOM** geoms, uint32_t p, double eps)
+{
+	const POINT2D* pt = getPoint2d_cp(lwgeom_as_lwpoint(geoms[p])->point, 0);
+	double qxmin = pt->x - eps, qxmax = pt->x + eps;
+	double qymin = pt->y - eps, qymax = pt->y + eps;
+	uint32_t col_lo = dbscan_grid_cell(qxmin, grid->xmin, grid->cell_size, grid->num_cols);
+	uint32_t col_hi = dbscan_grid_cell(qxmax, grid->xmin, grid->cell_size, grid->num_cols);
+	uint32_t row_lo = dbscan_grid_cell(qymin, grid->ymin, grid->cell_size, grid->num_rows);
+	uint32_t row_hi = dbscan_grid_cell(qymax, grid->ymin, grid->cell_size, grid->num_rows);
+	uint32_t num_found = 0;
+	uint32_t col, row, i;
+
+	for (col = col_lo; col <= col_hi; col++)
+	{
+		for (row = row_lo; row <= row_hi; row++)
+		{
+			int64_t cell = dbscan_grid_find_cell(grid, (uint64_t) col * grid->num_rows + row);
+			if (cell < 0)
+				continue;
+			for (i = grid->cell_starts[cell]; i < grid->cell_starts[cell + 1]; i++)
+			{
+				uint32_t rank = grid->ranks[i];
+				uint32_t id = *((uint32_t*) grid->leaf_items[rank]);
+				const POINT2D* q = getPoint2d_cp(lwgeom_as_lwpoint(geoms[id])->point, 0);
+				if (q->x < qxmin || q->x > qxmax || q->y < qymin || q->y > qymax)
+					continue;
+
+				if (num_found >= grid->found_size)
+				{
+					grid->found_size = grid->found_size ? 2 * grid->found_size : 8;
+					if (grid->found)
+						grid->found = lwrealloc(grid->found, grid->found_size * sizeof(uint32_t));
+					else
+						grid->found = lwalloc(grid->found_size * sizeof(uint32_t));
+				}
+				grid->found[num_found++] = rank;
+			}
+		}
+	}
+
+	/* Ranks within a cell are already sorted, only several cells need merging */
+	if (col_lo != col_hi || row_lo != row_hi)
+		qsort(grid->found, num_found, sizeof(uint32_t), dbscan_rank_cmp);
+
+	for (i = 0; i < num_found; i++)
+		query_accumulate(grid->leaf_items[grid->found[i]], cxt);
+}
+
+/*
+ * Find the DBSCAN candidates of geometry p, from the grid if we
+ * have one or else the STRtree.
+ */
 static int
-dbscan_update_context(GEOSSTRtree* tree, struct QueryContext* cxt, LWGEOM** geoms, uint32_t p, double eps)
+dbscan_update_context(GEOSSTRtree* tree, struct DBSCANGrid* grid, struct QueryContext* cxt, LWGEOM** geoms, uint32_t p, double eps)
 {
 	cxt->num_items_found = 0;
 
@@ -367,6 +643,12 @@ dbscan_update_context(GEOSSTRtree* tree, struct QueryContext* cxt, LWGEOM** geom
 
 	LW_ON_INTERRUPT(return LW_FAILURE);
 
+	if (grid)
+	{
+		dbscan_grid_query(grid, cxt, geoms, p, eps);
+		return LW_SUCCESS;
+	}
+
 	if (geoms[p]->type == POINTTYPE)
 	{
 		const POINT2D* pt = getPoint2d_cp(lwgeom_as_lwpoint(geoms[p])->point, 0);
@@ -386,6 +668,55 @@ dbscan_update_context(GEOSSTRtree* tree, struct QueryContext* cxt, LWGEOM** geom
 	return LW_SUCCESS;
 }
 
+/*
+ * DBSCAN neighbor index: a GEOS STRtree over the input envelopes,
+ * with a point grid answering the queries when all inputs are
+ * points.
+ */
+struct DBSCANIndex
+{
+	struct STRTree tree;
+	struct DBSCANGrid grid;
+	uint8_t has_grid;
+};
+
+static int
+make_dbscan_index(LWGEOM** geoms, uint32_t num_geoms, double eps, struct DBSCANIndex* index)
+{
+	GBOX extent;
+	int64_t num_items;
+
+	memset(index, 0, sizeof(struct DBSCANIndex));
+	index->tree = make_strtree((void**) geoms, num_geoms, LW_TRUE);
+	if (index->tree.tree == NULL)
+	{
+		destroy_strtree(&(index->tree));
+		return LW_FAILURE;
+	}
+
+	num_items = dbscan_grid_extent(geoms, num_geoms, &extent);
+	if (num_items > 0 &&
+	    make_dbscan_grid(geoms, index->tree.tree, (uint32_t) num_items, &extent, eps, &(index->grid)) == LW_SUCCESS)
+	{
+		index->has_grid = LW_TRUE;
+	}
+	return LW_SUCCESS;
+}
+
+static void
+destroy_dbscan_index(struct DBSCANIndex* index)
+{
+	if (index->has_grid)
+		destroy_dbscan_grid(&(index->grid));
+	destroy_strtree(&(index->tree));
+}
+
+static inline int
+dbscan_index_query(struct DBSCANIndex* index, struct QueryContext* cxt, LWGEOM** geoms, uint32_t p, double eps)
+{
+	return dbscan_update_context(index->tree.tree, index->has_grid ? &(index->grid) : NULL, cxt, geoms, p, eps);
+}
+
 /* Union p's cluster with q's cluster, if q is not a border point of another cluster.
  * Applicable to DBSCAN with minpoints > 1.
  */
@@ -419,7 +750,7 @@ static int
 union_dbscan_minpoints_1(LWGEOM **geoms, uint32_t num_geoms, UNIONFIND *uf, double eps, uint8_t **in_a_cluster_ret)
 {
 	uint32_t p, i;
-	struct STRTree tree;
+	struct DBSCANIndex index;
 	struct QueryContext cxt =
 	{
 		.items_found = NULL,
@@ -439,12 +770,8 @@ union_dbscan_minpoints_1(LWGEOM **geoms, uint32_t num_geoms, UNIONFIND *uf, doub
 	if (num_geoms <= 1)
 		return LW_SUCCESS;
 
-	tree = make_strtree((void**) geoms, num_geoms, LW_TRUE);
-	if (tree.tree == NULL)
-	{
-		destroy_strtree(&tree);
+	if (make_dbscan_index(geoms, num_geoms, eps, &index) == LW_FAILURE)
 		return LW_FAILURE;
-	}
 
 	for (p = 0; p < num_geoms; p++)
 	{
@@ -452,10 +779,10 @@ union_dbscan_minpoints_1(LWGEOM **geoms, uint32_t num_geoms, UNIONFIND *uf, doub
 		if (lwgeom_is_empty(geoms[p]))
 			continue;
 
-		rv = dbscan_update_context(tree.tree, &cxt, geoms, p, eps);
+		rv = dbscan_index_query(&index, &cxt, geoms, p, eps);
 		if (rv == LW_FAILURE)
 		{
-			destroy_strtree(&tree);
+			destroy_dbscan_index(&index);
 			return LW_FAILURE;
 		}
 		for (i = 0; i < cxt.num_items_found; i++)
@@ -480,7 +807,7 @@ union_dbscan_minpoints_1(LWGEOM **geoms, uint32_t num_geoms, UNIONFIND *uf, doub
 	if (cxt.items_found)
 		lwfree(cxt.items_found);
 
-	destroy_strtree(&tree);
+	destroy_dbscan_index(&index);
 
 	return success;
 }
@@ -494,7 +821,7 @@ union_dbscan_general(LWGEOM **geoms,
 		     uint8_t **in_a_cluster_ret)
 {
 	uint32_t p, i;
-	struct STRTree tree;
+	struct DBSCANIndex index;
 	struct QueryContext cxt =
 	{
 		.items_found = NULL,
@@ -520,12 +847,8 @@ union_dbscan_general(LWGEOM **geoms,
 		return LW_SUCCESS;
 	}
 
-	tree = make_strtree((void**) geoms, num_geoms, LW_TRUE);
-	if (tree.tree == NULL)
-	{
-		destroy_strtree(&tree);
+	if (make_dbscan_index(geoms, num_geoms, eps, &index) == LW_FAILURE)
 		return LW_FAILURE;
-	}
 
 	is_in_core = lwalloc(num_geoms * sizeof(uint8_t));
 	memset(is_in_core, 0, num_geoms * sizeof(uint8_t));
@@ -539,10 +862,10 @@ union_dbscan_general(LWGEOM **geoms,
 		if (lwgeom_is_empty(geoms[p]))
 			continue;
 
-		rv = dbscan_update_context(tree.tree, &cxt, geoms, p, eps);
+		rv = dbscan_index_query(&index, &cxt, geoms, p, eps);
 		if (rv == LW_FAILURE)
 		{
-			destroy_strtree(&tree);
+			destroy_dbscan_index(&index);
 			return LW_FAILURE;
 		}
 
@@ -625,7 +948,7 @@ union_dbscan_general(LWGEOM **geoms,
 	if (cxt.items_found)
 		lwfree(cxt.items_found);
 
-	destroy_strtree(&tree);
+	destroy_dbscan_index(&index);
 	return success;
 }
 
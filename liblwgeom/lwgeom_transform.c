@@ -28,20 +28,19 @@
 #include "lwgeom_log.h"
 #include <string.h>
 
-/** convert decimal degrees to radians */
-static void
-to_rad(POINT4D *pt)
-{
-	pt->x *= M_PI/180.0;
-	pt->y *= M_PI/180.0;
-}
-
-/** convert radians to decimal degrees */
+/**
+ * Scale x/y of the n points of a buffer of doubles by a factor, to
+ * convert between degrees and radians. Points are stride doubles apart.
+ */
 static void
-to_dec(POINT4D *pt)
+scale_xy(double *buf, size_t stride, size_t n, double factor)
 {
-	pt->x *= 180.0/M_PI;
-	pt->y *= 180.0/M_PI;
+	size_t i;
+	for (i = 0; i < n; i++, buf += stride)
+	{
+		buf[0] *= factor;
+		buf[1] *= factor;
+	}
 }
 
 /***************************************************************************/
@@ -226,51 +225,43 @@ box3d_transform(GBOX *gbox, LWPROJ *pj)
 	return ptarray_calculate_gbox_cartesian(pa, gbox);
 }
 
-int
-ptarray_transform(POINTARRAY *pa, LWPROJ *pj)
+/**
+ * Transform the n points of a buffer of doubles, stored stride doubles
+ * apart with x, y and (if has_z) z first, in one PROJ call.
+ */
+static int
+transform_buffer(double *buf, size_t stride, size_t n_points, int has_z, LWPROJ *pj)
 {
-	uint32_t i;
-	POINT4D p;
 	size_t n_converted;
-	size_t n_points = pa->npoints;
-	size_t point_size = ptarray_point_size(pa);
-	int has_z = ptarray_has_z(pa);
-	double *pa_double = (double*)(pa->serialized_pointlist);
-
+	int pj_errno_val;
 	PJ_DIRECTION direction = pj->pipeline_is_forward ? PJ_FWD : PJ_INV;
 
 	/* Convert to radians if necessary */
 	if (proj_angular_input(pj->pj, direction))
-	{
-		for (i = 0; i < pa->npoints; i++)
-		{
-			getPoint4d_p(pa, i, &p);
-			to_rad(&p);
-			ptarray_set_point4d(pa, i, &p);
-		}
-	}
+		scale_xy(buf, stride, n_points, M_PI / 180.0);
 
 	if (n_points == 1)
 	{
 		/* For single points it's faster to call proj_trans */
-		PJ_XYZT v = {pa_double[0], pa_double[1], has_z ? pa_double[2] : 0.0, 0.0};
+		PJ_XYZT v = {buf[0], buf[1], has_z ? buf[2] : 0.0, 0.0};
 		PJ_COORD c;
 		c.xyzt = v;
 		PJ_COORD t = proj_trans(pj->pj, direction, c);
 
-		int pj_errno_val = proj_errno_reset(pj->pj);
+		pj_errno_val = proj_errno_reset(pj->pj);
 		if (pj_errno_val)
 		{
 			lwerror("transform: %s (%d)", proj_errno_string(pj_errno_val), pj_errno_val);
 			return LW_FAILURE;
 		}
-		pa_double[0] = (t.xyzt).x;
-		pa_double[1] = (t.xyzt).y;
+		buf[0] = (t.xyzt).x;
+		buf[1] = (t.xyzt).y;
 		if (has_z)
-			pa_double[2] = (t.xyzt).z;
+			buf[2] = (t.xyzt).z;
 	}
 	else
 	{
+		size_t point_size = stride * sizeof(double);
 		/*
 		 * size_t proj_trans_generic(PJ *P, PJ_DIRECTION direction,
 		 * double *x, size_t sx, size_t nx,
@@ -281,13 +272,13 @@ ptarray_transform(POINTARRAY *pa, LWPROJ *pj)
 
 		n_converted = proj_trans_generic(pj->pj,
 						 direction,
-						 pa_double,
+						 buf,
 						 point_size,
 						 n_points, /* X */
-						 pa_double + 1,
+						 buf + 1,
 						 point_size,
 						 n_points, /* Y */
-						 has_z ? pa_double + 2 : NULL,
+						 has_z ? buf + 2 : NULL,
 						 has_z ? point_size : 0,
 						 has_z ? n_points : 0, /* Z */
 						 NULL,
@@ -301,7 +292,7 @@ ptarray_transform(POINTARRAY *pa, LWPROJ *pj)
 			return LW_FAILURE;
 		}
 
-		int pj_errno_val = proj_errno_reset(pj->pj);
+		pj_errno_val = proj_errno_reset(pj->pj);
 		if (pj_errno_val)
 		{
 			lwerror("transform: %s (%d)", proj_errno_string(pj_errno_val), pj_errno_val);
@@ -311,29 +302,34 @@ ptarray_transform(POINTARRAY *pa, LWPROJ *pj)
 
 	/* Convert radians to degrees if necessary */
 	if (proj_angular_output(pj->pj, direction))
-	{
-		for (i = 0; i < pa->npoints; i++)
-		{
-			getPoint4d_p(pa, i, &p);
-			to_dec(&p);
-			ptarray_set_point4d(pa, i, &p);
-		}
-	}
+		scale_xy(buf, stride, n_points, 180.0 / M_PI);
 
 	return LW_SUCCESS;
 }
 
+int
+ptarray_transform(POINTARRAY *pa, LWPROJ *pj)
+{
+	if (!pa->npoints)
+		return LW_SUCCESS;
+
+	return transform_buffer((double *)(pa->serialized_pointlist),
+				FLAGS_NDIMS(pa->flags),
+				pa->npoints,
+				ptarray_has_z(pa),
+				pj);
+}
+
 /**
- * Transform given LWGEOM geometry
- * from inpj projection to outpj projection
+ * Append the non-empty point arrays of a geometry to a growable list
  */
-int
-lwgeom_transform(LWGEOM *geom, LWPROJ *pj)
+static int
+lwgeom_collect_ptarrays(LWGEOM *geom, POINTARRAY ***pas, uint32_t *npas, uint32_t *maxpas)
 {
 	uint32_t i;
+	POINTARRAY *pa = NULL;
 
-	/* No points to transform in an empty! */
-	if ( lwgeom_is_empty(geom) )
+	if (lwgeom_is_empty(geom))
 		return LW_SUCCESS;
 
 	switch(geom->type)
@@ -342,25 +338,27 @@ lwgeom_transform(LWGEOM *geom, LWPROJ *pj)
 		case LINETYPE:
 		case CIRCSTRINGTYPE:
 		case TRIANGLETYPE:
-		{
-			LWLINE *g = (LWLINE*)geom;
-			if ( ! ptarray_transform(g->points, pj) ) return LW_FAILURE;
+			pa = ((LWLINE*)geom)->points;
+			break;
+		case NURBSCURVETYPE:
+			pa = ((LWNURBSCURVE*)geom)->points;
 			break;
-		}
 		case POLYGONTYPE:
 		{
 			LWPOLY *g = (LWPOLY*)geom;
 			for ( i = 0; i < g->nrings; i++ )
 			{
-				if ( ! ptarray_transform(g->rings[i], pj) ) return LW_FAILURE;
+				if ( g->rings[i]->npoints )
+				{
+					if ( *npas == *maxpas )
+					{
+						*maxpas *= 2;
+						*pas = lwrealloc(*pas, sizeof(POINTARRAY*) * (*maxpas));
+					}
+					(*pas)[(*npas)++] = g->rings[i];
+				}
 			}
-			break;
-		}
-		case NURBSCURVETYPE:
-		{
-			LWNURBSCURVE *g = (LWNURBSCURVE*)geom;
-			if ( ! ptarray_transform(g->points, pj) ) return LW_FAILURE;
-			break;
+			return LW_SUCCESS;
 		}
 		case MULTIPOINTTYPE:
 		case MULTILINETYPE:
@@ -376,9 +374,9 @@ lwgeom_transform(LWGEOM *geom, LWPROJ *pj)
 			LWCOLLECTION *g = (LWCOLLECTION*)geom;
 			for ( i = 0; i < g->ngeoms; i++ )
 			{
-				if ( ! lwgeom_transform(g->geoms[i], pj) ) return LW_FAILURE;
+				if ( ! lwgeom_collect_ptarrays(g->geoms[i], pas, npas, maxpas) ) return LW_FAILURE;
 			}
-			break;
+			return LW_SUCCESS;
 		}
 		default:
 		{
@@ -387,5 +385,98 @@ lwgeom_transform(LWGEOM *geom, LWPROJ *pj)
 			return LW_FAILURE;
 		}
 	}
+
+	if ( *npas == *maxpas )
+	{
+		*maxpas *= 2;
+		*pas = lwrealloc(*pas, sizeof(POINTARRAY*) * (*maxpas));
+	}
+	(*pas)[(*npas)++] = pa;
 	return LW_SUCCESS;
 }
+
+/**
+ * Transform given LWGEOM geometry
+ * from inpj projection to outpj projection
+ */
+int
+lwgeom_transform(LWGEOM *geom, LWPROJ *pj)
+{
+	uint32_t i, npas = 0, maxpas = 8;
+	POINTARRAY **pas;
+	size_t stride, npoints = 0;
+	int has_z, rv;
+	double *buf, *ptr;
+
+	/* No points to transform in an empty! */
+	if ( lwgeom_is_empty(geom) )
+		return LW_SUCCESS;
+
+	pas = lwalloc(sizeof(POINTARRAY*) * maxpas);
+	if ( ! lwgeom_collect_ptarrays(geom, &pas, &npas, &maxpas) )
+	{
+		lwfree(pas);
+		return LW_FAILURE;
+	}
+
+	/* A single point array is transformed in place */
+	if ( npas <= 1 )
+	{
+		rv = npas ? ptarray_transform(pas[0], pj) : LW_SUCCESS;
+		lwfree(pas);
+		return rv;
+	}
+
+	/*
+	 * Several point arrays (rings, parts) are gathered into one buffer
+	 * of x/y(/z) and transformed in a single PROJ call, rather than
+	 * paying the per call overhead for each of them.
+	 */
+	has_z = FLAGS_GET_Z(pas[0]->flags);
+	stride = has_z ? 3 : 2;
+	for ( i = 0; i < npas; i++ )
+	{
+		/* Parts should all share dimensionality, but be safe */
+		if ( FLAGS_GET_Z(pas[i]->flags) != has_z )
+			break;
+		npoints += pas[i]->npoints;
+	}
+
+	if ( i < npas )
+	{
+		for ( i = 0, rv = LW_SUCCESS; i < npas && rv; i++ )
+			rv = ptarray_transform(pas[i], pj);
+		lwfree(pas);
+		return rv;
+	}
+
+	buf = lwalloc(sizeof(double) * stride * npoints);
+	for ( i = 0, ptr = buf; i < npas; i++ )
+	{
+		POINTARRAY *pa = pas[i];
+		size_t ndims = FLAGS_NDIMS(pa->flags);
+		const double *src = (const double *)(pa->serialized_pointlist);
+		uint32_t j;
+		for ( j = 0; j < pa->npoints; j++, src += ndims, ptr += stride )
+			memcpy(ptr, src, sizeof(double) * stride);
+	}
+
+	rv = transform_buffer(buf, stride, npoints, has_z, pj);
+
+	if ( rv )
+	{
+		for ( i = 0, ptr = buf; i < npas; i++ )
+		{
+			POINTARRAY *pa = pas[i];
+			size_t ndims = FLAGS_NDIMS(pa->flags);
+			double *dst = (double *)(pa->serialized_pointlist);
+			uint32_t j;
+			for ( j = 0; j < pa->npoints; j++, dst += ndims, ptr += stride )
+				memcpy(dst, ptr, sizeof(double) * stride);
+		}
+	}
+
+	lwfree(buf);
+	lwfree(pas);
+	return rv;
+}
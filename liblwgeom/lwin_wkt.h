@@ -82,3 +82,9 @@ void wkt_parser_geometry_new(LWGEOM *geom, int32_t srid);
 
 LWGEOM* wkt_parser_nurbscurve_new(double degree, POINTARRAY *points, POINTARRAY *weights, POINTARRAY *knots, char *dimensionality);
 LWGEOM* wkt_parser_nurbscurve_empty(char *dimensionality);
+
+/*
+* Hand-written reader for the common simple features, tried before the
+* grammar. Returns LW_FAILURE for anything it leaves to the grammar.
+*/
+int wkt_fast_parse(LWGEOM_PARSER_RESULT *parser_result, const char *wktstr, int parser_check_flags);
@@ -0,0 +1,464 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.net
+ *
+ * PostGIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * PostGIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PostGIS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **********************************************************************/
+
+
+#include <float.h>
+#include <stdlib.h>
+#include <strings.h>
+
+#include "lwin_wkt.h"
+#include "lwgeom_log.h"
+
+/*
+* Hand-written reader for the WKT of points, lines, polygons and their
+* collections. It accepts a subset of what the flex/bison parser accepts
+* and builds the geometry with the same wkt_parser_* actions in the same
+* order, so anything it returns is what the grammar would have built.
+* Whatever it does not recognize, and any error raised by the actions,
+* makes it give up and lwgeom_parse_wkt() runs the grammar instead, which
+* then reports the error with its location.
+*/
+
+/* Give up on deeper nesting and let bison manage its own stack */
+#define WKT_FAST_MAX_DEPTH 64
+
+typedef struct
+{
+	const char *pos;
+	int depth;
+} wkt_fast_state;
+
+static LWGEOM *wkt_fast_geometry(wkt_fast_state *s);
+
+/* Bail out of the current rule if an action has flagged an error */
+#define WKT_FAST_ERROR() (global_parser_result.errcode != 0)
+
+static inline void
+wkt_fast_space(wkt_fast_state *s)
+{
+	while (*s->pos == ' ' || *s->pos == '\t' || *s->pos == '\n' || *s->pos == '\r')
+		s->pos++;
+}
+
+static inline int
+wkt_fast_char(wkt_fast_state *s, char c)
+{
+	wkt_fast_space(s);
+	if (*s->pos != c)
+		return LW_FALSE;
+	s->pos++;
+	return LW_TRUE;
+}
+
+/* Keywords are case insensitive, as the lexer is built with flex -i */
+static inline int
+wkt_fast_keyword(wkt_fast_state *s, const char *keyword, size_t len)
+{
+	wkt_fast_space(s);
+	if (strncasecmp(s->pos, keyword, len))
+		return LW_FALSE;
+	s->pos += len;
+	return LW_TRUE;
+}
+
+#define WKT_FAST_KEYWORD(s, keyword) wkt_fast_keyword((s), (keyword), sizeof(keyword) - 1)
+
+/* The optional Z, M or ZM after a type name, NULL when there is none */
+static char *
+wkt_fast_dimensionality(wkt_fast_state *s)
+{
+	wkt_fast_space(s);
+	if (*s->pos == 'Z' || *s->pos == 'z')
+	{
+		s->pos++;
+		if (*s->pos == 'M' || *s->pos == 'm')
+		{
+			s->pos++;
+			return "ZM";
+		}
+		return "Z";
+	}
+	if (*s->pos == 'M' || *s->pos == 'm')
+	{
+		s->pos++;
+		return "M";
+	}
+	return NULL;
+}
+
+/*
+* Exact powers of ten: every one up to 1e22 is representable, so a
+* product or quotient with a mantissa below 2^53 is rounded once and
+* gives the same double as strtod.
+*/
+static const double wkt_fast_pow10[] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/*
+* Read a number with the lexer's DOUBLE_TOK syntax, including the rule that
+* it must be followed by a space, comma or closing bracket. Short decimals
+* are converted with Clinger's fast path; the rest goes through strtod,
+* which is what the lexer calls.
+*/
+static int
+wkt_fast_double(wkt_fast_state *s, double *d)
+{
+	const char *start, *p;
+	uint64_t mantissa = 0;
+	int digits = 0, int_digits = 0, frac_digits = 0;
+	int exponent = 0, exp_negative = 0, negative = 0;
+	int fast = LW_TRUE;
+
+	wkt_fast_space(s);
+	start = p = s->pos;
+
+	if (*p == '-')
+	{
+		negative = LW_TRUE;
+		p++;
+	}
+
+	for (; *p >= '0' && *p <= '9'; p++, int_digits++)
+	{
+		if (mantissa || *p != '0')
+		{
+			if (++digits > 19)
+				fast = LW_FALSE;
+			else
+				mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+		}
+	}
+	if (*p == '.')
+	{
+		for (p++; *p >= '0' && *p <= '9'; p++, frac_digits++)
+		{
+			if (mantissa || *p != '0')
+			{
+				if (++digits > 19)
+					fast = LW_FALSE;
+				else
+					mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+			}
+		}
+		if (!int_digits && !frac_digits)
+			return LW_FALSE;
+	}
+	else if (!int_digits)
+		return LW_FALSE;
+
+	/* The lexer only takes an exponent straight after a digit, so not "1.e5" */
+	if (*p == 'e' || *p == 'E')
+	{
+		if (p[-1] < '0' || p[-1] > '9')
+			return LW_FALSE;
+		p++;
+		if (*p == '-' || *p == '+')
+			exp_negative = *p++ == '-';
+		if (*p < '0' || *p > '9')
+			return LW_FALSE;
+		for (; *p >= '0' && *p <= '9'; p++)
+			if (exponent < 100000)
+				exponent = exponent * 10 + (*p - '0');
+		if (exp_negative)
+			exponent = -exponent;
+	}
+
+	if (*p != ' ' && *p != ',' && *p != ')' && *p != '\t' && *p != '\n' && *p != '\r')
+		return LW_FALSE;
+
+	exponent -= frac_digits;
+#if FLT_EVAL_METHOD == 0
+	if (fast && mantissa <= (UINT64_C(1) << 53) && exponent >= -22 && exponent <= 22)
+	{
+		double value = (double)mantissa;
+		if (exponent < 0)
+			value /= wkt_fast_pow10[-exponent];
+		else
+			value *= wkt_fast_pow10[exponent];
+		*d = negative ? -value : value;
+	}
+	else
+#endif
+		*d = strtod(start, NULL);
+
+	s->pos = p;
+	return LW_TRUE;
+}
+
+static inline int
+wkt_fast_is_double(wkt_fast_state *s)
+{
+	wkt_fast_space(s);
+	return *s->pos == '-' || *s->pos == '.' || (*s->pos >= '0' && *s->pos <= '9');
+}
+
+/* Two to four ordinates */
+static int
+wkt_fast_coordinate(wkt_fast_state *s, POINT *p)
+{
+	double c[4];
+	int n;
+
+	if (!wkt_fast_double(s, &c[0]) || !wkt_fast_double(s, &c[1]))
+		return LW_FALSE;
+	for (n = 2; n < 4 && wkt_fast_is_double(s); n++)
+		if (!wkt_fast_double(s, &c[n]))
+			return LW_FALSE;
+
+	if (n == 2)
+		*p = wkt_parser_coord_2(c[0], c[1]);
+	else if (n == 3)
+		*p = wkt_parser_coord_3(c[0], c[1], c[2]);
+	else
+		*p = wkt_parser_coord_4(c[0], c[1], c[2], c[3]);
+	return LW_TRUE;
+}
+
+/* Coordinates up to and including the closing bracket */
+static POINTARRAY *
+wkt_fast_ptarray(wkt_fast_state *s)
+{
+	POINTARRAY *pa;
+	POINT p;
+
+	if (!wkt_fast_coordinate(s, &p))
+		return NULL;
+	pa = wkt_parser_ptarray_new(p);
+	if (WKT_FAST_ERROR())
+		return NULL;
+
+	while (wkt_fast_char(s, ','))
+	{
+		if (!wkt_fast_coordinate(s, &p))
+		{
+			ptarray_free(pa);
+			return NULL;
+		}
+		pa = wkt_parser_ptarray_add_coord(pa, p);
+		if (WKT_FAST_ERROR())
+			return NULL;
+	}
+
+	if (!wkt_fast_char(s, ')'))
+	{
+		ptarray_free(pa);
+		return NULL;
+	}
+	return pa;
+}
+
+/* Rings up to and including the closing bracket */
+static LWGEOM *
+wkt_fast_ring_list(wkt_fast_state *s)
+{
+	LWGEOM *poly = NULL;
+
+	do
+	{
+		POINTARRAY *pa;
+		if (!wkt_fast_char(s, '(') || !(pa = wkt_fast_ptarray(s)))
+		{
+			if (poly)
+				lwgeom_free(poly);
+			return NULL;
+		}
+		/* Both actions free the polygon and ring on error */
+		poly = poly ? wkt_parser_polygon_add_ring(poly, pa, '2') : wkt_parser_polygon_new(pa, '2');
+		if (WKT_FAST_ERROR())
+			return NULL;
+	} while (wkt_fast_char(s, ','));
+
+	if (!wkt_fast_char(s, ')'))
+	{
+		lwgeom_free(poly);
+		return NULL;
+	}
+	return poly;
+}
+
+/* Members of a multi-geometry, as the grammar's untagged rules */
+static LWGEOM *
+wkt_fast_member(wkt_fast_state *s, int lwtype)
+{
+	POINTARRAY *pa;
+	POINT p;
+
+	switch (lwtype)
+	{
+	case MULTIPOINTTYPE:
+		if (WKT_FAST_KEYWORD(s, "EMPTY"))
+			return wkt_parser_point_new(NULL, NULL);
+		if (wkt_fast_char(s, '('))
+		{
+			if (!wkt_fast_coordinate(s, &p) || !wkt_fast_char(s, ')'))
+				return NULL;
+		}
+		else if (!wkt_fast_coordinate(s, &p))
+			return NULL;
+		pa = wkt_parser_ptarray_new(p);
+		if (WKT_FAST_ERROR())
+			return NULL;
+		return wkt_parser_point_new(pa, NULL);
+	case MULTILINETYPE:
+		if (WKT_FAST_KEYWORD(s, "EMPTY"))
+			return wkt_parser_linestring_new(NULL, NULL);
+		if (!wkt_fast_char(s, '(') || !(pa = wkt_fast_ptarray(s)))
+			return NULL;
+		return wkt_parser_linestring_new(pa, NULL);
+	case MULTIPOLYGONTYPE:
+		if (WKT_FAST_KEYWORD(s, "EMPTY"))
+			return wkt_parser_polygon_finalize(NULL, NULL);
+		if (!wkt_fast_char(s, '('))
+			return NULL;
+		return wkt_fast_ring_list(s);
+	default:
+		return wkt_fast_geometry(s);
+	}
+}
+
+static LWGEOM *
+wkt_fast_collection(wkt_fast_state *s, int lwtype)
+{
+	char *dimensionality = wkt_fast_dimensionality(s);
+	LWGEOM *col = NULL;
+
+	if (WKT_FAST_KEYWORD(s, "EMPTY"))
+		return wkt_parser_collection_finalize(lwtype, NULL, dimensionality);
+	if (!wkt_fast_char(s, '('))
+		return NULL;
+
+	do
+	{
+		LWGEOM *geom = wkt_fast_member(s, lwtype);
+		if (!geom || WKT_FAST_ERROR())
+		{
+			if (col)
+				lwgeom_free(col);
+			return NULL;
+		}
+		col = col ? wkt_parser_collection_add_geom(col, geom) : wkt_parser_collection_new(geom);
+		if (WKT_FAST_ERROR())
+			return NULL;
+	} while (wkt_fast_char(s, ','));
+
+	if (!wkt_fast_char(s, ')'))
+	{
+		lwgeom_free(col);
+		return NULL;
+	}
+	return wkt_parser_collection_finalize(lwtype, col, dimensionality);
+}
+
+static LWGEOM *
+wkt_fast_geometry(wkt_fast_state *s)
+{
+	char *dimensionality;
+	POINTARRAY *pa;
+	LWGEOM *geom;
+
+	if (WKT_FAST_KEYWORD(s, "POINT"))
+	{
+		dimensionality = wkt_fast_dimensionality(s);
+		if (WKT_FAST_KEYWORD(s, "EMPTY"))
+			return wkt_parser_point_new(NULL, dimensionality);
+		if (!wkt_fast_char(s, '(') || !(pa = wkt_fast_ptarray(s)))
+			return NULL;
+		return wkt_parser_point_new(pa, dimensionality);
+	}
+	if (WKT_FAST_KEYWORD(s, "LINESTRING"))
+	{
+		dimensionality = wkt_fast_dimensionality(s);
+		if (WKT_FAST_KEYWORD(s, "EMPTY"))
+			return wkt_parser_linestring_new(NULL, dimensionality);
+		if (!wkt_fast_char(s, '(') || !(pa = wkt_fast_ptarray(s)))
+			return NULL;
+		return wkt_parser_linestring_new(pa, dimensionality);
+	}
+	if (WKT_FAST_KEYWORD(s, "POLYGON"))
+	{
+		dimensionality = wkt_fast_dimensionality(s);
+		if (WKT_FAST_KEYWORD(s, "EMPTY"))
+			return wkt_parser_polygon_finalize(NULL, dimensionality);
+		if (!wkt_fast_char(s, '(') || !(geom = wkt_fast_ring_list(s)))
+			return NULL;
+		return wkt_parser_polygon_finalize(geom, dimensionality);
+	}
+	if (WKT_FAST_KEYWORD(s, "MULTIPOINT"))
+		return wkt_fast_collection(s, MULTIPOINTTYPE);
+	if (WKT_FAST_KEYWORD(s, "MULTILINESTRING"))
+		return wkt_fast_collection(s, MULTILINETYPE);
+	if (WKT_FAST_KEYWORD(s, "MULTIPOLYGON"))
+		return wkt_fast_collection(s, MULTIPOLYGONTYPE);
+	if (WKT_FAST_KEYWORD(s, "GEOMETRYCOLLECTION"))
+	{
+		if (++s->depth > WKT_FAST_MAX_DEPTH)
+			return NULL;
+		geom = wkt_fast_collection(s, COLLECTIONTYPE);
+		s->depth--;
+		return geom;
+	}
+	return NULL;
+}
+
+int
+wkt_fast_parse(LWGEOM_PARSER_RESULT *parser_result, const char *wktstr, int parser_check_flags)
+{
+	wkt_fast_state s;
+	int32_t srid = SRID_UNKNOWN;
+	LWGEOM *geom;
+
+	lwgeom_parser_result_init(&global_parser_result);
+	global_parser_result.wkinput = wktstr;
+	global_parser_result.parser_check_flags = parser_check_flags;
+
+	s.pos = wktstr;
+	s.depth = 0;
+
+	/* SRID=<number>; */
+	if (WKT_FAST_KEYWORD(&s, "SRID="))
+	{
+		const char *srid_start = s.pos - 5;
+		if (*s.pos == '-')
+			s.pos++;
+		if (*s.pos < '0' || *s.pos > '9')
+			return LW_FAILURE;
+		while (*s.pos >= '0' && *s.pos <= '9')
+			s.pos++;
+		if (!wkt_fast_char(&s, ';'))
+			return LW_FAILURE;
+		srid = wkt_lexer_read_srid((char *)srid_start);
+	}
+
+	geom = wkt_fast_geometry(&s);
+	if (!geom || WKT_FAST_ERROR())
+		return LW_FAILURE;
+
+	wkt_fast_space(&s);
+	if (*s.pos != '\0')
+	{
+		lwgeom_free(geom);
+		return LW_FAILURE;
+	}
+
+	wkt_parser_geometry_new(geom, srid);
+	*parser_result = global_parser_result;
+	return LW_SUCCESS;
+}
@@ -50,6 +50,10 @@ int lwgeom_parse_wkt(LWGEOM_PARSER_RESULT *parser_result, const char *wktstr, in
 {
 	int parse_rv = 0;
 
+	/* Points, lines, polygons and their collections skip flex and bison */
+	if ( wkt_fast_parse(parser_result, wktstr, parser_check_flags) == LW_SUCCESS )
+		return LW_SUCCESS;
+
 	/* Clean up our global parser result. */
 	lwgeom_parser_result_init(&global_parser_result);
 	/* Work-around possible bug in GNU Bison 3.0.2 resulting in wkt_yylloc
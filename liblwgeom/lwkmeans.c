@@ -6,6 +6,7 @@
  *------------------------------------------------------------------------*/
 
 #include "liblwgeom_internal.h"
+#include "lwrandom.h"
 
 /*
  * When clustering lists with NULL or EMPTY elements, they will get this as
@@ -19,6 +20,32 @@
  */
 #define KMEANS_MAX_ITERATIONS 1000
 
+/*
+ * Relative slack on the pruning bounds, so that the rounding of the
+ * square roots and of the accumulated center drift never lets a bound
+ * skip a center that is in fact as close as the current one.
+ */
+#define KMEANS_BOUND_EPSILON 1e-9
+
+/*
+ * Mini-batch mode visits every object about this many times on average
+ * before the final assignment, capped at KMEANS_MAX_ITERATIONS batches.
+ */
+#define KMEANS_MINIBATCH_EPOCHS 3
+
+/*
+ * Hamerly-style bounds that let update_r skip the scan over all centers
+ * for points that provably stay in their cluster. Pruning only skips
+ * distance computations, the assignments are the same as a full scan.
+ */
+typedef struct
+{
+	double *lower;	       /* per object: lower bound of the distance to any other center */
+	double *half_gap;      /* per center: half the distance to the nearest other center */
+	POINT4D *prev_centers; /* centers before the last update_means */
+	uint8_t valid;	       /* bounds describe the current centers */
+} kmeans_bounds;
+
 static uint32_t kmeans(POINT4D *objs,
 		       uint32_t *clusters,
 		       uint32_t n,
@@ -63,8 +90,8 @@ improve_structure(POINT4D *objs,
 
 	POINT4D *temp_objs = lwalloc(sizeof(POINT4D) * n);
 	uint32_t *temp_clusters = lwalloc(sizeof(uint32_t) * n);
-	double *temp_radii = lwalloc(sizeof(double) * n);
-	POINT4D *temp_centers = lwalloc(sizeof(POINT4D) * n);
+	double temp_radii[2];
+	POINT4D temp_centers[2];
 
 	uint32_t new_k = k;
 
@@ -97,8 +124,6 @@ improve_structure(POINT4D *objs,
 		radii[new_k] = temp_radii[1];
 		new_k++;
 	}
-	lwfree(temp_centers);
-	lwfree(temp_radii);
 	lwfree(temp_clusters);
 	lwfree(temp_objs);
 	return new_k;
@@ -106,7 +131,13 @@ improve_structure(POINT4D *objs,
 
 /* Refresh mapping of point to closest cluster */
 static uint8_t
-update_r(POINT4D *objs, uint32_t *clusters, uint32_t n, POINT4D *centers, double *radii, uint32_t k)
+update_r(POINT4D *objs,
+	 uint32_t *clusters,
+	 uint32_t n,
+	 POINT4D *centers,
+	 double *radii,
+	 uint32_t k,
+	 kmeans_bounds *bounds)
 {
 	uint8_t converged = LW_TRUE;
 	if (radii)
@@ -116,8 +147,23 @@ update_r(POINT4D *objs, uint32_t *clusters, uint32_t n, POINT4D *centers, double
 	{
 		POINT4D obj = objs[i];
 
+		/* Keep the cluster if no other center can be as close as its own */
+		if (bounds && bounds->valid)
+		{
+			uint32_t cluster = clusters[i];
+			double distance = distance3d_sqr_pt4d_pt4d(&obj, &centers[cluster]);
+			double bound = FP_MAX(bounds->half_gap[cluster], bounds->lower[i]);
+			if (sqrt(distance) < bound * (1 - KMEANS_BOUND_EPSILON))
+			{
+				if (radii && radii[cluster] < distance)
+					radii[cluster] = distance;
+				continue;
+			}
+		}
+
 		/* Initialize with distance to first cluster */
 		double curr_distance = distance3d_sqr_pt4d_pt4d(&obj, &centers[0]);
+		double next_distance = DBL_MAX;
 		uint32_t curr_cluster = 0;
 
 		/* Check all other cluster centers and find the nearest */
@@ -126,10 +172,15 @@ update_r(POINT4D *objs, uint32_t *clusters, uint32_t n, POINT4D *centers, double
 			double distance = distance3d_sqr_pt4d_pt4d(&obj, &centers[cluster]);
 			if (distance < curr_distance)
 			{
+				next_distance = curr_distance;
 				curr_distance = distance;
 				curr_cluster = cluster;
 			}
+			else if (distance < next_distance)
+				next_distance = distance;
 		}
+		if (bounds)
+			bounds->lower[i] = sqrt(next_distance);
 
 		/* Store the nearest cluster this object is in */
 		if (clusters[i] != curr_cluster)
@@ -170,6 +221,46 @@ update_means(POINT4D *objs, uint32_t *clusters, uint32_t n, POINT4D *centers, ui
 	}
 }
 
+/*
+ * Move the bounds along with the centers update_means has just moved: each
+ * lower bound drops by the furthest any other center moved, and the gaps
+ * between centers are measured afresh.
+ */
+static void
+kmeans_bounds_update(kmeans_bounds *bounds, uint32_t *clusters, uint32_t n, POINT4D *centers, uint32_t k)
+{
+	double max_drift = 0, next_drift = 0;
+	uint32_t max_drift_cluster = 0;
+
+	for (uint32_t c = 0; c < k; c++)
+	{
+		double drift = sqrt(distance3d_sqr_pt4d_pt4d(&bounds->prev_centers[c], &centers[c]));
+		if (drift > max_drift)
+		{
+			next_drift = max_drift;
+			max_drift = drift;
+			max_drift_cluster = c;
+		}
+		else if (drift > next_drift)
+			next_drift = drift;
+	}
+	for (uint32_t i = 0; i < n; i++)
+		bounds->lower[i] -= (clusters[i] == max_drift_cluster) ? next_drift : max_drift;
+
+	for (uint32_t c = 0; c < k; c++)
+		bounds->half_gap[c] = DBL_MAX;
+	for (uint32_t c = 0; c < k; c++)
+		for (uint32_t d = c + 1; d < k; d++)
+		{
+			double half_gap = sqrt(distance3d_sqr_pt4d_pt4d(&centers[c], &centers[d])) / 2;
+			if (half_gap < bounds->half_gap[c])
+				bounds->half_gap[c] = half_gap;
+			if (half_gap < bounds->half_gap[d])
+				bounds->half_gap[d] = half_gap;
+		}
+	bounds->valid = LW_TRUE;
+}
+
 /* Assign initial clusters centroids heuristically */
 static void
 kmeans_init(POINT4D *objs, uint32_t n, POINT4D *centers, uint32_t k)
@@ -283,21 +374,33 @@ kmeans(POINT4D *objs,
 {
 	uint8_t converged = LW_FALSE;
 	uint32_t cur_k = min_k;
+	/* Centers can multiply up to n in improve_structure */
+	uint32_t max_k = max_radius ? n : min_k;
+	kmeans_bounds bounds;
+
+	bounds.lower = lwalloc(sizeof(double) * n);
+	bounds.half_gap = lwalloc(sizeof(double) * max_k);
+	bounds.prev_centers = lwalloc(sizeof(POINT4D) * max_k);
+	bounds.valid = LW_FALSE;
 
 	kmeans_init(objs, n, centers, cur_k);
 	/* One iteration of kmeans needs to happen without shortcuts to fully initialize structures */
-	update_r(objs, clusters, n, centers, radii, cur_k);
+	update_r(objs, clusters, n, centers, radii, cur_k, &bounds);
+	memcpy(bounds.prev_centers, centers, sizeof(POINT4D) * cur_k);
 	update_means(objs, clusters, n, centers, cur_k);
+	kmeans_bounds_update(&bounds, clusters, n, centers, cur_k);
 	for (uint32_t t = 0; t < KMEANS_MAX_ITERATIONS; t++)
 	{
 		/* Standard KMeans loop */
 		for (uint32_t i = 0; i < KMEANS_MAX_ITERATIONS; i++)
 		{
 			LW_ON_INTERRUPT(break);
-			converged = update_r(objs, clusters, n, centers, radii, cur_k);
+			converged = update_r(objs, clusters, n, centers, radii, cur_k, &bounds);
 			if (converged)
 				break;
+			memcpy(bounds.prev_centers, centers, sizeof(POINT4D) * cur_k);
 			update_means(objs, clusters, n, centers, cur_k);
+			kmeans_bounds_update(&bounds, clusters, n, centers, cur_k);
 		}
 		if (!converged || !max_radius)
 			break;
@@ -307,8 +410,14 @@ kmeans(POINT4D *objs,
 		if (new_k == cur_k)
 			break;
 		cur_k = new_k;
+		/* Split clusters have new centers, start the bounds over */
+		bounds.valid = LW_FALSE;
 	}
 
+	lwfree(bounds.prev_centers);
+	lwfree(bounds.half_gap);
+	lwfree(bounds.lower);
+
 	if (!converged)
 	{
 		lwerror("%s did not converge after %d iterations", __func__, KMEANS_MAX_ITERATIONS);
@@ -317,8 +426,85 @@ kmeans(POINT4D *objs,
 	return cur_k;
 }
 
+/*
+ * Mini-batch K-means (Sculley 2010): every round moves the centers
+ * towards a random sample of batch_size objects, with a per-center
+ * learning rate that decays as the center absorbs weight. Only the final
+ * assignment looks at all objects. Results depend on the samples drawn.
+ */
+static uint32_t
+kmeans_minibatch(POINT4D *objs,
+		 uint32_t *clusters,
+		 uint32_t n,
+		 POINT4D *centers,
+		 double *radii,
+		 uint32_t min_k,
+		 double max_radius,
+		 uint32_t batch_size)
+{
+	uint32_t cur_k = min_k;
+	uint32_t max_k = max_radius ? n : min_k;
+	uint32_t rounds = KMEANS_MINIBATCH_EPOCHS * (n / batch_size + 1);
+	POINT4D *batch = lwalloc(sizeof(POINT4D) * batch_size);
+	uint32_t *batch_clusters = lwalloc(sizeof(uint32_t) * batch_size);
+	double *weights = lwalloc(sizeof(double) * max_k);
+	memset(batch_clusters, 0, sizeof(uint32_t) * batch_size);
+
+	if (rounds > KMEANS_MAX_ITERATIONS)
+		rounds = KMEANS_MAX_ITERATIONS;
+
+	lwrandom_set_seed(0);
+	kmeans_init(objs, n, centers, cur_k);
+	for (uint32_t t = 0; t < KMEANS_MAX_ITERATIONS; t++)
+	{
+		memset(weights, 0, sizeof(double) * cur_k);
+		for (uint32_t r = 0; r < rounds; r++)
+		{
+			LW_ON_INTERRUPT(break);
+
+			/* Assign the whole batch against the same centers... */
+			for (uint32_t j = 0; j < batch_size; j++)
+			{
+				uint32_t i = (uint32_t)(lwrandom_uniform() * n);
+				batch[j] = objs[i < n ? i : n - 1];
+			}
+			update_r(batch, batch_clusters, batch_size, centers, NULL, cur_k, NULL);
+
+			/* ...then pull each center towards its members */
+			for (uint32_t j = 0; j < batch_size; j++)
+			{
+				const POINT4D *obj = &batch[j];
+				POINT4D *center = &centers[batch_clusters[j]];
+				double *weight = &weights[batch_clusters[j]];
+				double eta;
+
+				*weight += obj->m;
+				eta = obj->m / *weight;
+				center->x += (obj->x - center->x) * eta;
+				center->y += (obj->y - center->y) * eta;
+				center->z += (obj->z - center->z) * eta;
+			}
+		}
+
+		update_r(objs, clusters, n, centers, radii, cur_k, NULL);
+		if (!max_radius)
+			break;
+
+		/* Split oversized clusters and let the new centers settle too */
+		uint32_t new_k = improve_structure(objs, clusters, n, centers, radii, cur_k, max_radius);
+		if (new_k == cur_k)
+			break;
+		cur_k = new_k;
+	}
+
+	lwfree(weights);
+	lwfree(batch_clusters);
+	lwfree(batch);
+	return cur_k;
+}
+
 int *
-lwgeom_cluster_kmeans(const LWGEOM **geoms, uint32_t n, uint32_t k, double max_radius)
+lwgeom_cluster_kmeans(const LWGEOM **geoms, uint32_t n, uint32_t k, double max_radius, uint32_t batch_size)
 {
 	uint32_t num_non_empty = 0;
 
@@ -347,13 +533,16 @@ lwgeom_cluster_kmeans(const LWGEOM **geoms, uint32_t n, uint32_t k, double max_r
 	for (uint32_t i = 0; i < n; i++)
 		clusters[i] = KMEANS_NULL_CLUSTER;
 
+	/* Without a radius limit there are never more than k clusters */
+	uint32_t max_k = max_radius ? n : k;
+
 	/* An array of clusters centers for the algorithm. */
-	POINT4D *centers = lwalloc(sizeof(POINT4D) * n);
-	memset(centers, 0, sizeof(POINT4D) * n);
+	POINT4D *centers = lwalloc(sizeof(POINT4D) * max_k);
+	memset(centers, 0, sizeof(POINT4D) * max_k);
 
 	/* An array of clusters radii for the algorithm. */
-	double *radii = lwalloc(sizeof(double) * n);
-	memset(radii, 0, sizeof(double) * n);
+	double *radii = lwalloc(sizeof(double) * max_k);
+	memset(radii, 0, sizeof(double) * max_k);
 
 	/* Prepare the list of object pointers for K-means */
 	for (uint32_t i = 0; i < n; i++)
@@ -426,7 +615,15 @@ lwgeom_cluster_kmeans(const LWGEOM **geoms, uint32_t n, uint32_t k, double max_r
 	{
 		uint32_t *clusters_dense = lwalloc(sizeof(uint32_t) * num_non_empty);
 		memset(clusters_dense, 0, sizeof(uint32_t) * num_non_empty);
-		uint32_t output_cluster_count = kmeans(objs_dense, clusters_dense, num_non_empty, centers, radii, k, max_radius);
+		uint32_t output_cluster_count;
+
+		/* Mini-batches only pay off when they are smaller than the input */
+		if (batch_size > 0 && batch_size < num_non_empty)
+			output_cluster_count = kmeans_minibatch(
+			    objs_dense, clusters_dense, num_non_empty, centers, radii, k, max_radius, batch_size);
+		else
+			output_cluster_count =
+			    kmeans(objs_dense, clusters_dense, num_non_empty, centers, radii, k, max_radius);
 
 		uint32_t d = 0;
 		for (uint32_t i = 0; i < n; i++)
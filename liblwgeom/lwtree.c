@@ -27,6 +27,10 @@
 #include "lwtree.h"
 #include "measures.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 static inline int
 rect_node_is_leaf(const RECT_NODE *node)
 {
@@ -70,6 +74,12 @@ rect_tree_free(RECT_NODE *node)
 {
 	int i;
 	if (!node) return;
+	/* Packed trees are one allocation, headed by the root */
+	if (node->packed)
+	{
+		lwfree(node);
+		return;
+	}
 	if (!rect_node_is_leaf(node))
 	{
 		for (i = 0; i < node->i.num_nodes; i++)
@@ -541,6 +551,7 @@ rect_node_leaf_new(const POINTARRAY *pa, int seg_num, int geom_type)
 	node = lwalloc(sizeof(RECT_NODE));
 	node->type = RECT_NODE_LEAF_TYPE;
 	node->geom_type = geom_type;
+	node->packed = 0;
 	node->xmin = gbox.xmin;
 	node->xmax = gbox.xmax;
 	node->ymin = gbox.ymin;
@@ -576,9 +587,11 @@ rect_node_internal_new(const RECT_NODE *seed)
 	node->ymax = seed->ymax;
 	node->geom_type = seed->geom_type;
 	node->type = RECT_NODE_INTERNAL_TYPE;
+	node->packed = 0;
 	node->i.num_nodes = 0;
 	node->i.ring_type = RECT_NODE_RING_NONE;
 	node->i.sorted = 0;
+	node->i.boxes = NULL;
 	return node;
 }
 
@@ -889,6 +902,89 @@ rect_tree_from_lwgeom(const LWGEOM *lwgeom)
 	return NULL;
 }
 
+static uint32_t
+rect_tree_count_nodes(const RECT_NODE *node, uint32_t *num_internal)
+{
+	uint32_t i, n = 1;
+	if (rect_node_is_leaf(node))
+		return n;
+	*num_internal += 1;
+	for (i = 0; i < (uint32_t)node->i.num_nodes; i++)
+		n += rect_tree_count_nodes(node->i.nodes[i], num_internal);
+	return n;
+}
+
+/*
+* Copy the child bounds of an internal node into its
+* side-by-side box arrays. Needs to be re-run any time
+* the children are re-ordered.
+*/
+static void
+rect_node_boxes_update(RECT_NODE *node)
+{
+	int i;
+	RECT_NODE_BOXES *b = node->i.boxes;
+	for (i = 0; i < node->i.num_nodes; i++)
+	{
+		const RECT_NODE *c = node->i.nodes[i];
+		b->xmin[i] = c->xmin;
+		b->xmax[i] = c->xmax;
+		b->ymin[i] = c->ymin;
+		b->ymax[i] = c->ymax;
+	}
+}
+
+/*
+* Nodes are laid out breadth-first in one block, so the
+* children of each node are adjacent in memory, followed by
+* one RECT_NODE_BOXES per internal node. The root is the
+* first node of the block, so rect_tree_free() on the root
+* releases everything at once.
+*/
+RECT_NODE *
+rect_tree_pack(RECT_NODE *tree)
+{
+	uint32_t num_nodes, num_internal = 0;
+	uint32_t head, tail, box = 0;
+	const RECT_NODE **src;
+	RECT_NODE *nodes;
+	RECT_NODE_BOXES *boxes;
+
+	if (!tree || tree->packed)
+		return tree;
+
+	num_nodes = rect_tree_count_nodes(tree, &num_internal);
+	nodes = lwalloc(sizeof(RECT_NODE) * num_nodes + sizeof(RECT_NODE_BOXES) * num_internal);
+	boxes = (RECT_NODE_BOXES*)(nodes + num_nodes);
+	src = lwalloc(sizeof(RECT_NODE*) * num_nodes);
+
+	/* The output array doubles as the breadth-first queue */
+	src[0] = tree;
+	nodes[0] = *tree;
+	for (head = 0, tail = 1; head < tail; head++)
+	{
+		RECT_NODE *node = nodes + head;
+		int i;
+		node->packed = 1;
+		if (rect_node_is_leaf(node))
+			continue;
+
+		for (i = 0; i < node->i.num_nodes; i++)
+		{
+			src[tail] = src[head]->i.nodes[i];
+			nodes[tail] = *(src[tail]);
+			node->i.nodes[i] = nodes + tail;
+			tail++;
+		}
+		node->i.boxes = boxes + box++;
+		rect_node_boxes_update(node);
+	}
+
+	lwfree(src);
+	rect_tree_free(tree);
+	return nodes;
+}
+
 /*
 * Get an actual coordinate point from a tree to use
 * for point-in-polygon testing.
@@ -917,6 +1013,49 @@ rect_node_intersects(const RECT_NODE *n1, const RECT_NODE *n2)
 	}
 }
 
+/*
+* Test all the children of an internal node against another
+* node in one pass, returning a bit mask of the children that
+* overlap it. Trees that are not packed have no side-by-side
+* child bounds, so all children are reported as candidates
+* and get checked one at a time during recursion.
+*/
+static inline uint32_t
+rect_node_children_intersect(const RECT_NODE *parent, const RECT_NODE *n)
+{
+	const RECT_NODE_BOXES *b = parent->i.boxes;
+	int i = 0, num_nodes = parent->i.num_nodes;
+	uint32_t mask = 0;
+
+	if (!b)
+		return (1u << num_nodes) - 1;
+
+#if defined(__SSE2__)
+	{
+		const __m128d nxmin = _mm_set1_pd(n->xmin);
+		const __m128d nxmax = _mm_set1_pd(n->xmax);
+		const __m128d nymin = _mm_set1_pd(n->ymin);
+		const __m128d nymax = _mm_set1_pd(n->ymax);
+		for (; i + 1 < num_nodes; i += 2)
+		{
+			__m128d out = _mm_or_pd(
+				_mm_or_pd(_mm_cmpgt_pd(_mm_loadu_pd(b->xmin + i), nxmax),
+				          _mm_cmpgt_pd(nxmin, _mm_loadu_pd(b->xmax + i))),
+				_mm_or_pd(_mm_cmpgt_pd(_mm_loadu_pd(b->ymin + i), nymax),
+				          _mm_cmpgt_pd(nymin, _mm_loadu_pd(b->ymax + i))));
+			mask |= (uint32_t)(~_mm_movemask_pd(out) & 0x3) << i;
+		}
+	}
+#endif
+	for (; i < num_nodes; i++)
+	{
+		if (!(b->xmin[i] > n->xmax || n->xmin > b->xmax[i] ||
+		      b->ymin[i] > n->ymax || n->ymin > b->ymax[i]))
+			mask |= 1u << i;
+	}
+	return mask;
+}
+
 #if POSTGIS_DEBUG_LEVEL >= 4
 static char *
 rect_node_to_str(const RECT_NODE *n)
@@ -956,16 +1095,22 @@ rect_tree_intersects_tree_recursive(RECT_NODE *n1, RECT_NODE *n2)
 		}
 		else if (rect_node_is_leaf(n2) && !rect_node_is_leaf(n1))
 		{
+			uint32_t mask = rect_node_children_intersect(n1, n2);
 			for (i = 0; i < n1->i.num_nodes; i++)
 			{
+				if (!(mask & (1u << i)))
+					continue;
 				if (rect_tree_intersects_tree_recursive(n1->i.nodes[i], n2))
 					return LW_TRUE;
 			}
 		}
 		else if (rect_node_is_leaf(n1) && !rect_node_is_leaf(n2))
 		{
+			uint32_t mask = rect_node_children_intersect(n2, n1);
 			for (i = 0; i < n2->i.num_nodes; i++)
 			{
+				if (!(mask & (1u << i)))
+					continue;
 				if (rect_tree_intersects_tree_recursive(n2->i.nodes[i], n1))
 					return LW_TRUE;
 			}
@@ -974,8 +1119,11 @@ rect_tree_intersects_tree_recursive(RECT_NODE *n1, RECT_NODE *n2)
 		{
 			for (j = 0; j < n1->i.num_nodes; j++)
 			{
+				uint32_t mask = rect_node_children_intersect(n2, n1->i.nodes[j]);
 				for (i = 0; i < n2->i.num_nodes; i++)
 				{
+					if (!(mask & (1u << i)))
+						continue;
 					if (rect_tree_intersects_tree_recursive(n2->i.nodes[i], n1->i.nodes[j]))
 						return LW_TRUE;
 				}
@@ -1087,6 +1235,51 @@ rect_node_max_distance(const RECT_NODE *n1, const RECT_NODE *n2)
 	return sqrt(dx*dx + dy*dy);
 }
 
+/*
+* Minimum distance from each child of an internal node to another
+* node, computed for all the children in one pass. Trees that are
+* not packed report zero, so nothing is pruned ahead of recursion.
+*/
+static inline void
+rect_node_children_min_distance(const RECT_NODE *parent, const RECT_NODE *n, double *d)
+{
+	const RECT_NODE_BOXES *b = parent->i.boxes;
+	int i = 0, num_nodes = parent->i.num_nodes;
+
+	if (!b)
+	{
+		for (i = 0; i < num_nodes; i++)
+			d[i] = 0.0;
+		return;
+	}
+
+#if defined(__SSE2__)
+	{
+		const __m128d zero = _mm_setzero_pd();
+		const __m128d nxmin = _mm_set1_pd(n->xmin);
+		const __m128d nxmax = _mm_set1_pd(n->xmax);
+		const __m128d nymin = _mm_set1_pd(n->ymin);
+		const __m128d nymax = _mm_set1_pd(n->ymax);
+		for (; i + 1 < num_nodes; i += 2)
+		{
+			__m128d dx = _mm_max_pd(_mm_sub_pd(_mm_loadu_pd(b->xmin + i), nxmax),
+			                        _mm_sub_pd(nxmin, _mm_loadu_pd(b->xmax + i)));
+			__m128d dy = _mm_max_pd(_mm_sub_pd(_mm_loadu_pd(b->ymin + i), nymax),
+			                        _mm_sub_pd(nymin, _mm_loadu_pd(b->ymax + i)));
+			dx = _mm_max_pd(dx, zero);
+			dy = _mm_max_pd(dy, zero);
+			_mm_storeu_pd(d + i, _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy))));
+		}
+	}
+#endif
+	for (; i < num_nodes; i++)
+	{
+		double dx = FP_MAX(FP_MAX(b->xmin[i] - n->xmax, n->xmin - b->xmax[i]), 0.0);
+		double dy = FP_MAX(FP_MAX(b->ymin[i] - n->ymax, n->ymin - b->ymax[i]), 0.0);
+		d[i] = sqrt(dx*dx + dy*dy);
+	}
+}
+
 /*
 * Leaf nodes represent individual edges from the original shape.
 * As such, they can be either points (if original was a (multi)point)
@@ -1266,6 +1459,8 @@ rect_tree_node_sort(RECT_NODE *n1, RECT_NODE *n2)
 		         n1->i.num_nodes,
 		         sizeof(RECT_NODE*),
 		         rect_tree_node_sort_cmp);
+		if (n1->i.boxes)
+			rect_node_boxes_update(n1);
 	}
 	if (!rect_node_is_leaf(n2) && ! n2->i.sorted)
 	{
@@ -1283,6 +1478,8 @@ rect_tree_node_sort(RECT_NODE *n1, RECT_NODE *n2)
 		         n2->i.num_nodes,
 		         sizeof(RECT_NODE*),
 		         rect_tree_node_sort_cmp);
+		if (n2->i.boxes)
+			rect_node_boxes_update(n2);
 	}
 }
 
@@ -1319,19 +1516,29 @@ rect_tree_distance_tree_recursive(RECT_NODE *n1, RECT_NODE *n2, RECT_TREE_DISTAN
 	{
 		int i, j;
 		double d_min = FLT_MAX;
+		double d[RECT_NODE_SIZE];
 		rect_tree_node_sort(n1, n2);
+		/* Children whose bounds are further than the current */
+		/* max_dist cannot hold the winner, skip them without */
+		/* recursing into them */
 		if (rect_node_is_leaf(n1) && !rect_node_is_leaf(n2))
 		{
+			rect_node_children_min_distance(n2, n1, d);
 			for (i = 0; i < n2->i.num_nodes; i++)
 			{
+				if (d[i] > state->max_dist)
+					continue;
 				min = rect_tree_distance_tree_recursive(n1, n2->i.nodes[i], state);
 				d_min = FP_MIN(d_min, min);
 			}
 		}
 		else if (rect_node_is_leaf(n2) && !rect_node_is_leaf(n1))
 		{
+			rect_node_children_min_distance(n1, n2, d);
 			for (i = 0; i < n1->i.num_nodes; i++)
 			{
+				if (d[i] > state->max_dist)
+					continue;
 				min = rect_tree_distance_tree_recursive(n1->i.nodes[i], n2, state);
 				d_min = FP_MIN(d_min, min);
 			}
@@ -1340,8 +1547,11 @@ rect_tree_distance_tree_recursive(RECT_NODE *n1, RECT_NODE *n2, RECT_TREE_DISTAN
 		{
 			for (i = 0; i < n1->i.num_nodes; i++)
 			{
+				rect_node_children_min_distance(n2, n1->i.nodes[i], d);
 				for (j = 0; j < n2->i.num_nodes; j++)
 				{
+					if (d[j] > state->max_dist)
+						continue;
 					min = rect_tree_distance_tree_recursive(n1->i.nodes[i], n2->i.nodes[j], state);
 					d_min = FP_MIN(d_min, min);
 				}
@@ -54,18 +54,33 @@ typedef struct
 
 struct rect_node;
 
+/*
+* Child bounds of an internal node, stored side by side so that
+* all the children can be tested against another node in one pass.
+* Only present in packed trees, see rect_tree_pack().
+*/
+typedef struct
+{
+	double xmin[RECT_NODE_SIZE];
+	double xmax[RECT_NODE_SIZE];
+	double ymin[RECT_NODE_SIZE];
+	double ymax[RECT_NODE_SIZE];
+} RECT_NODE_BOXES;
+
 typedef struct
 {
 	int num_nodes;
 	RECT_NODE_RING_TYPE ring_type;
 	struct rect_node *nodes[RECT_NODE_SIZE];
 	int sorted;
+	RECT_NODE_BOXES *boxes;
 } RECT_NODE_INTERNAL;
 
 typedef struct rect_node
 {
 	RECT_NODE_TYPE type;
 	unsigned char geom_type;
+	unsigned char packed;
 	double xmin;
 	double xmax;
 	double ymin;
@@ -102,6 +117,15 @@ int rect_tree_intersects_tree(RECT_NODE *tree1, RECT_NODE *tree2);
 */
 double rect_tree_distance_tree(RECT_NODE *n1, RECT_NODE *n2, double threshold);
 
+/**
+* Copy a tree into a single contiguous allocation, with the
+* children of every node stored next to each other and their
+* bounds available in RECT_NODE_BOXES form. The input tree is
+* freed. Use for trees that are built once and queried many
+* times, like cached trees.
+*/
+RECT_NODE * rect_tree_pack(RECT_NODE *tree);
+
 /**
 * Free the rect-tree memory
 */
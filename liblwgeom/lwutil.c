@@ -169,6 +169,25 @@ lwgeom_set_handlers(lwallocator allocator, lwreallocator reallocator,
 	if ( noticereporter ) lwnotice_var = noticereporter;
 }
 
+/**
+ * Set by programs whose allocator can hand out arenas, see
+ * lwgeom_set_arena_owner(). NULL (the default) means no memory
+ * is in an arena.
+ */
+static lwarenaowner lwarena_owner = NULL;
+
+void
+lwgeom_set_arena_owner(lwarenaowner owner) {
+
+	lwarena_owner = owner;
+}
+
+int
+lwgeom_arena_owns(const void *mem)
+{
+	return lwarena_owner && mem && lwarena_owner(mem);
+}
+
 void
 lwgeom_set_debuglogger(lwdebuglogger debuglogger) {
 
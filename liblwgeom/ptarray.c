@@ -31,6 +31,10 @@
 #include <limits.h>
 #include <math.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "../postgis_config.h"
 /*#define POSTGIS_DEBUG_LEVEL 4*/
 #include "liblwgeom_internal.h"
@@ -2285,8 +2289,34 @@ ptarray_length_2d(const POINTARRAY *pts)
 	if ( pts->npoints < 2 ) return 0.0;
 
 	frm = getPoint2d_cp(pts, 0);
+	i = 1;
 
-	for ( i=1; i < pts->npoints; i++ )
+#if defined(__SSE2__)
+	/*
+	 * Take the square roots of two segments at a time, but add them to
+	 * the total one by one in segment order, so the sum is the same as
+	 * the scalar loop's.
+	 */
+	{
+		__m128d a = _mm_loadu_pd((const double *)frm);
+		for ( ; i + 1 < pts->npoints; i += 2 )
+		{
+			__m128d b = _mm_loadu_pd((const double *)getPoint2d_cp(pts, i));
+			__m128d c = _mm_loadu_pd((const double *)getPoint2d_cp(pts, i + 1));
+			__m128d d1 = _mm_sub_pd(a, b);
+			__m128d d2 = _mm_sub_pd(b, c);
+			d1 = _mm_mul_pd(d1, d1);
+			d2 = _mm_mul_pd(d2, d2);
+			__m128d len = _mm_sqrt_pd(_mm_add_pd(_mm_unpacklo_pd(d1, d2), _mm_unpackhi_pd(d1, d2)));
+			dist += _mm_cvtsd_f64(len);
+			dist += _mm_cvtsd_f64(_mm_unpackhi_pd(len, len));
+			a = c;
+		}
+		frm = getPoint2d_cp(pts, i - 1);
+	}
+#endif
+
+	for ( ; i < pts->npoints; i++ )
 	{
 		to = getPoint2d_cp(pts, i);
 
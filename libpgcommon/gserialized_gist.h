@@ -114,6 +114,7 @@ bool box2df_overbelow(const BOX2DF *a, const BOX2DF *b);
 bool box2df_below(const BOX2DF *a, const BOX2DF *b);
 bool box2df_above(const BOX2DF *a, const BOX2DF *b);
 bool box2df_overabove(const BOX2DF *a, const BOX2DF *b);
+double box2df_distance(const BOX2DF *a, const BOX2DF *b);
 
 void gidx_validate(GIDX *b);
 void gidx_set_unknown(GIDX *a);
@@ -12,6 +12,7 @@
 
 #include "postgres.h"
 
+#include "access/hash.h"
 #include "catalog/pg_type.h" /* for CSTRINGOID */
 #include "executor/spi.h"
 #include "fmgr.h"
@@ -464,3 +465,145 @@ GetSRIDCacheBySRS(FunctionCallInfo fcinfo, const char *srs)
 
 	return arg->srid;
 }
+
+/******************************************************************************/
+
+static void
+BackendCacheEvict(BackendCache *cache, BackendCacheEntry *entry)
+{
+	if (entry->value)
+		cache->value_free(entry->value);
+	if (entry->key)
+		pfree(entry->key);
+	memset(entry, 0, sizeof(BackendCacheEntry));
+}
+
+/*
+* Return the slot holding the entry for lwgeom, or -1 when it is
+* not cached. On a miss, *key and *hash are set up for handing the
+* new entry to BackendCacheAdd, or *key is NULL when the cache is
+* disabled.
+*/
+int32
+BackendCacheFind(BackendCache *cache, const LWGEOM *lwgeom, GSERIALIZED **key, uint32 *hash)
+{
+	size_t key_size;
+	int32 i;
+
+	*key = NULL;
+	if (*(cache->size) <= 0)
+		return -1;
+
+	if (!cache->entries)
+	{
+		cache->context = AllocSetContextCreate(TopMemoryContext, cache->name, ALLOCSET_DEFAULT_SIZES);
+		cache->entries = MemoryContextAllocZero(cache->context, sizeof(BackendCacheEntry) * BACKEND_CACHE_MAX);
+	}
+
+	*key = gserialized_from_lwgeom((LWGEOM *)lwgeom, &key_size);
+	*hash = DatumGetUInt32(hash_any((unsigned char *)*key, key_size));
+
+	for (i = 0; i < BACKEND_CACHE_MAX; i++)
+	{
+		BackendCacheEntry *entry = cache->entries + i;
+		if (!entry->key)
+			continue;
+
+		if (entry->hash == *hash &&
+		    VARSIZE(entry->key) == VARSIZE(*key) &&
+		    memcmp(entry->key, *key, VARSIZE(*key)) == 0)
+		{
+			pfree(*key);
+			*key = NULL;
+			entry->last_used = ++cache->clock;
+			cache->hits++;
+			return i;
+		}
+
+		/* The GUC may have been lowered, retire out of range slots */
+		if (i >= *(cache->size) && !entry->refcount)
+			BackendCacheEvict(cache, entry);
+	}
+
+	cache->misses++;
+	return -1;
+}
+
+/*
+* Store value under the key from BackendCacheFind, in an empty
+* slot or in place of the least recently used idle entry. The key
+* is freed. Returns the slot, or -1 when every slot is in use, in
+* which case the value still belongs to the caller.
+*/
+int32
+BackendCacheAdd(BackendCache *cache, GSERIALIZED *key, uint32 hash, void *value)
+{
+	BackendCacheEntry *entry;
+	int32 i, slot = -1;
+
+	if (!key)
+		return -1;
+
+	for (i = 0; i < *(cache->size) && i < BACKEND_CACHE_MAX; i++)
+	{
+		entry = cache->entries + i;
+		if (!entry->key)
+		{
+			slot = i;
+			break;
+		}
+		if (!entry->refcount &&
+		    (slot < 0 || entry->last_used < cache->entries[slot].last_used))
+			slot = i;
+	}
+
+	if (slot < 0)
+	{
+		pfree(key);
+		return -1;
+	}
+
+	entry = cache->entries + slot;
+	BackendCacheEvict(cache, entry);
+
+	entry->key = MemoryContextAlloc(cache->context, VARSIZE(key));
+	memcpy(entry->key, key, VARSIZE(key));
+	pfree(key);
+	entry->hash = hash;
+	entry->value = value;
+	entry->last_used = ++cache->clock;
+	return slot;
+}
+
+/* Drop a reference taken on the entry in a slot */
+void
+BackendCacheRelease(BackendCache *cache, int32 slot)
+{
+	BackendCacheEntry *entry;
+
+	if (!cache->entries || slot < 0 || slot >= BACKEND_CACHE_MAX)
+		elog(ERROR, "%s: invalid backend cache slot %d", __func__, slot);
+
+	entry = cache->entries + slot;
+	if (!entry->refcount)
+		elog(ERROR, "%s: backend cache slot %d is not in use", __func__, slot);
+
+	entry->refcount--;
+}
+
+/* Number of entries in the cache */
+int32
+BackendCacheCount(const BackendCache *cache)
+{
+	int32 i, entries = 0;
+
+	if (cache->entries)
+	{
+		for (i = 0; i < BACKEND_CACHE_MAX; i++)
+		{
+			if (cache->entries[i].key)
+				entries++;
+		}
+	}
+	return entries;
+}
@@ -26,10 +26,11 @@ enum CacheEntryEnum {
 	CIRC_CACHE_ENTRY    = 3,
 	RECT_CACHE_ENTRY    = 4,
 	SRSDESC_CACHE_ENTRY = 5,
-	SRID_CACHE_ENTRY    = 6
+	SRID_CACHE_ENTRY    = 6,
+	KNN_CACHE_ENTRY     = 7
 };
 
-#define NUM_CACHE_ENTRIES 7
+#define NUM_CACHE_ENTRIES 8
 
 
 /* Returns the MemoryContext used to store the caches */
@@ -136,3 +137,42 @@ typedef struct {
 
 int32_t GetSRIDCacheBySRS(FunctionCallInfo fcinfo, const char *srs);
 
+
+/******************************************************************************/
+
+/*
+* Backend cache
+*
+* An optional backend-lifetime array of objects keyed on a
+* serialized geometry, so later statements in the same backend
+* can reuse what earlier ones built. The number of slots in use
+* is read from a GUC, up to BACKEND_CACHE_MAX. Entries are evicted
+* least recently used first, skipping those with references taken.
+*/
+#define BACKEND_CACHE_MAX 1024
+
+typedef struct
+{
+	uint32 hash;
+	GSERIALIZED *key;
+	void *value;
+	uint32 refcount;
+	uint64 last_used;
+} BackendCacheEntry;
+
+typedef struct
+{
+	const char *name;                /* Name of the memory context */
+	const int *size;                 /* GUC setting the number of slots, zero disables */
+	void (*value_free)(void *value); /* Frees the value of an evicted entry */
+	MemoryContext context;           /* Holds the keys, and the values if their owner wants */
+	BackendCacheEntry *entries;
+	uint64 clock;
+	uint64 hits;
+	uint64 misses;
+} BackendCache;
+
+int32 BackendCacheFind(BackendCache *cache, const LWGEOM *lwgeom, GSERIALIZED **key, uint32 *hash);
+int32 BackendCacheAdd(BackendCache *cache, GSERIALIZED *key, uint32 hash, void *value);
+void BackendCacheRelease(BackendCache *cache, int32 slot);
+int32 BackendCacheCount(const BackendCache *cache);
@@ -352,6 +352,79 @@ pg_free(void *ptr)
 	pfree(ptr);
 }
 
+/*
+* Arenas are Generation memory contexts stacked on CurrentMemoryContext.
+* Everything liblwgeom allocates between lwpg_arena_open() and
+* lwpg_arena_close() lands in the innermost one and is released with it,
+* so lwgeom_free() can skip walking those geometries. As with any palloc,
+* nothing allocated in an arena may outlive it, and geometries built
+* before the arena must not be handed arena memory (eg. a cached bbox).
+* If an ERROR escapes, the arena goes with its parent context and the
+* reset callback unlinks it from the stack.
+*/
+typedef struct PgArena
+{
+	MemoryContext context;
+	MemoryContext old_context;
+	struct PgArena *prev;
+	MemoryContextCallback callback;
+} PgArena;
+
+static PgArena *pg_arena = NULL;
+
+static void
+pg_arena_unlink(void *arg)
+{
+	PgArena *arena = (PgArena *)arg;
+	PgArena **link = &pg_arena;
+
+	while (*link && *link != arena)
+		link = &(*link)->prev;
+	if (*link)
+		*link = arena->prev;
+}
+
+static int
+pg_arena_owns(const void *mem)
+{
+	return pg_arena && GetMemoryChunkContext((void *)mem) == pg_arena->context;
+}
+
+void
+lwpg_arena_open(void)
+{
+	MemoryContext context;
+	PgArena *arena;
+
+#if POSTGIS_PGSQL_VERSION >= 150
+	context = GenerationContextCreate(CurrentMemoryContext, "PostGIS Arena",
+	                                  ALLOCSET_DEFAULT_SIZES);
+#else
+	context = GenerationContextCreate(CurrentMemoryContext, "PostGIS Arena",
+	                                  SLAB_DEFAULT_BLOCK_SIZE);
+#endif
+
+	arena = MemoryContextAlloc(context, sizeof(PgArena));
+	arena->context = context;
+	arena->old_context = MemoryContextSwitchTo(context);
+	arena->prev = pg_arena;
+	arena->callback.func = pg_arena_unlink;
+	arena->callback.arg = arena;
+	MemoryContextRegisterResetCallback(context, &arena->callback);
+	pg_arena = arena;
+}
+
+void
+lwpg_arena_close(void)
+{
+	if (!pg_arena)
+		elog(ERROR, "%s: no arena is open", __func__);
+
+	MemoryContextSwitchTo(pg_arena->old_context);
+	/* The reset callback pops the arena */
+	MemoryContextDelete(pg_arena->context);
+}
+
 static void
 pg_format_message(char *errmsg, size_t errmsg_size, const char *fmt, va_list ap)
 {
@@ -427,6 +500,7 @@ pg_install_lwgeom_handlers(void)
 {
 	/* install PostgreSQL handlers */
 	lwgeom_set_handlers(pg_alloc, pg_realloc, pg_free, pg_error, pg_notice);
+	lwgeom_set_arena_owner(pg_arena_owns);
 	/*
 	If you want to try with malloc:
 	lwgeom_set_handlers(NULL, NULL, NULL, pg_error, pg_notice);
@@ -86,6 +86,13 @@ const char *postgis_spatial_ref_sys(void);
 /* Install PostgreSQL handlers for liblwgeom use */
 void pg_install_lwgeom_handlers(void);
 
+/*
+* Allocate everything up to the matching close in a scratch memory
+* context that is released in one go. Arenas nest.
+*/
+void lwpg_arena_open(void);
+void lwpg_arena_close(void);
+
 /* Argument handling macros */
 #define PG_GETARG_GSERIALIZED_P(varno) ((GSERIALIZED *)PG_DETOAST_DATUM(PG_GETARG_DATUM(varno)))
 
@@ -135,13 +135,24 @@ GetPROJSRSCache(void)
 static LWPROJ *
 GetProjectionFromPROJCache(PROJSRSCache *cache, int32_t srid_from, int32_t srid_to)
 {
-	uint32_t i;
+	uint32_t i = cache->PROJSRSCacheLast;
+
+	/* Rows of a table usually all ask for the same transform */
+	if (i < cache->PROJSRSCacheCount &&
+	    cache->PROJSRSCache[i].srid_from == srid_from &&
+	    cache->PROJSRSCache[i].srid_to == srid_to)
+	{
+		cache->PROJSRSCache[i].hits++;
+		return cache->PROJSRSCache[i].projection;
+	}
+
 	for (i = 0; i < cache->PROJSRSCacheCount; i++)
 	{
 		if (cache->PROJSRSCache[i].srid_from == srid_from &&
 		    cache->PROJSRSCache[i].srid_to == srid_to)
 		{
 			cache->PROJSRSCache[i].hits++;
+			cache->PROJSRSCacheLast = i;
 			return cache->PROJSRSCache[i].projection;
 		}
 	}
@@ -498,6 +509,7 @@ AddToPROJSRSCache(PROJSRSCache *PROJCache, int32_t srid_from, int32_t srid_to)
 	PROJCache->PROJSRSCache[cache_position].srid_to = srid_to;
 	PROJCache->PROJSRSCache[cache_position].projection = projection;
 	PROJCache->PROJSRSCache[cache_position].hits = hits;
+	PROJCache->PROJSRSCacheLast = cache_position;
 
 	MemoryContextSwitchTo(oldContext);
 	return projection;
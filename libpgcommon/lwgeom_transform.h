@@ -44,6 +44,8 @@ typedef struct struct_PROJSRSCache
 {
 	PROJSRSCacheItem PROJSRSCache[PROJ_CACHE_ITEMS];
 	uint32_t PROJSRSCacheCount;
+	/* Position of the last entry looked up, checked before scanning */
+	uint32_t PROJSRSCacheLast;
 	MemoryContext PROJSRSCacheContext;
 }
 PROJSRSCache;
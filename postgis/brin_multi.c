@@ -0,0 +1,463 @@
+#include "postgis_brin.h"
+
+#include "access/brin_internal.h"
+#include "access/reloptions.h"
+#include "access/skey.h"
+#include "access/stratnum.h"
+#include "catalog/pg_type.h"
+#include "utils/memutils.h"
+#include "utils/typcache.h"
+
+/*
+ * Multi-box BRIN summaries.
+ *
+ * The inclusion opclasses keep a single box per block range, so one row
+ * far away from its neighbours stretches the summary over the whole
+ * extent and the range can no longer be skipped.  Like the minmax-multi
+ * opclasses of PostgreSQL, these opclasses keep a small set of boxes per
+ * range instead: a box not covered by one of the stored boxes is added to
+ * the set, and once the set holds more than "boxes_per_range" boxes the
+ * pair with the smallest union is merged.
+ *
+ * Every box of a summary has the number of dimensions of the opclass and
+ * is laid out as a GIDX, min and max for each dimension.  Dimensions the
+ * geometry does not have are padded with -FLT_MAX/FLT_MAX, which the
+ * overlap test ignores as gidx_overlaps() does.  The summary is stored as
+ * a bytea, so no new storage type is needed.
+ */
+
+#define BRIN_MULTI_BOXES_DEFAULT 8
+#define BRIN_MULTI_BOXES_MIN 2
+#define BRIN_MULTI_BOXES_MAX 64
+
+typedef struct
+{
+	int32 vl_len_;  /* varlena header (do not touch directly!) */
+	int32 ndims;    /* number of dimensions of every box */
+	int32 nboxes;   /* number of boxes in the summary */
+	float c[FLEXIBLE_ARRAY_MEMBER]; /* min/max of each dimension of each box */
+} BrinMultiBoxes;
+
+#define BRIN_MULTI_SIZE(ndims, nboxes) \
+	(offsetof(BrinMultiBoxes, c) + sizeof(float) * 2 * (ndims) * (nboxes))
+#define BRIN_MULTI_BOX(summary, i) ((summary)->c + 2 * (summary)->ndims * (i))
+
+typedef struct
+{
+	int32 vl_len_;  /* varlena header (do not touch directly!) */
+	int boxes_per_range;
+} BrinMultiOptions;
+
+static int
+brin_multi_boxes_per_range(FunctionCallInfo fcinfo)
+{
+	if (PG_HAS_OPCLASS_OPTIONS())
+		return ((BrinMultiOptions *) PG_GET_OPCLASS_OPTIONS())->boxes_per_range;
+	return BRIN_MULTI_BOXES_DEFAULT;
+}
+
+static inline bool
+brin_multi_dim_is_padded(const float *box, int dim)
+{
+	return box[2 * dim + 1] == FLT_MAX;
+}
+
+/* Copy a GIDX into a summary box of ndims dimensions */
+static void
+brin_multi_box_from_gidx(float *box, GIDX *gidx, int ndims)
+{
+	int dims_gidx = GIDX_NDIMS(gidx);
+	int i;
+
+	for (i = 0; i < ndims; i++)
+	{
+		if (i < dims_gidx)
+		{
+			box[2 * i] = GIDX_GET_MIN(gidx, i);
+			box[2 * i + 1] = GIDX_GET_MAX(gidx, i);
+		}
+		else
+		{
+			box[2 * i] = -1 * FLT_MAX;
+			box[2 * i + 1] = FLT_MAX;
+		}
+	}
+}
+
+static bool
+brin_multi_box_contains(const float *a, const float *b, int ndims)
+{
+	int i;
+
+	for (i = 0; i < ndims; i++)
+	{
+		if (a[2 * i] > b[2 * i] || a[2 * i + 1] < b[2 * i + 1])
+			return false;
+	}
+	return true;
+}
+
+static bool
+brin_multi_box_overlaps(const float *a, const float *b, int ndims)
+{
+	int i;
+
+	for (i = 0; i < ndims; i++)
+	{
+		if (brin_multi_dim_is_padded(a, i) || brin_multi_dim_is_padded(b, i))
+			continue;
+		if (a[2 * i] > b[2 * i + 1] || b[2 * i] > a[2 * i + 1])
+			return false;
+	}
+	return true;
+}
+
+static void
+brin_multi_box_expand(float *a, const float *b, int ndims)
+{
+	int i;
+
+	for (i = 0; i < ndims; i++)
+	{
+		a[2 * i] = Min(a[2 * i], b[2 * i]);
+		a[2 * i + 1] = Max(a[2 * i + 1], b[2 * i + 1]);
+	}
+}
+
+/*
+ * Size of the box covering both a and b, measured as the sum of its
+ * extents (padded dimensions excluded).  Two boxes close to each other
+ * give a small union, an outlier gives a large one with anything.
+ */
+static double
+brin_multi_union_margin(const float *a, const float *b, int ndims)
+{
+	double margin = 0.0;
+	int i;
+
+	for (i = 0; i < ndims; i++)
+	{
+		if (brin_multi_dim_is_padded(a, i) || brin_multi_dim_is_padded(b, i))
+			continue;
+		margin += (double) Max(a[2 * i + 1], b[2 * i + 1]) - (double) Min(a[2 * i], b[2 * i]);
+	}
+	return margin;
+}
+
+/*
+ * Merge the nearest pair of boxes until no more than max_boxes are left,
+ * returning the new number of boxes.
+ */
+static int
+brin_multi_reduce(BrinMultiBoxes *summary, int max_boxes)
+{
+	int ndims = summary->ndims;
+	int nboxes = summary->nboxes;
+
+	while (nboxes > max_boxes)
+	{
+		double best = DBL_MAX;
+		int best_i = 0, best_j = 1;
+		int i, j;
+
+		for (i = 0; i < nboxes; i++)
+		{
+			for (j = i + 1; j < nboxes; j++)
+			{
+				double margin = brin_multi_union_margin(BRIN_MULTI_BOX(summary, i),
+				                                        BRIN_MULTI_BOX(summary, j), ndims);
+				if (margin < best)
+				{
+					best = margin;
+					best_i = i;
+					best_j = j;
+				}
+			}
+		}
+
+		brin_multi_box_expand(BRIN_MULTI_BOX(summary, best_i), BRIN_MULTI_BOX(summary, best_j), ndims);
+
+		/* Fill the hole with the last box */
+		nboxes--;
+		if (best_j != nboxes)
+			memcpy(BRIN_MULTI_BOX(summary, best_j), BRIN_MULTI_BOX(summary, nboxes),
+			       sizeof(float) * 2 * ndims);
+		summary->nboxes = nboxes;
+	}
+
+	SET_VARSIZE(summary, BRIN_MULTI_SIZE(ndims, nboxes));
+	return nboxes;
+}
+
+static bool
+brin_multi_covers(const BrinMultiBoxes *summary, const float *box)
+{
+	int i;
+
+	for (i = 0; i < summary->nboxes; i++)
+	{
+		if (brin_multi_box_contains(BRIN_MULTI_BOX(summary, i), box, summary->ndims))
+			return true;
+	}
+	return false;
+}
+
+static Datum
+gidx_brin_multi_add_value(FunctionCallInfo fcinfo, int max_dims)
+{
+	BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+	Datum newval = PG_GETARG_DATUM(2);
+	char gboxmem[GIDX_MAX_SIZE];
+	GIDX *gidx_geom = (GIDX *) gboxmem;
+	float box[2 * GIDX_MAX_DIM];
+	BrinMultiBoxes *summary, *grown;
+	MemoryContext old_ctx;
+
+	Assert(max_dims <= GIDX_MAX_DIM);
+
+	/* Nulls are tracked by BRIN itself, see oi_regular_nulls */
+	Assert(!PG_GETARG_BOOL(3));
+
+	if (gserialized_datum_get_gidx_p(newval, gidx_geom) == LW_FAILURE)
+	{
+		if (!is_gserialized_from_datum_empty(newval))
+			elog(ERROR, "Error while extracting the gidx from the geom");
+
+		/*
+		 * Empty geometries match none of the supported operators, but the
+		 * range is not all nulls anymore: store a summary without boxes.
+		 */
+		if (!column->bv_allnulls)
+			PG_RETURN_BOOL(false);
+
+		old_ctx = MemoryContextSwitchTo(column->bv_context);
+		summary = palloc0(BRIN_MULTI_SIZE(max_dims, 0));
+		MemoryContextSwitchTo(old_ctx);
+
+		SET_VARSIZE(summary, BRIN_MULTI_SIZE(max_dims, 0));
+		summary->ndims = max_dims;
+		summary->nboxes = 0;
+		column->bv_values[0] = PointerGetDatum(summary);
+		column->bv_allnulls = false;
+		PG_RETURN_BOOL(true);
+	}
+
+	brin_multi_box_from_gidx(box, gidx_geom, max_dims);
+
+	if (column->bv_allnulls)
+	{
+		summary = NULL;
+	}
+	else
+	{
+		summary = (BrinMultiBoxes *) PG_DETOAST_DATUM(column->bv_values[0]);
+
+		/* Nothing to do if a stored box already covers the geometry */
+		if (brin_multi_covers(summary, box))
+		{
+			if (summary != (BrinMultiBoxes *) DatumGetPointer(column->bv_values[0]))
+				pfree(summary);
+			PG_RETURN_BOOL(false);
+		}
+	}
+
+	/* Append the box, merging the nearest pair if there are too many */
+	old_ctx = MemoryContextSwitchTo(column->bv_context);
+	if (summary)
+	{
+		grown = palloc(BRIN_MULTI_SIZE(max_dims, summary->nboxes + 1));
+		memcpy(grown, summary, BRIN_MULTI_SIZE(max_dims, summary->nboxes));
+	}
+	else
+	{
+		grown = palloc(BRIN_MULTI_SIZE(max_dims, 1));
+		grown->ndims = max_dims;
+		grown->nboxes = 0;
+	}
+	MemoryContextSwitchTo(old_ctx);
+
+	memcpy(BRIN_MULTI_BOX(grown, grown->nboxes), box, sizeof(float) * 2 * max_dims);
+	grown->nboxes++;
+	brin_multi_reduce(grown, brin_multi_boxes_per_range(fcinfo));
+
+	/*
+	 * Release the previous summary, or a summarization pass keeps one
+	 * copy per added row alive until the end of the range.  As in the
+	 * inclusion opclasses, only the value held in bv_context is ours.
+	 */
+	if (summary)
+	{
+		Pointer old_value = DatumGetPointer(column->bv_values[0]);
+
+		if ((Pointer) summary != old_value)
+			pfree(summary);
+		if (GetMemoryChunkContext(old_value) == column->bv_context)
+			pfree(old_value);
+	}
+
+	column->bv_values[0] = PointerGetDatum(grown);
+	column->bv_allnulls = false;
+	PG_RETURN_BOOL(true);
+}
+
+PG_FUNCTION_INFO_V1(geom2d_brin_multi_add_value);
+Datum
+geom2d_brin_multi_add_value(PG_FUNCTION_ARGS)
+{
+	return gidx_brin_multi_add_value(fcinfo, 2);
+}
+
+PG_FUNCTION_INFO_V1(geom3d_brin_multi_add_value);
+Datum
+geom3d_brin_multi_add_value(PG_FUNCTION_ARGS)
+{
+	return gidx_brin_multi_add_value(fcinfo, 3);
+}
+
+PG_FUNCTION_INFO_V1(geom4d_brin_multi_add_value);
+Datum
+geom4d_brin_multi_add_value(PG_FUNCTION_ARGS)
+{
+	return gidx_brin_multi_add_value(fcinfo, 4);
+}
+
+/*
+ * Geographies are summarized with their geocentric boxes, as for the
+ * GiST case
+ */
+PG_FUNCTION_INFO_V1(geog_brin_multi_add_value);
+Datum
+geog_brin_multi_add_value(PG_FUNCTION_ARGS)
+{
+	return gidx_brin_multi_add_value(fcinfo, 3);
+}
+
+PG_FUNCTION_INFO_V1(geom_brin_multi_opcinfo);
+Datum
+geom_brin_multi_opcinfo(PG_FUNCTION_ARGS)
+{
+	BrinOpcInfo *result = palloc0(MAXALIGN(SizeofBrinOpcInfo(1)));
+
+	result->oi_nstored = 1;
+	result->oi_regular_nulls = true;
+	result->oi_opaque = NULL;
+	result->oi_typcache[0] = lookup_type_cache(BYTEAOID, 0);
+
+	PG_RETURN_POINTER(result);
+}
+
+/*
+ * A range may hold a match if, for every scan key, one of its boxes
+ * passes the box test of the operator.
+ */
+PG_FUNCTION_INFO_V1(geom_brin_multi_consistent);
+Datum
+geom_brin_multi_consistent(PG_FUNCTION_ARGS)
+{
+	BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+	ScanKey *keys = (ScanKey *) PG_GETARG_POINTER(2);
+	int nkeys = PG_GETARG_INT32(3);
+	BrinMultiBoxes *summary = (BrinMultiBoxes *) PG_DETOAST_DATUM(column->bv_values[0]);
+	int ndims = summary->ndims;
+	int k, i;
+
+	for (k = 0; k < nkeys; k++)
+	{
+		ScanKey key = keys[k];
+		char gboxmem[GIDX_MAX_SIZE];
+		GIDX *gidx_query = (GIDX *) gboxmem;
+		float query[2 * GIDX_MAX_DIM];
+		bool matches = false;
+
+		/* Empty queries match nothing */
+		if (gserialized_datum_get_gidx_p(key->sk_argument, gidx_query) == LW_FAILURE)
+			PG_RETURN_BOOL(false);
+
+		brin_multi_box_from_gidx(query, gidx_query, ndims);
+
+		for (i = 0; i < summary->nboxes && !matches; i++)
+		{
+			float *box = BRIN_MULTI_BOX(summary, i);
+
+			switch (key->sk_strategy)
+			{
+			case RTOverlapStrategyNumber:
+			case RTContainedByStrategyNumber:
+				matches = brin_multi_box_overlaps(box, query, ndims);
+				break;
+
+			case RTContainsStrategyNumber:
+				matches = brin_multi_box_contains(box, query, ndims);
+				break;
+
+			default:
+				elog(ERROR, "unrecognized strategy: %d", key->sk_strategy);
+			}
+		}
+
+		if (!matches)
+			PG_RETURN_BOOL(false);
+	}
+
+	PG_RETURN_BOOL(true);
+}
+
+PG_FUNCTION_INFO_V1(geom_brin_multi_union);
+Datum
+geom_brin_multi_union(PG_FUNCTION_ARGS)
+{
+	BrinValues *col_a = (BrinValues *) PG_GETARG_POINTER(1);
+	BrinValues *col_b = (BrinValues *) PG_GETARG_POINTER(2);
+	BrinMultiBoxes *summary_a, *summary_b, *merged;
+	MemoryContext old_ctx;
+	int ndims, i;
+
+	Assert(!col_a->bv_allnulls && !col_b->bv_allnulls);
+
+	summary_a = (BrinMultiBoxes *) PG_DETOAST_DATUM(col_a->bv_values[0]);
+	summary_b = (BrinMultiBoxes *) PG_DETOAST_DATUM(col_b->bv_values[0]);
+	ndims = summary_a->ndims;
+
+	old_ctx = MemoryContextSwitchTo(col_a->bv_context);
+	merged = palloc(BRIN_MULTI_SIZE(ndims, summary_a->nboxes + summary_b->nboxes));
+	MemoryContextSwitchTo(old_ctx);
+
+	memcpy(merged, summary_a, BRIN_MULTI_SIZE(ndims, summary_a->nboxes));
+	for (i = 0; i < summary_b->nboxes; i++)
+	{
+		float *box = BRIN_MULTI_BOX(summary_b, i);
+
+		if (brin_multi_covers(summary_a, box))
+			continue;
+
+		memcpy(BRIN_MULTI_BOX(merged, merged->nboxes), box, sizeof(float) * 2 * ndims);
+		merged->nboxes++;
+	}
+	brin_multi_reduce(merged, brin_multi_boxes_per_range(fcinfo));
+
+	col_a->bv_values[0] = PointerGetDatum(merged);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Declare the options of the multi-box opclasses, of which
+ * "boxes_per_range" bounds the size of the summaries:
+ *   CREATE INDEX ON t USING BRIN (geom brin_geometry_inclusion_multi_ops_2d (boxes_per_range = 16));
+ */
+PG_FUNCTION_INFO_V1(geom_brin_multi_options);
+Datum
+geom_brin_multi_options(PG_FUNCTION_ARGS)
+{
+	local_relopts *relopts = (local_relopts *) PG_GETARG_POINTER(0);
+
+	init_local_reloptions(relopts, sizeof(BrinMultiOptions));
+	add_local_int_reloption(relopts, "boxes_per_range",
+				"number of boxes kept for each block range",
+				BRIN_MULTI_BOXES_DEFAULT,
+				BRIN_MULTI_BOXES_MIN,
+				BRIN_MULTI_BOXES_MAX,
+				offsetof(BrinMultiOptions, boxes_per_range));
+
+	PG_RETURN_VOID();
+}
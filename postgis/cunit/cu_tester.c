@@ -204,6 +204,59 @@ nd_box_ratio_cases(void)
 	CU_ASSERT_DOUBLE_EQUAL(nd_box_ratio(&covering, &touch, 3), 0.0, 1e-12);
 }
 
+static void
+set_tree_node(ND_TREE_STATS *tree, int node, float4 dim, float4 value, float4 right)
+{
+	tree->node[node * ND_TREE_NODE_SIZE + 0] = dim;
+	tree->node[node * ND_TREE_NODE_SIZE + 1] = value;
+	tree->node[node * ND_TREE_NODE_SIZE + 2] = right;
+}
+
+static void
+nd_tree_count_cases(void)
+{
+	float4 storage[sizeof(ND_TREE_STATS) / sizeof(float4) + 5 * ND_TREE_NODE_SIZE];
+	ND_TREE_STATS *tree = (ND_TREE_STATS *)storage;
+	ND_BOX all = make_box(0.0f, 0.0f, 0.0f, 0.0f, 4.0f, 4.0f, 0.0f, 0.0f);
+	ND_BOX west = make_box(0.0f, 0.0f, 0.0f, 0.0f, 2.0f, 4.0f, 0.0f, 0.0f);
+	ND_BOX corner = make_box(0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 0.0f, 0.0f);
+	ND_BOX south_east = make_box(2.0f, 0.0f, 0.0f, 0.0f, 4.0f, 1.0f, 0.0f, 0.0f);
+	ND_BOX east_strip = make_box(3.0f, 0.0f, 0.0f, 0.0f, 4.0f, 4.0f, 0.0f, 0.0f);
+	ND_BOX outside = make_box(5.0f, 5.0f, 0.0f, 0.0f, 6.0f, 6.0f, 0.0f, 0.0f);
+
+	/*
+	 * Extent [0,4]x[0,4] split at x=2, the east half split again at y=1:
+	 * west leaf holds 6 features, south-east 2 and north-east 10.
+	 */
+	memset(storage, 0, sizeof(storage));
+	tree->ndims = 2;
+	tree->nnodes = 5;
+	tree->extent = all;
+	set_tree_node(tree, 0, 0, 2.0f, 2);
+	set_tree_node(tree, 1, -1, 6.0f, 0);
+	set_tree_node(tree, 2, 1, 1.0f, 4);
+	set_tree_node(tree, 3, -1, 2.0f, 0);
+	set_tree_node(tree, 4, -1, 10.0f, 0);
+
+	CU_ASSERT_DOUBLE_EQUAL(nd_tree_count(tree, &all, 2), 18.0, 1e-9);
+	/* Leaves the box only touches along an edge contribute nothing. */
+	CU_ASSERT_DOUBLE_EQUAL(nd_tree_count(tree, &west, 2), 6.0, 1e-9);
+	/* Partially covered leaves are pro-rated by area. */
+	CU_ASSERT_DOUBLE_EQUAL(nd_tree_count(tree, &corner, 2), 1.5, 1e-9);
+	CU_ASSERT_DOUBLE_EQUAL(nd_tree_count(tree, &south_east, 2), 2.0, 1e-9);
+	CU_ASSERT_DOUBLE_EQUAL(nd_tree_count(tree, &east_strip, 2), 6.0, 1e-9);
+	CU_ASSERT_DOUBLE_EQUAL(nd_tree_count(tree, &outside, 2), 0.0, 1e-9);
+
+	/* A right child pointing backwards must not send the walk in circles. */
+	set_tree_node(tree, 2, 1, 1.0f, 0);
+	CU_ASSERT_DOUBLE_EQUAL(nd_tree_count(tree, &all, 2), 6.0, 1e-9);
+
+	/* Nodes past nnodes are never read. */
+	set_tree_node(tree, 2, 1, 1.0f, 4);
+	tree->nnodes = 4;
+	CU_ASSERT_DOUBLE_EQUAL(nd_tree_count(tree, &all, 2), 8.0, 1e-9);
+}
+
 int
 main(void)
 {
@@ -220,7 +273,8 @@ main(void)
 	    !CU_add_test(suite, "histogram budget clamps", histogram_budget_clamps) ||
 	    !CU_add_test(suite, "histogram axis guards", histogram_axis_allocation_guards) ||
 	    !CU_add_test(suite, "nd_stats value index guards", nd_stats_indexing_behaviour) ||
-	    !CU_add_test(suite, "nd_box ratio edge cases", nd_box_ratio_cases))
+	    !CU_add_test(suite, "nd_box ratio edge cases", nd_box_ratio_cases) ||
+	    !CU_add_test(suite, "nd_tree count walk", nd_tree_count_cases))
 	{
 		goto cleanup;
 	}
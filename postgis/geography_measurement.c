@@ -76,52 +76,48 @@ Datum geography_shortestline(PG_FUNCTION_ARGS);
 PG_FUNCTION_INFO_V1(geography_distance_knn);
 Datum geography_distance_knn(PG_FUNCTION_ARGS)
 {
+	SHARED_GSERIALIZED *shared_geom1 = ToastCacheGetGeometry(fcinfo, 0);
+	SHARED_GSERIALIZED *shared_geom2 = ToastCacheGetGeometry(fcinfo, 1);
+	const GSERIALIZED *g1 = shared_gserialized_get(shared_geom1);
+	const GSERIALIZED *g2 = shared_gserialized_get(shared_geom2);
 	LWGEOM *lwgeom1 = NULL;
 	LWGEOM *lwgeom2 = NULL;
-	GSERIALIZED *g1 = NULL;
-	GSERIALIZED *g2 = NULL;
 	double distance;
 	double tolerance = FP_TOLERANCE;
 	bool use_spheroid = false; /* must use sphere, can't get index to harmonize with spheroid */
 	SPHEROID s;
 
-	/* Get our geometry objects loaded into memory. */
-	g1 = PG_GETARG_GSERIALIZED_P(0);
-	g2 = PG_GETARG_GSERIALIZED_P(1);
-
 	gserialized_error_if_srid_mismatch(g1, g2, __func__);
 
-	/* Initialize spheroid */
-	spheroid_init_from_srid(gserialized_get_srid(g1), &s);
+	/* Return NULL on empty arguments. */
+	if ( gserialized_is_empty(g1) || gserialized_is_empty(g2) )
+		PG_RETURN_NULL();
 
-	/* Set to sphere if requested */
-	if ( ! use_spheroid )
-		s.a = s.b = s.radius;
+	/* Index scans repeat the query argument, use it from the cache */
+	if ( LW_FAILURE == geography_distance_knn_cache(fcinfo, shared_geom1, shared_geom2, &distance) )
+	{
+		/* Initialize spheroid */
+		spheroid_init_from_srid(gserialized_get_srid(g1), &s);
 
-	lwgeom1 = lwgeom_from_gserialized(g1);
-	lwgeom2 = lwgeom_from_gserialized(g2);
+		/* Set to sphere if requested */
+		if ( ! use_spheroid )
+			s.a = s.b = s.radius;
 
-	/* Return NULL on empty arguments. */
-	if ( lwgeom_is_empty(lwgeom1) || lwgeom_is_empty(lwgeom2) )
-	{
-		PG_FREE_IF_COPY(g1, 0);
-		PG_FREE_IF_COPY(g2, 1);
-		PG_RETURN_NULL();
-	}
+		lwgeom1 = lwgeom_from_gserialized(g1);
+		lwgeom2 = lwgeom_from_gserialized(g2);
 
-	/* Make sure we have boxes attached */
-	lwgeom_add_bbox_deep(lwgeom1, NULL);
-	lwgeom_add_bbox_deep(lwgeom2, NULL);
+		/* Make sure we have boxes attached */
+		lwgeom_add_bbox_deep(lwgeom1, NULL);
+		lwgeom_add_bbox_deep(lwgeom2, NULL);
 
-	distance = lwgeom_distance_spheroid(lwgeom1, lwgeom2, &s, tolerance);
+		distance = lwgeom_distance_spheroid(lwgeom1, lwgeom2, &s, tolerance);
 
-	POSTGIS_DEBUGF(2, "[GIST] '%s' got distance %g", __func__, distance);
+		/* Clean up */
+		lwgeom_free(lwgeom1);
+		lwgeom_free(lwgeom2);
+	}
 
-	/* Clean up */
-	lwgeom_free(lwgeom1);
-	lwgeom_free(lwgeom2);
-	PG_FREE_IF_COPY(g1, 0);
-	PG_FREE_IF_COPY(g2, 1);
+	POSTGIS_DEBUGF(2, "[GIST] '%s' got distance %g", __func__, distance);
 
 	/* Something went wrong, negative return... should already be eloged, return NULL */
 	if ( distance < 0.0 )
@@ -704,39 +700,34 @@ Datum geography_point_outside(PG_FUNCTION_ARGS)
 PG_FUNCTION_INFO_V1(geography_covers);
 Datum geography_covers(PG_FUNCTION_ARGS)
 {
+	SHARED_GSERIALIZED *shared_geom1 = ToastCacheGetGeometry(fcinfo, 0);
+	SHARED_GSERIALIZED *shared_geom2 = ToastCacheGetGeometry(fcinfo, 1);
+	const GSERIALIZED *g1 = shared_gserialized_get(shared_geom1);
+	const GSERIALIZED *g2 = shared_gserialized_get(shared_geom2);
 	LWGEOM *lwgeom1 = NULL;
 	LWGEOM *lwgeom2 = NULL;
-	GSERIALIZED *g1 = NULL;
-	GSERIALIZED *g2 = NULL;
 	int result = LW_FALSE;
 
-	/* Get our geometry objects loaded into memory. */
-	g1 = PG_GETARG_GSERIALIZED_P(0);
-	g2 = PG_GETARG_GSERIALIZED_P(1);
 	gserialized_error_if_srid_mismatch(g1, g2, __func__);
 
+	/* EMPTY never intersects with another geometry */
+	if ( gserialized_is_empty(g1) || gserialized_is_empty(g2) )
+		PG_RETURN_BOOL(false);
+
+	/* Repeated regions answer points from their cached tree */
+	if ( LW_SUCCESS == geography_covers_cache(fcinfo, shared_geom1, shared_geom2, &result) )
+		PG_RETURN_BOOL(result);
+
 	/* Construct our working geometries */
 	lwgeom1 = lwgeom_from_gserialized(g1);
 	lwgeom2 = lwgeom_from_gserialized(g2);
 
-	/* EMPTY never intersects with another geometry */
-	if ( lwgeom_is_empty(lwgeom1) || lwgeom_is_empty(lwgeom2) )
-	{
-		lwgeom_free(lwgeom1);
-		lwgeom_free(lwgeom2);
-		PG_FREE_IF_COPY(g1, 0);
-		PG_FREE_IF_COPY(g2, 1);
-		PG_RETURN_BOOL(false);
-	}
-
 	/* Calculate answer */
 	result = lwgeom_covers_lwgeom_sphere(lwgeom1, lwgeom2);
 
 	/* Clean up */
 	lwgeom_free(lwgeom1);
 	lwgeom_free(lwgeom2);
-	PG_FREE_IF_COPY(g1, 0);
-	PG_FREE_IF_COPY(g2, 1);
 
 	PG_RETURN_BOOL(result);
 }
@@ -744,40 +735,35 @@ Datum geography_covers(PG_FUNCTION_ARGS)
 PG_FUNCTION_INFO_V1(geography_coveredby);
 Datum geography_coveredby(PG_FUNCTION_ARGS)
 {
+	/* Pick them up in reverse order to covers */
+	SHARED_GSERIALIZED *shared_geom1 = ToastCacheGetGeometry(fcinfo, 1);
+	SHARED_GSERIALIZED *shared_geom2 = ToastCacheGetGeometry(fcinfo, 0);
+	const GSERIALIZED *g1 = shared_gserialized_get(shared_geom1);
+	const GSERIALIZED *g2 = shared_gserialized_get(shared_geom2);
 	LWGEOM *lwgeom1 = NULL;
 	LWGEOM *lwgeom2 = NULL;
-	GSERIALIZED *g1 = NULL;
-	GSERIALIZED *g2 = NULL;
 	int result = LW_FALSE;
 
-	/* Get our geometry objects loaded into memory. */
-	/* Pick them up in reverse order to covers */
-	g1 = PG_GETARG_GSERIALIZED_P(1);
-	g2 = PG_GETARG_GSERIALIZED_P(0);
 	gserialized_error_if_srid_mismatch(g1, g2, __func__);
 
+	/* EMPTY never intersects with another geometry */
+	if ( gserialized_is_empty(g1) || gserialized_is_empty(g2) )
+		PG_RETURN_BOOL(false);
+
+	/* Repeated regions answer points from their cached tree */
+	if ( LW_SUCCESS == geography_covers_cache(fcinfo, shared_geom1, shared_geom2, &result) )
+		PG_RETURN_BOOL(result);
+
 	/* Construct our working geometries */
 	lwgeom1 = lwgeom_from_gserialized(g1);
 	lwgeom2 = lwgeom_from_gserialized(g2);
 
-	/* EMPTY never intersects with another geometry */
-	if ( lwgeom_is_empty(lwgeom1) || lwgeom_is_empty(lwgeom2) )
-	{
-		lwgeom_free(lwgeom1);
-		lwgeom_free(lwgeom2);
-		PG_FREE_IF_COPY(g1, 1);
-		PG_FREE_IF_COPY(g2, 0);
-		PG_RETURN_BOOL(false);
-	}
-
 	/* Calculate answer */
 	result = lwgeom_covers_lwgeom_sphere(lwgeom1, lwgeom2);
 
 	/* Clean up */
 	lwgeom_free(lwgeom1);
 	lwgeom_free(lwgeom2);
-	PG_FREE_IF_COPY(g1, 1);
-	PG_FREE_IF_COPY(g2, 0);
 
 	PG_RETURN_BOOL(result);
 }
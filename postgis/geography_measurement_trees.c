@@ -22,7 +22,11 @@
  *
  **********************************************************************/
 
+#include "postgres.h"
+#include "utils/memutils.h"
+
 #include "geography_measurement_trees.h"
+#include "lwgeom_transform.h"
 
 
 /*
@@ -35,28 +39,114 @@
 typedef struct {
 	GeomCache    gcache;
 	CIRC_NODE*   index;
+	CIRC_TREE_PACKED* packed; /* block holding index, when copied from the backend cache */
+	int          pip_ready;   /* pip_gbox and pip_outside are filled in */
+	GBOX         pip_gbox;    /* box of the cached polygon, for point rejection */
+	POINT2D      pip_outside; /* end point shared by every stab line into the polygon */
 } CircTreeGeomCache;
 
 
+/*
+* Backend circle tree cache
+*
+* Entries live for the life of the backend (or until evicted),
+* unlike the CircTreeGeomCache trees that die with their function
+* call context. Trees are stored packed, so a call context that
+* sees the same geography again only copies the block and fixes
+* up its pointers, instead of recomputing every bounding circle.
+* Keys are the serialized geography. Entries are evicted least
+* recently used first.
+*/
+int geography_tree_cache_size = 0;
+
+static void
+CircTreeBackendFree(void *value)
+{
+	pfree(value);
+}
+
+static BackendCache CircTreeBackendCache =
+{
+	.name = "PostGIS Circle Tree Backend Cache",
+	.size = &geography_tree_cache_size,
+	.value_free = CircTreeBackendFree
+};
+
+/*
+* Return the tree of lwgeom, copied out of the backend cache when it
+* is there (setting *packed to the block to pfree when done), or else
+* freshly calculated and added to the cache.
+*/
+static CIRC_NODE *
+CircTreeBackendGet(const LWGEOM *lwgeom, CIRC_TREE_PACKED **packed)
+{
+	CIRC_TREE_PACKED *cached;
+	MemoryContext old_context;
+	CIRC_NODE *tree;
+	GSERIALIZED *key;
+	uint32 hash;
+	int32 slot;
+
+	*packed = NULL;
+	slot = BackendCacheFind(&CircTreeBackendCache, lwgeom, &key, &hash);
+	if (slot >= 0)
+	{
+		cached = (CIRC_TREE_PACKED *)CircTreeBackendCache.entries[slot].value;
+		*packed = palloc(cached->size);
+		memcpy(*packed, cached, cached->size);
+		return circ_tree_unpack(*packed);
+	}
+
+	tree = lwgeom_calculate_circ_tree(lwgeom);
+	if (!key)
+		return tree;
+	if (!tree)
+	{
+		pfree(key);
+		return NULL;
+	}
+
+	old_context = MemoryContextSwitchTo(CircTreeBackendCache.context);
+	cached = circ_tree_pack(tree);
+	MemoryContextSwitchTo(old_context);
+	if (BackendCacheAdd(&CircTreeBackendCache, key, hash, cached) < 0)
+		pfree(cached);
+
+	return tree;
+}
+
+
 
 /**
 * Builder, freeer and public accessor for cached CIRC_NODE trees
 */
+static void
+CircTreeFree(CircTreeGeomCache* circ_cache)
+{
+	/* A tree copied from the backend cache lives inside its block */
+	if ( circ_cache->packed )
+		pfree(circ_cache->packed);
+	else
+		circ_tree_free(circ_cache->index);
+	circ_cache->index = 0;
+	circ_cache->packed = 0;
+	circ_cache->pip_ready = LW_FALSE;
+}
+
 static int
 CircTreeBuilder(const LWGEOM* lwgeom, GeomCache* cache)
 {
 	CircTreeGeomCache* circ_cache = (CircTreeGeomCache*)cache;
-	CIRC_NODE* tree = lwgeom_calculate_circ_tree(lwgeom);
+	CIRC_TREE_PACKED* packed;
+	CIRC_NODE* tree = CircTreeBackendGet(lwgeom, &packed);
 
 	if ( circ_cache->index )
-	{
-		circ_tree_free(circ_cache->index);
-		circ_cache->index = 0;
-	}
+		CircTreeFree(circ_cache);
 	if ( ! tree )
 		return LW_FAILURE;
 
 	circ_cache->index = tree;
+	circ_cache->packed = packed;
 	return LW_SUCCESS;
 }
 
@@ -66,8 +156,7 @@ CircTreeFreer(GeomCache* cache)
 	CircTreeGeomCache* circ_cache = (CircTreeGeomCache*)cache;
 	if ( circ_cache->index )
 	{
-		circ_tree_free(circ_cache->index);
-		circ_cache->index = 0;
+		CircTreeFree(circ_cache);
 		circ_cache->gcache.argnum = 0;
 	}
 	return LW_SUCCESS;
@@ -95,13 +184,62 @@ GetCircTreeGeomCache(FunctionCallInfo fcinfo, SHARED_GSERIALIZED *g1, SHARED_GSE
 	return (CircTreeGeomCache*)GetGeomCache(fcinfo, &CircTreeCacheMethods, g1, g2);
 }
 
+/*
+* Fill in the box of a polygonal tree and a point guaranteed
+* to be outside it, the two things every stab line test needs.
+*/
+static void
+CircTreePIPPrepare(const CIRC_NODE* tree1, const GSERIALIZED* g1, GBOX* gbox1, POINT2D* pt2d_outside)
+{
+	/* Need a gbox to calculate an outside point */
+	if ( LW_FAILURE == gserialized_get_gbox_p(g1, gbox1) )
+	{
+		LWGEOM* lwgeom1 = lwgeom_from_gserialized(g1);
+		POSTGIS_DEBUG(3, "unable to read gbox from gserialized, calculating from scratch");
+		lwgeom_calculate_gbox_geodetic(lwgeom1, gbox1);
+		lwgeom_free(lwgeom1);
+	}
+
+	/* Calculate a definitive outside point */
+	if (gbox_pt_outside(gbox1, pt2d_outside) == LW_FAILURE)
+		if (circ_tree_get_point_outside(tree1, pt2d_outside) == LW_FAILURE)
+			lwpgerror("%s: Unable to generate outside point!", __func__);
+}
+
+static int
+CircTreePIPBox(const CIRC_NODE* tree1, const GBOX* gbox1, const POINT2D* pt2d_outside, const POINT4D* in_point)
+{
+	GEOGRAPHIC_POINT in_gpoint;
+	POINT3D in_point3d;
+	POINT2D pt2d_inside;
+
+	/* Flip the candidate point into geographics */
+	geographic_point_init(in_point->x, in_point->y, &in_gpoint);
+	geog2cart(&in_gpoint, &in_point3d);
+
+	/* If the candidate isn't in the tree box, it's not in the tree area */
+	if ( ! gbox_contains_point3d(gbox1, &in_point3d) )
+	{
+		POSTGIS_DEBUG(3, "in_point3d is not inside the tree gbox, CircTreePIP returning FALSE");
+		return LW_FALSE;
+	}
+
+	/* The candidate point is in the box, so it *might* be inside the tree */
+	pt2d_inside.x = in_point->x;
+	pt2d_inside.y = in_point->y;
+	POSTGIS_DEBUGF(3, "p2d_inside=POINT(%g %g) p2d_outside=POINT(%g %g)", pt2d_inside.x, pt2d_inside.y, pt2d_outside->x, pt2d_outside->y);
+
+	/* Test the candidate point for strict containment */
+	POSTGIS_DEBUG(3, "calling circ_tree_contains_point for PiP test");
+	return circ_tree_contains_point(tree1, &pt2d_inside, pt2d_outside, 0, NULL);
+}
+
 static int
 CircTreePIP(const CIRC_NODE* tree1, const GSERIALIZED* g1, const POINT4D* in_point)
 {
 	int tree1_type = gserialized_get_type(g1);
 	GBOX gbox1;
-	GEOGRAPHIC_POINT in_gpoint;
-	POINT3D in_point3d;
+	POINT2D pt2d_outside; /* latlon */
 
 	POSTGIS_DEBUGF(3, "tree1_type=%d", tree1_type);
 
@@ -109,42 +247,8 @@ CircTreePIP(const CIRC_NODE* tree1, const GSERIALIZED* g1, const POINT4D* in_poi
 	if ( tree1_type == POLYGONTYPE || tree1_type == MULTIPOLYGONTYPE )
 	{
 		POSTGIS_DEBUG(3, "tree is a polygon, using tree PiP");
-		/* Need a gbox to calculate an outside point */
-		if ( LW_FAILURE == gserialized_get_gbox_p(g1, &gbox1) )
-		{
-			LWGEOM* lwgeom1 = lwgeom_from_gserialized(g1);
-			POSTGIS_DEBUG(3, "unable to read gbox from gserialized, calculating from scratch");
-			lwgeom_calculate_gbox_geodetic(lwgeom1, &gbox1);
-			lwgeom_free(lwgeom1);
-		}
-
-		/* Flip the candidate point into geographics */
-		geographic_point_init(in_point->x, in_point->y, &in_gpoint);
-		geog2cart(&in_gpoint, &in_point3d);
-
-		/* If the candidate isn't in the tree box, it's not in the tree area */
-		if ( ! gbox_contains_point3d(&gbox1, &in_point3d) )
-		{
-			POSTGIS_DEBUG(3, "in_point3d is not inside the tree gbox, CircTreePIP returning FALSE");
-			return LW_FALSE;
-		}
-		/* The candidate point is in the box, so it *might* be inside the tree */
-		else
-		{
-			POINT2D pt2d_outside; /* latlon */
-			POINT2D pt2d_inside;
-			pt2d_inside.x = in_point->x;
-			pt2d_inside.y = in_point->y;
-			/* Calculate a definitive outside point */
-			if (gbox_pt_outside(&gbox1, &pt2d_outside) == LW_FAILURE)
-				if (circ_tree_get_point_outside(tree1, &pt2d_outside) == LW_FAILURE)
-					lwpgerror("%s: Unable to generate outside point!", __func__);
-
-			POSTGIS_DEBUGF(3, "p2d_inside=POINT(%g %g) p2d_outside=POINT(%g %g)", pt2d_inside.x, pt2d_inside.y, pt2d_outside.x, pt2d_outside.y);
-			/* Test the candidate point for strict containment */
-			POSTGIS_DEBUG(3, "calling circ_tree_contains_point for PiP test");
-			return circ_tree_contains_point(tree1, &pt2d_inside, &pt2d_outside, 0, NULL);
-		}
+		CircTreePIPPrepare(tree1, g1, &gbox1, &pt2d_outside);
+		return CircTreePIPBox(tree1, &gbox1, &pt2d_outside, in_point);
 	}
 	else
 	{
@@ -153,6 +257,29 @@ CircTreePIP(const CIRC_NODE* tree1, const GSERIALIZED* g1, const POINT4D* in_poi
 	}
 }
 
+/*
+* As CircTreePIP, but for the tree held in the cache. The box and
+* outside point are worked out on the first call and kept next to
+* the tree, so a point-in-polygon join only pays for the stab line
+* walk on each row.
+*/
+static int
+CircTreeCachePIP(CircTreeGeomCache* tree_cache, const GSERIALIZED* g_cached, const POINT4D* in_point)
+{
+	int tree_type = gserialized_get_type(g_cached);
+
+	if ( tree_type != POLYGONTYPE && tree_type != MULTIPOLYGONTYPE )
+		return LW_FALSE;
+
+	if ( ! tree_cache->pip_ready )
+	{
+		CircTreePIPPrepare(tree_cache->index, g_cached, &(tree_cache->pip_gbox), &(tree_cache->pip_outside));
+		tree_cache->pip_ready = LW_TRUE;
+	}
+
+	return CircTreePIPBox(tree_cache->index, &(tree_cache->pip_gbox), &(tree_cache->pip_outside), in_point);
+}
+
 static int
 geography_distance_cache_tolerance(FunctionCallInfo fcinfo,
 				   SHARED_GSERIALIZED *shared_g1,
@@ -211,18 +338,26 @@ geography_distance_cache_tolerance(FunctionCallInfo fcinfo,
 			return LW_FAILURE;
 		}
 
-		lwgeom = lwgeom_from_gserialized(g);
 		if ( geomtype_cached == POLYGONTYPE || geomtype_cached == MULTIPOLYGONTYPE )
 		{
-			lwgeom_startpoint(lwgeom, &p4d);
-			if ( CircTreePIP(circtree_cached, g_cached, &p4d) )
+			/* A point inside the region is answered straight off the */
+			/* serialization, without building an LWGEOM for it */
+			if ( geomtype != POINTTYPE || LW_FAILURE == gserialized_peek_first_point(g, &p4d) )
+			{
+				lwgeom = lwgeom_from_gserialized(g);
+				lwgeom_startpoint(lwgeom, &p4d);
+			}
+			if ( CircTreeCachePIP(tree_cache, g_cached, &p4d) )
 			{
 				*distance = 0.0;
-				lwgeom_free(lwgeom);
+				if ( lwgeom )
+					lwgeom_free(lwgeom);
 				return LW_SUCCESS;
 			}
 		}
 
+		if ( ! lwgeom )
+			lwgeom = lwgeom_from_gserialized(g);
 		circtree = lwgeom_calculate_circ_tree(lwgeom);
 		if ( geomtype == POLYGONTYPE || geomtype == MULTIPOLYGONTYPE )
 		{
@@ -283,6 +418,209 @@ geography_dwithin_cache(FunctionCallInfo fcinfo,
 	return LW_FAILURE;
 }
 
+/*
+* Cached argument for the KNN distance. The index-ordered recheck
+* calls the <-> operator with the same query geography for every
+* candidate, so the query is deserialized, boxed and its spheroid
+* looked up once per scan instead of once per row.
+*/
+typedef struct {
+	GeomCache        gcache;
+	LWGEOM*          lwgeom;    /* cached argument, boxes attached */
+	int              is_point;  /* cached argument is a plain point */
+	GEOGRAPHIC_POINT point;     /* its radian coordinates, when it is */
+	int32_t          srid;      /* spheroid is for this SRID */
+	int              has_spheroid;
+	SPHEROID         s;
+} KnnGeomCache;
+
+static int
+KnnCacheBuilder(const LWGEOM* lwgeom, GeomCache* cache)
+{
+	KnnGeomCache* knn_cache = (KnnGeomCache*)cache;
+	LWGEOM* lwcopy;
+
+	if ( knn_cache->lwgeom )
+		lwgeom_free(knn_cache->lwgeom);
+	knn_cache->lwgeom = NULL;
+	knn_cache->has_spheroid = LW_FALSE;
+
+	/* The GeomCache machinery frees its own copy, keep ours */
+	lwcopy = lwgeom_clone_deep(lwgeom);
+	lwgeom_add_bbox_deep(lwcopy, NULL);
+	knn_cache->lwgeom = lwcopy;
+
+	knn_cache->is_point = (lwcopy->type == POINTTYPE);
+	if ( knn_cache->is_point )
+	{
+		const POINT2D* p = getPoint2d_cp(((LWPOINT*)lwcopy)->point, 0);
+		geographic_point_init(p->x, p->y, &(knn_cache->point));
+	}
+	return LW_SUCCESS;
+}
+
+static int
+KnnCacheFreer(GeomCache* cache)
+{
+	KnnGeomCache* knn_cache = (KnnGeomCache*)cache;
+	if ( knn_cache->lwgeom )
+	{
+		lwgeom_free(knn_cache->lwgeom);
+		knn_cache->lwgeom = NULL;
+		knn_cache->gcache.argnum = 0;
+	}
+	knn_cache->has_spheroid = LW_FALSE;
+	return LW_SUCCESS;
+}
+
+static GeomCache*
+KnnCacheAllocator(void)
+{
+	KnnGeomCache* cache = palloc(sizeof(KnnGeomCache));
+	memset(cache, 0, sizeof(KnnGeomCache));
+	return (GeomCache*)cache;
+}
+
+static GeomCacheMethods KnnCacheMethods =
+{
+	KNN_CACHE_ENTRY,
+	KnnCacheBuilder,
+	KnnCacheFreer,
+	KnnCacheAllocator
+};
+
+/*
+* Sphere distance for geography_distance_knn against the cached
+* argument. Returns LW_FAILURE when neither argument is cached yet,
+* so the caller does the full calculation. Empty arguments must have
+* been handled by the caller.
+*/
+int
+geography_distance_knn_cache(FunctionCallInfo fcinfo,
+			     SHARED_GSERIALIZED *shared_g1,
+			     SHARED_GSERIALIZED *shared_g2,
+			     double *distance)
+{
+	const GSERIALIZED *g1 = shared_gserialized_get(shared_g1);
+	const GSERIALIZED *g2 = shared_gserialized_get(shared_g2);
+	KnnGeomCache* knn_cache;
+	const GSERIALIZED *g;
+	LWGEOM *lwgeom;
+	int32_t srid = gserialized_get_srid(g1);
+
+	knn_cache = (KnnGeomCache*)GetGeomCache(fcinfo, &KnnCacheMethods, shared_g1, shared_g2);
+	if ( ! (knn_cache && knn_cache->gcache.argnum && knn_cache->lwgeom) )
+		return LW_FAILURE;
+
+	/* Must use sphere, can't get index to harmonize with spheroid */
+	if ( ! knn_cache->has_spheroid || knn_cache->srid != srid )
+	{
+		spheroid_init_from_srid(srid, &(knn_cache->s));
+		knn_cache->s.a = knn_cache->s.b = knn_cache->s.radius;
+		knn_cache->srid = srid;
+		knn_cache->has_spheroid = LW_TRUE;
+	}
+
+	g = (knn_cache->gcache.argnum == 1) ? g2 : g1;
+
+	/*
+	* Point to point, as ptarray_distance_spheroid does on the sphere.
+	* sphere_distance is not bitwise symmetric, so keep the argument
+	* order of the uncached call here too.
+	*/
+	if ( knn_cache->is_point && gserialized_get_type(g) == POINTTYPE )
+	{
+		POINT4D p4d;
+		GEOGRAPHIC_POINT gpt;
+		if ( LW_SUCCESS == gserialized_peek_first_point(g, &p4d) )
+		{
+			geographic_point_init(p4d.x, p4d.y, &gpt);
+			if ( knn_cache->gcache.argnum == 1 )
+				*distance = knn_cache->s.radius * sphere_distance(&(knn_cache->point), &gpt);
+			else
+				*distance = knn_cache->s.radius * sphere_distance(&gpt, &(knn_cache->point));
+			return LW_SUCCESS;
+		}
+	}
+
+	lwgeom = lwgeom_from_gserialized(g);
+	lwgeom_add_bbox_deep(lwgeom, NULL);
+
+	/* Keep the argument order of the uncached call */
+	if ( knn_cache->gcache.argnum == 1 )
+		*distance = lwgeom_distance_spheroid(knn_cache->lwgeom, lwgeom, &(knn_cache->s), FP_TOLERANCE);
+	else
+		*distance = lwgeom_distance_spheroid(lwgeom, knn_cache->lwgeom, &(knn_cache->s), FP_TOLERANCE);
+
+	lwgeom_free(lwgeom);
+	return LW_SUCCESS;
+}
+
+/*
+* Stab line answers closer than this (in radians, about 6mm) to the
+* polygon boundary are left to lwgeom_covers_lwgeom_sphere, so the
+* cached test never disagrees with it about points on the edge.
+*/
+#define CIRC_TREE_COVERS_BOUNDARY_TOLERANCE 1e-9
+
+int
+geography_covers_cache(FunctionCallInfo fcinfo,
+		       SHARED_GSERIALIZED *shared_g1,
+		       SHARED_GSERIALIZED *shared_g2,
+		       int *covers)
+{
+	const GSERIALIZED *g1 = shared_gserialized_get(shared_g1);
+	const GSERIALIZED *g2 = shared_gserialized_get(shared_g2);
+	CircTreeGeomCache* tree_cache = NULL;
+	int type1 = gserialized_get_type(g1);
+	int inside;
+	GEOGRAPHIC_POINT gpt;
+	POINT4D p4d;
+
+	/* Only the point-in-region case is handled here */
+	if ( (type1 != POLYGONTYPE && type1 != MULTIPOLYGONTYPE) ||
+	     gserialized_get_type(g2) != POINTTYPE )
+		return LW_FAILURE;
+
+	/* Fetch/build our cache, only useful when the region is the repeated argument */
+	tree_cache = GetCircTreeGeomCache(fcinfo, shared_g1, shared_g2);
+	if ( ! (tree_cache && tree_cache->gcache.argnum == 1 && tree_cache->index) )
+		return LW_FAILURE;
+
+	if ( LW_FAILURE == gserialized_peek_first_point(g2, &p4d) )
+		return LW_FAILURE;
+
+	inside = CircTreeCachePIP(tree_cache, g1, &p4d);
+	geographic_point_init(p4d.x, p4d.y, &gpt);
+
+	/* Outside the box is outside every part, and clear of the boundary */
+	if ( ! inside )
+	{
+		POINT3D pt3d;
+		geog2cart(&gpt, &pt3d);
+		if ( ! gbox_contains_point3d(&(tree_cache->pip_gbox), &pt3d) )
+		{
+			*covers = LW_FALSE;
+			return LW_SUCCESS;
+		}
+
+		/*
+		* Parts of a multipolygon are tested one at a time by the
+		* uncached code, so an even crossing count over all of them
+		* (two overlapping parts, say) is not a reliable "outside".
+		*/
+		if ( type1 == MULTIPOLYGONTYPE )
+			return LW_FAILURE;
+	}
+
+	/* Stay clear of the boundary, where the answer is the uncached code's call */
+	if ( circ_tree_edges_within(tree_cache->index, &gpt, CIRC_TREE_COVERS_BOUNDARY_TOLERANCE) )
+		return LW_FAILURE;
+
+	*covers = inside;
+	return LW_SUCCESS;
+}
+
 int
 geography_tree_distance(const GSERIALIZED* g1, const GSERIALIZED* g2, const SPHEROID* s, double tolerance, double* distance)
 {
@@ -26,6 +26,15 @@
 #include "lwgeodetic_tree.h"
 #include "lwgeom_cache.h"
 
+/*
+ * Circle trees can also be kept in a backend-lifetime cache, packed
+ * and keyed on the serialized geography, so later statements in the
+ * same backend do not rebuild them. The number of entries is set by
+ * the postgis.geography_tree_cache_size GUC, zero (the default)
+ * disables it.
+ */
+extern int geography_tree_cache_size;
+
 int geography_dwithin_cache(FunctionCallInfo fcinfo,
 	SHARED_GSERIALIZED *g1,
 	SHARED_GSERIALIZED *g2,
@@ -37,6 +46,14 @@ int geography_distance_cache(FunctionCallInfo fcinfo,
 	SHARED_GSERIALIZED *g2,
 	const SPHEROID *s,
 	double *distance);
+int geography_distance_knn_cache(FunctionCallInfo fcinfo,
+	SHARED_GSERIALIZED *g1,
+	SHARED_GSERIALIZED *g2,
+	double *distance);
+int geography_covers_cache(FunctionCallInfo fcinfo,
+	SHARED_GSERIALIZED *g1,
+	SHARED_GSERIALIZED *g2,
+	int *covers);
 
 int geography_tree_distance(
 	const GSERIALIZED* g1,
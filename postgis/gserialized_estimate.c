@@ -141,8 +141,8 @@ static Oid table_get_spatial_index(Oid tbl_oid, int16 attnum, int *key_type, int
 static GBOX *spatial_index_read_extent(Oid idx_oid, int idx_att_num, int key_type);
 
 /* Other prototypes */
-float8 gserialized_joinsel_internal(PlannerInfo *root, List *args, JoinType jointype, int mode);
-float8 gserialized_sel_internal(PlannerInfo *root, List *args, int varRelid, int mode);
+float8 gserialized_joinsel_internal(PlannerInfo *root, List *args, JoinType jointype, int mode, double distance);
+float8 gserialized_sel_internal(PlannerInfo *root, List *args, int varRelid, int mode, double distance);
 
 /* Old Prototype */
 Datum geometry_estimated_extent(PG_FUNCTION_ARGS);
@@ -160,6 +160,14 @@ Datum geometry_estimated_extent(PG_FUNCTION_ARGS);
 #define STATISTIC_KIND_ND 102
 #define STATISTIC_KIND_2D 103
 
+/*
+ * Adaptive (k-d tree) histograms. ANALYZE stores them in
+ * the slot of the grid they replace, so a column carries
+ * one kind or the other for each mode.
+ */
+#define STATISTIC_KIND_ND_TREE 104
+#define STATISTIC_KIND_2D_TREE 105
+
 /*
  * Postgres does not pin its slots and uses them as they come.
  * We need to preserve its Correlation for brin to work
@@ -205,6 +213,15 @@ Datum geometry_estimated_extent(PG_FUNCTION_ARGS);
 #define FALLBACK_ND_SEL 0.2
 #define FALLBACK_ND_JOINSEL 0.3
 
+/**
+* Adaptive histogram cells holding no more than this many
+* sample features are not split any further.
+*/
+#define ND_TREE_LEAF_FEATURES 10
+
+/* Build adaptive histograms in ANALYZE, GUC postgis.adaptive_histogram */
+bool adaptive_histogram = false;
+
 typedef struct {
 	/* Saved state from std_typanalyze() */
 	AnalyzeAttrComputeStatsFunc std_compute_stats;
@@ -420,6 +437,39 @@ nd_stats_to_json(const ND_STATS *nd_stats)
 	return str;
 }
 
+/**
+* Convert an #ND_TREE_STATS to a JSON representation for
+* external use.
+*/
+static char*
+nd_tree_stats_to_json(const ND_TREE_STATS *nd_tree)
+{
+	char *json_extent, *str;
+	stringbuffer_t *sb = stringbuffer_create();
+	int ndims = (int)roundf(nd_tree->ndims);
+
+	stringbuffer_append(sb, "{");
+	stringbuffer_aprintf(sb, "\"ndims\":%d,", ndims);
+	stringbuffer_aprintf(sb, "\"nodes\":%d,", (int)roundf(nd_tree->nnodes));
+
+	/* Extent */
+	json_extent = nd_box_to_json(&(nd_tree->extent), ndims);
+	stringbuffer_aprintf(sb, "\"extent\":%s,", json_extent);
+	pfree(json_extent);
+
+	stringbuffer_aprintf(sb, "\"table_features\":%d,", (int)roundf(nd_tree->table_features));
+	stringbuffer_aprintf(sb, "\"sample_features\":%d,", (int)roundf(nd_tree->sample_features));
+	stringbuffer_aprintf(sb, "\"not_null_features\":%d,", (int)roundf(nd_tree->not_null_features));
+	stringbuffer_aprintf(sb, "\"histogram_features\":%d,", (int)roundf(nd_tree->histogram_features));
+	stringbuffer_aprintf(sb, "\"histogram_cells\":%d,", (int)roundf(nd_tree->histogram_cells));
+	stringbuffer_aprintf(sb, "\"cells_covered\":%d", (int)roundf(nd_tree->cells_covered));
+	stringbuffer_append(sb, "}");
+
+	str = stringbuffer_getstringcopy(sb);
+	stringbuffer_destroy(sb);
+	return str;
+}
+
 
 /**
 * Create a printable view of the #ND_STATS histogram.
@@ -574,6 +624,21 @@ nd_box_expand(ND_BOX *nd_box, double expansion_factor)
 	return true;
 }
 
+/**
+* Grow the box by distance on every side in the first ndims
+* dimensions. Used to estimate "within distance" searches.
+*/
+static inline void
+nd_box_dilate(ND_BOX *nd_box, double distance, int ndims)
+{
+	int d;
+	for ( d = 0; d < ndims; d++ )
+	{
+		nd_box->min[d] -= distance;
+		nd_box->max[d] += distance;
+	}
+}
+
 /**
 * What stats cells overlap with this ND_BOX? Put the lowest cell
 * addresses in ND_IBOX->min and the highest in ND_IBOX->max
@@ -764,17 +829,13 @@ nd_increment(ND_IBOX *ibox, int ndims, int *counter)
 	return true;
 }
 
-static ND_STATS*
-pg_nd_stats_from_tuple(HeapTuple stats_tuple, int mode)
+static float4*
+pg_stats_numbers_from_tuple(HeapTuple stats_tuple, int stats_kind, int *nnumbers)
 {
-	int stats_kind = STATISTIC_KIND_ND;
 	int rv;
-	ND_STATS *nd_stats;
+	float4 *numbers;
 
-	/* If we're in 2D mode, set the kind appropriately */
-	if ( mode == 2 ) stats_kind = STATISTIC_KIND_2D;
-
-    /* Then read the geom status histogram from that */
+    /* Read the geom status histogram from the tuple */
 	{
 		AttStatsSlot sslot;
 		rv = get_attstatsslot(&sslot, stats_tuple, stats_kind, InvalidOid,
@@ -785,12 +846,47 @@ pg_nd_stats_from_tuple(HeapTuple stats_tuple, int mode)
 		}
 
 		/* Clone the stats here so we can release the attstatsslot immediately */
-		nd_stats = palloc(sizeof(float4) * sslot.nnumbers);
-		memcpy(nd_stats, sslot.numbers, sizeof(float4) * sslot.nnumbers);
+		numbers = palloc(sizeof(float4) * sslot.nnumbers);
+		memcpy(numbers, sslot.numbers, sizeof(float4) * sslot.nnumbers);
+		*nnumbers = sslot.nnumbers;
 
 		free_attstatsslot(&sslot);
 	}
-	return nd_stats;
+	return numbers;
+}
+
+/**
+* Read the histogram of the given mode from a stats tuple.
+* ANALYZE stores either a grid or an adaptive histogram for
+* each mode. Adaptive histograms are returned in nd_tree
+* (and NULL is returned), or ignored when nd_tree is NULL.
+*/
+static ND_STATS*
+pg_nd_stats_from_tuple(HeapTuple stats_tuple, int mode, ND_TREE_STATS **nd_tree)
+{
+	int nnumbers;
+
+	if ( nd_tree )
+	{
+		int stats_kind = ( mode == 2 ? STATISTIC_KIND_2D_TREE : STATISTIC_KIND_ND_TREE );
+		ND_TREE_STATS *tree = (ND_TREE_STATS*)pg_stats_numbers_from_tuple(stats_tuple, stats_kind, &nnumbers);
+
+		/* Do not walk off the end of a truncated node array */
+		if ( tree && (tree->nnodes < 1 ||
+		     offsetof(ND_TREE_STATS, node) / sizeof(float4) + (size_t)tree->nnodes * ND_TREE_NODE_SIZE > (size_t)nnumbers) )
+		{
+			POSTGIS_DEBUG(2, "adaptive histogram in stats tuple is malformed");
+			pfree(tree);
+			tree = NULL;
+		}
+
+		*nd_tree = tree;
+		if ( tree )
+			return NULL;
+	}
+
+	return (ND_STATS*)pg_stats_numbers_from_tuple(stats_tuple,
+		mode == 2 ? STATISTIC_KIND_2D : STATISTIC_KIND_ND, &nnumbers);
 }
 
 /**
@@ -798,11 +894,14 @@ pg_nd_stats_from_tuple(HeapTuple stats_tuple, int mode)
 * by the selectivity functions and the debugging functions.
 */
 static ND_STATS*
-pg_get_nd_stats(const Oid table_oid, AttrNumber att_num, int mode, bool only_parent)
+pg_get_nd_stats(const Oid table_oid, AttrNumber att_num, int mode, bool only_parent, ND_TREE_STATS **nd_tree)
 {
 	HeapTuple stats_tuple = NULL;
 	ND_STATS *nd_stats;
 
+	if ( nd_tree )
+		*nd_tree = NULL;
+
 	/* First pull the stats tuple for the whole tree */
 	if ( ! only_parent )
 	{
@@ -825,9 +924,9 @@ pg_get_nd_stats(const Oid table_oid, AttrNumber att_num, int mode, bool only_par
 		return NULL;
 	}
 
-	nd_stats = pg_nd_stats_from_tuple(stats_tuple, mode);
+	nd_stats = pg_nd_stats_from_tuple(stats_tuple, mode, nd_tree);
 	ReleaseSysCache(stats_tuple);
-	if ( ! nd_stats )
+	if ( ! nd_stats && ! (nd_tree && *nd_tree) )
 	{
 		POSTGIS_DEBUGF(2,
 			"histogram for attribute %d of table \"%s\" does not exist?",
@@ -846,7 +945,7 @@ pg_get_nd_stats(const Oid table_oid, AttrNumber att_num, int mode, bool only_par
 * table ignoring any statistic collected from the children.
 */
 static ND_STATS*
-pg_get_nd_stats_by_name(const Oid table_oid, const text *att_text, int mode, bool only_parent)
+pg_get_nd_stats_by_name(const Oid table_oid, const text *att_text, int mode, bool only_parent, ND_TREE_STATS **nd_tree)
 {
 	const char *att_name = text_to_cstring(att_text);
 	AttrNumber att_num;
@@ -867,7 +966,63 @@ pg_get_nd_stats_by_name(const Oid table_oid, const text *att_text, int mode, boo
 		return NULL;
 	}
 
-	return pg_get_nd_stats(table_oid, att_num, mode, only_parent);
+	return pg_get_nd_stats(table_oid, att_num, mode, only_parent, nd_tree);
+}
+
+/**
+* Sum the values of the #ND_STATS cells that nd_box overlaps,
+* pro-rating each cell by the portion of it the box covers.
+*/
+static double
+nd_stats_count(const ND_STATS *nd_stats, const ND_BOX *nd_box, int ndims)
+{
+	int d; /* counter */
+	ND_IBOX nd_ibox;
+	int at[ND_DIMS];
+	double cell_size[ND_DIMS];
+	double min[ND_DIMS];
+	double max[ND_DIMS];
+	double total_count = 0.0;
+
+	/* Calculate the overlap of the box on the histogram */
+	nd_box_overlap(nd_stats, nd_box, &nd_ibox);
+
+	/* Work out some measurements of the histogram */
+	for ( d = 0; d < nd_stats->ndims; d++ )
+	{
+		/* Cell size in each dim */
+		min[d] = nd_stats->extent.min[d];
+		max[d] = nd_stats->extent.max[d];
+		cell_size[d] = (max[d] - min[d]) / nd_stats->size[d];
+		POSTGIS_DEBUGF(3, " cell_size[%d] : %.9g", d, cell_size[d]);
+
+		/* Initialize the counter */
+		at[d] = nd_ibox.min[d];
+	}
+
+	/* Move through all the overlap values and sum them */
+	do
+	{
+		float cell_count, ratio;
+		ND_BOX nd_cell = { {0.0, 0.0, 0.0, 0.0}, {0.0, 0.0, 0.0, 0.0} };
+
+		/* We have to pro-rate partially overlapped cells. */
+		for ( d = 0; d < nd_stats->ndims; d++ )
+		{
+			nd_cell.min[d] = min[d] + (at[d]+0) * cell_size[d];
+			nd_cell.max[d] = min[d] + (at[d]+1) * cell_size[d];
+		}
+
+		ratio = nd_box_ratio(nd_box, &nd_cell, ndims);
+		cell_count = nd_stats->value[nd_stats_value_index(nd_stats, at)];
+
+		/* Add the pro-rated count for this cell to the overall total */
+		total_count += (double)cell_count * ratio;
+		POSTGIS_DEBUGF(4, " cell (%d,%d), cell value %.6f, ratio %.6f", at[0], at[1], cell_count, ratio);
+	}
+	while ( nd_increment(&nd_ibox, nd_stats->ndims, at) );
+
+	return total_count;
 }
 
 /**
@@ -882,9 +1037,13 @@ pg_get_nd_stats_by_name(const Oid table_oid, const text *att_text, int mode, boo
 * of one histogram, and multiply the cell value by the
 * proportion of the cells in the other histogram the cell
 * overlaps: val += val1 * ( val2 * overlap_ratio )
+*
+* For joins on "within distance" functions, distance is the
+* search radius, and each cell is grown by it before we
+* work out the overlap.
 */
 static float8
-estimate_join_selectivity(const ND_STATS *s1, const ND_STATS *s2)
+estimate_join_selectivity(const ND_STATS *s1, const ND_STATS *s2, double distance)
 {
 	int ncells1, ncells2;
 	int ndims1, ndims2, ndims;
@@ -948,6 +1107,10 @@ estimate_join_selectivity(const ND_STATS *s1, const ND_STATS *s2)
 	extent1 = s1->extent;
 	extent2 = s2->extent;
 
+	/* Only the parts of s1 within distance of s2 take part in the join */
+	if ( distance > 0.0 )
+		nd_box_dilate(&extent2, distance, ndims);
+
 	/* If relation stats do not intersect, join is very very selective. */
 	if ( ! nd_box_intersects(&extent1, &extent2, ndims) )
 	{
@@ -996,6 +1159,8 @@ estimate_join_selectivity(const ND_STATS *s1, const ND_STATS *s2)
 			nd_cell1.min[d] = min1[d] + (at1[d]+0) * cellsize1[d];
 			nd_cell1.max[d] = min1[d] + (at1[d]+1) * cellsize1[d];
 		}
+		if ( distance > 0.0 )
+			nd_box_dilate(&nd_cell1, distance, ndims1);
 
 		/* Find the cells of s2 that cell1 overlaps.. */
 		nd_box_overlap(s2, &nd_cell1, &ibox2);
@@ -1084,12 +1249,131 @@ estimate_join_selectivity(const ND_STATS *s1, const ND_STATS *s2)
 	return selectivity;
 }
 
+/**
+* Sum, over the leaves of the adaptive histogram t1 below node,
+* the leaf value times the count of features of the other
+* histogram (t2 or s2) within the leaf cell.
+*/
+static double
+nd_tree_join_count(const ND_TREE_STATS *t1, int node, ND_BOX cell,
+                   const ND_STATS *s2, const ND_TREE_STATS *t2, int ndims, double distance, int depth)
+{
+	ND_BOX search = cell;
+	ND_BOX extent2 = t2 ? t2->extent : s2->extent;
+	const float4 *n;
+	int d;
+
+	if ( node < 0 || node >= (int)t1->nnodes || depth > ND_TREE_MAX_DEPTH )
+		return 0.0;
+
+	/* Cells too far from the other histogram find nothing to join with */
+	if ( distance > 0.0 )
+	{
+		nd_box_dilate(&search, distance, ndims);
+		nd_box_dilate(&extent2, distance, ndims);
+	}
+	if ( ! nd_box_intersects(&cell, &extent2, ndims) )
+		return 0.0;
+
+	n = t1->node + node * ND_TREE_NODE_SIZE;
+	d = (int)n[0];
+	if ( d < 0 )
+	{
+		if ( n[1] == 0.0 )
+			return 0.0;
+		return n[1] * (t2 ? nd_tree_count(t2, &search, ndims) : nd_stats_count(s2, &search, ndims));
+	}
+	else
+	{
+		ND_BOX left = cell, right = cell;
+		int right_node = (int)n[2];
+
+		if ( d >= (int)t1->ndims || right_node <= node + 1 )
+			return 0.0;
+
+		left.max[d] = right.min[d] = n[1];
+		return nd_tree_join_count(t1, node + 1, left, s2, t2, ndims, distance, depth + 1) +
+		       nd_tree_join_count(t1, right_node, right, s2, t2, ndims, distance, depth + 1);
+	}
+}
+
+/**
+* The estimate_join_selectivity() counterpart for when at least
+* one side has an adaptive histogram. Each side is either a grid
+* (s1, s2) or a tree (t1, t2). We drive the summation with the
+* leaves of a tree: val += val1 * count2(leaf1), growing
+* the leaves by distance as estimate_join_selectivity() does.
+*/
+static float8
+estimate_join_selectivity_tree(const ND_STATS *s1, const ND_TREE_STATS *t1,
+                               const ND_STATS *s2, const ND_TREE_STATS *t2, double distance)
+{
+	double ntuples_max;
+	double ntuples_not_null1, ntuples_not_null2;
+	double table_features2, sample_features2, not_null_features2;
+	int ndims;
+	double val;
+	float8 selectivity;
+
+	/* Drive with a tree, the one with fewer leaves if there are two */
+	if ( ! t1 || (t2 && t1->histogram_cells > t2->histogram_cells) )
+	{
+		const ND_STATS *stats_tmp = s1;
+		const ND_TREE_STATS *tree_tmp = t1;
+		s1 = s2;
+		t1 = t2;
+		s2 = stats_tmp;
+		t2 = tree_tmp;
+	}
+
+	/* Drop out on null inputs */
+	if ( ! ( t1 && (s2 || t2) ) )
+	{
+		elog(NOTICE, " estimate_join_selectivity_tree called with null inputs");
+		return FALLBACK_ND_SEL;
+	}
+
+	table_features2 = t2 ? t2->table_features : s2->table_features;
+	sample_features2 = t2 ? t2->sample_features : s2->sample_features;
+	not_null_features2 = t2 ? t2->not_null_features : s2->not_null_features;
+	ndims = Max((int)roundf(t1->ndims), (int)roundf(t2 ? t2->ndims : s2->ndims));
+
+	POSTGIS_DEBUGF(3, "t1: %s", nd_tree_stats_to_json(t1));
+
+	/* The largest possible join is the product of the # of non-null rows */
+	ntuples_not_null1 = t1->table_features * ((double)t1->not_null_features / t1->sample_features);
+	ntuples_not_null2 = table_features2 * (not_null_features2 / sample_features2);
+	ntuples_max = ntuples_not_null1 * ntuples_not_null2;
+
+	val = nd_tree_join_count(t1, 0, t1->extent, s2, t2, ndims, distance, 0);
+	POSTGIS_DEBUGF(3, "val of histogram = %g", val);
+
+	/* Scale val up to a full table estimate, as estimate_join_selectivity() does */
+	val *= (t1->table_features / t1->sample_features);
+	val *= (table_features2 / sample_features2);
+
+	selectivity = val / ntuples_max;
+
+	/* Guard against over-estimates and crazy numbers :) */
+	if ( isnan(selectivity) || ! isfinite(selectivity) || selectivity < 0.0 )
+	{
+		selectivity = DEFAULT_ND_JOINSEL;
+	}
+	else if ( selectivity > 1.0 )
+	{
+		selectivity = 1.0;
+	}
+
+	return selectivity;
+}
+
 double
-gserialized_joinsel_internal(PlannerInfo *root, List *args, JoinType jointype, int mode)
+gserialized_joinsel_internal(PlannerInfo *root, List *args, JoinType jointype, int mode, double distance)
 {
 	float8 selectivity;
 	Oid relid1, relid2;
 	ND_STATS *stats1, *stats2;
+	ND_TREE_STATS *tree1, *tree2;
 	Node *arg1 = (Node*) linitial(args);
 	Node *arg2 = (Node*) lsecond(args);
 	Var *var1 = (Var*) arg1;
@@ -1110,25 +1394,30 @@ gserialized_joinsel_internal(PlannerInfo *root, List *args, JoinType jointype, i
 	relid2 = rt_fetch(var2->varno, root->parse->rtable)->relid;
 
 	/* Pull the stats from the stats system. */
-	stats1 = pg_get_nd_stats(relid1, var1->varattno, mode, false);
-	stats2 = pg_get_nd_stats(relid2, var2->varattno, mode, false);
+	stats1 = pg_get_nd_stats(relid1, var1->varattno, mode, false, &tree1);
+	stats2 = pg_get_nd_stats(relid2, var2->varattno, mode, false, &tree2);
 
 	/* If we can't get stats, we have to stop here! */
-	if (!stats1)
+	if (!stats1 && !tree1)
 	{
 		POSTGIS_DEBUGF(2, "%s: cannot find stats for \"%s\"",  __func__, get_rel_name(relid2) ? get_rel_name(relid2) : "NULL");
 		return DEFAULT_ND_JOINSEL;
 	}
-	else if (!stats2)
+	else if (!stats2 && !tree2)
 	{
 		POSTGIS_DEBUGF(2, "%s: cannot find stats for \"%s\"",  __func__, get_rel_name(relid2) ? get_rel_name(relid2) : "NULL");
 		return DEFAULT_ND_JOINSEL;
 	}
 
-	selectivity = estimate_join_selectivity(stats1, stats2);
+	if (tree1 || tree2)
+		selectivity = estimate_join_selectivity_tree(stats1, tree1, stats2, tree2, distance);
+	else
+		selectivity = estimate_join_selectivity(stats1, stats2, distance);
 	POSTGIS_DEBUGF(2, "got selectivity %g", selectivity);
-	pfree(stats1);
-	pfree(stats2);
+	if (stats1) pfree(stats1);
+	if (stats2) pfree(stats2);
+	if (tree1) pfree(tree1);
+	if (tree2) pfree(tree2);
 	return selectivity;
 }
 
@@ -1165,7 +1454,7 @@ Datum gserialized_gist_joinsel(PG_FUNCTION_ARGS)
 		PG_RETURN_FLOAT8(DEFAULT_ND_JOINSEL);
 	}
 
-	PG_RETURN_FLOAT8(gserialized_joinsel_internal(root, args, jointype, mode));
+	PG_RETURN_FLOAT8(gserialized_joinsel_internal(root, args, jointype, mode, 0.0));
 }
 
 /**
@@ -1202,6 +1491,289 @@ gserialized_gist_joinsel_2d(PG_FUNCTION_ARGS)
 					    ));
 }
 
+/**
+* State of an adaptive histogram under construction.
+*/
+typedef struct
+{
+	int ndims;           /* Dimensionality of the sample */
+	ND_BOX extent;       /* Extent of the histogram */
+	int leaf_features;   /* Cells with more features than this get split */
+	float4 *node;        /* Preorder nodes, ND_TREE_NODE_SIZE floats each */
+	int nnodes;          /* Nodes in use */
+	int max_nodes;       /* Nodes allocated */
+	int nleaves;         /* Leaves, the cells of the histogram */
+} ND_TREE_BUILD;
+
+static inline double
+nd_box_center(const ND_BOX *nd_box, int d)
+{
+	return ((double)nd_box->min[d] + (double)nd_box->max[d]) / 2.0;
+}
+
+static int
+cmp_nd_box_center(const void *a, const void *b, void *arg)
+{
+	int d = *((int*)arg);
+	double ca = nd_box_center(*((const ND_BOX**)a), d);
+	double cb = nd_box_center(*((const ND_BOX**)b), d);
+	return ca < cb ? -1 : (ca > cb ? 1 : 0);
+}
+
+/**
+* Find where to split a cell holding nboxes features. We split the
+* dimension along which the feature centers spread widest relative
+* to the histogram extent, so that narrow cells get split across,
+* at the median center, moved to the nearest gap between distinct
+* centers. The boxes come back sorted so that the first
+* split_at of them go to the lower child.
+*/
+static bool
+nd_tree_split(const ND_TREE_BUILD *b, const ND_BOX *cell, const ND_BOX **boxes, int nboxes,
+              int *split_dim, float4 *split_value, int *split_at)
+{
+	int d, i, k;
+	int dim = -1;
+	int at = -1;
+	int mid = nboxes / 2;
+	double spread_max = 0.0;
+	double value;
+
+	for ( d = 0; d < b->ndims; d++ )
+	{
+		double width = (double)b->extent.max[d] - (double)b->extent.min[d];
+		double cmin = DBL_MAX;
+		double cmax = -DBL_MAX;
+		double spread;
+
+		if ( width < MIN_DIMENSION_WIDTH ||
+		     (double)cell->max[d] - (double)cell->min[d] < MIN_DIMENSION_WIDTH )
+			continue;
+
+		for ( i = 0; i < nboxes; i++ )
+		{
+			double c = nd_box_center(boxes[i], d);
+			cmin = Min(cmin, c);
+			cmax = Max(cmax, c);
+		}
+
+		spread = (cmax - cmin) / width;
+		if ( spread > spread_max )
+		{
+			spread_max = spread;
+			dim = d;
+		}
+	}
+
+	/* All the centers coincide, nothing to split on */
+	if ( dim < 0 )
+		return false;
+
+	qsort_arg(boxes, nboxes, sizeof(ND_BOX*), cmp_nd_box_center, &dim);
+
+	for ( k = 0; k < nboxes && at < 0; k++ )
+	{
+		if ( mid - k >= 1 && nd_box_center(boxes[mid-k-1], dim) < nd_box_center(boxes[mid-k], dim) )
+			at = mid - k;
+		else if ( mid + k >= 1 && mid + k < nboxes && nd_box_center(boxes[mid+k-1], dim) < nd_box_center(boxes[mid+k], dim) )
+			at = mid + k;
+	}
+	if ( at < 0 )
+		return false;
+
+	/* Both children have to keep some width */
+	value = (nd_box_center(boxes[at-1], dim) + nd_box_center(boxes[at], dim)) / 2.0;
+	if ( ! ((float4)value > cell->min[dim] && (float4)value < cell->max[dim]) )
+		return false;
+
+	*split_dim = dim;
+	*split_value = (float4)value;
+	*split_at = at;
+	return true;
+}
+
+static int
+nd_tree_add_node(ND_TREE_BUILD *b)
+{
+	if ( b->nnodes == b->max_nodes )
+	{
+		b->max_nodes *= 2;
+		b->node = repalloc(b->node, sizeof(float4) * ND_TREE_NODE_SIZE * b->max_nodes);
+	}
+	return b->nnodes++;
+}
+
+/**
+* Append the subtree for cell, holding nboxes features, in preorder.
+*/
+static void
+nd_tree_build_node(ND_TREE_BUILD *b, ND_BOX cell, const ND_BOX **boxes, int nboxes, int depth)
+{
+	int self = nd_tree_add_node(b);
+	int dim, at;
+	float4 value;
+
+	if ( nboxes > b->leaf_features && depth < ND_TREE_MAX_DEPTH &&
+	     nd_tree_split(b, &cell, boxes, nboxes, &dim, &value, &at) )
+	{
+		ND_BOX left = cell, right = cell;
+		left.max[dim] = right.min[dim] = value;
+
+		b->node[self * ND_TREE_NODE_SIZE + 0] = dim;
+		b->node[self * ND_TREE_NODE_SIZE + 1] = value;
+		nd_tree_build_node(b, left, boxes, at, depth + 1);
+		b->node[self * ND_TREE_NODE_SIZE + 2] = b->nnodes;
+		nd_tree_build_node(b, right, boxes + at, nboxes - at, depth + 1);
+	}
+	else
+	{
+		b->node[self * ND_TREE_NODE_SIZE + 0] = -1;
+		b->node[self * ND_TREE_NODE_SIZE + 1] = 0;
+		b->node[self * ND_TREE_NODE_SIZE + 2] = 0;
+		b->nleaves++;
+	}
+}
+
+/**
+* Add the portion of nd_box overlapping each leaf below node
+* to the leaf value, like the grid does for its cells.
+* Returns the total added.
+*/
+static double
+nd_tree_add_box(ND_TREE_BUILD *b, int node, ND_BOX cell, const ND_BOX *nd_box)
+{
+	float4 *n = b->node + node * ND_TREE_NODE_SIZE;
+	int d = (int)n[0];
+	double ratio = 0.0;
+
+	if ( d < 0 )
+	{
+		ratio = nd_box_ratio(&cell, nd_box, b->ndims);
+		n[1] += ratio;
+	}
+	else
+	{
+		ND_BOX left = cell, right = cell;
+		left.max[d] = right.min[d] = n[1];
+
+		if ( nd_box->min[d] < n[1] )
+			ratio += nd_tree_add_box(b, node + 1, left, nd_box);
+		if ( nd_box->max[d] > n[1] )
+			ratio += nd_tree_add_box(b, (int)n[2], right, nd_box);
+	}
+	return ratio;
+}
+
+/**
+* Count a feature in the leaf holding its center. Used for the
+* degenerate boxes that nd_box_ratio() gives no volume to.
+*/
+static void
+nd_tree_add_center(ND_TREE_BUILD *b, const ND_BOX *nd_box)
+{
+	int node = 0;
+
+	for (;;)
+	{
+		float4 *n = b->node + node * ND_TREE_NODE_SIZE;
+		int d = (int)n[0];
+
+		if ( d < 0 )
+		{
+			n[1] += 1.0;
+			return;
+		}
+		node = nd_box_center(nd_box, d) < n[1] ? node + 1 : (int)n[2];
+	}
+}
+
+/**
+* Build an adaptive histogram over the sample boxes, skipping the
+* NULLed out hard deviants. Rather than laying a uniform grid over
+* the extent, cells are split in two at the median feature until no
+* cell holds more than 2 * nboxes / cells_target features, so that
+* dense areas get small cells and empty ones no cells to speak of,
+* within the same cell budget as the grid. Leaf values are filled
+* the way grid cells are. The result is allocated in anl_context,
+* and the caller fills in the table level feature counts.
+*/
+static ND_TREE_STATS*
+nd_tree_stats_build(const ND_BOX **sample_boxes, int nboxes, const ND_BOX *extent, int ndims,
+                    int cells_target, MemoryContext anl_context, size_t *nd_tree_size)
+{
+	ND_TREE_BUILD b;
+	ND_TREE_STATS *nd_tree;
+	const ND_BOX **boxes;
+	MemoryContext old_context;
+	double total_cell_count = 0;
+	int histogram_features = 0;
+	int i;
+
+	/* Work on a copy of the surviving boxes, the splits reorder them */
+	boxes = palloc(sizeof(ND_BOX*) * Max(nboxes, 1));
+	for ( i = 0; i < nboxes; i++ )
+	{
+		if ( sample_boxes[i] )
+			boxes[histogram_features++] = sample_boxes[i];
+	}
+
+	if ( ! histogram_features )
+	{
+		pfree(boxes);
+		return NULL;
+	}
+
+	b.ndims = ndims;
+	b.extent = *extent;
+	b.leaf_features = ND_TREE_LEAF_FEATURES;
+	if ( cells_target > 0 )
+		b.leaf_features = Max(b.leaf_features, (int)ceil(2.0 * histogram_features / cells_target));
+	b.nnodes = 0;
+	b.nleaves = 0;
+	b.max_nodes = 64;
+	b.node = palloc(sizeof(float4) * ND_TREE_NODE_SIZE * b.max_nodes);
+
+	nd_tree_build_node(&b, *extent, boxes, histogram_features, 0);
+	POSTGIS_DEBUGF(3, " adaptive histogram: %d nodes, %d leaves", b.nnodes, b.nleaves);
+
+	for ( i = 0; i < histogram_features; i++ )
+	{
+		double num_cells;
+
+		/* Give backend a chance of interrupting us */
+#if POSTGIS_PGSQL_VERSION >= 180
+		vacuum_delay_point(true);
+#else
+		vacuum_delay_point();
+#endif
+
+		num_cells = nd_tree_add_box(&b, 0, *extent, boxes[i]);
+		if ( num_cells == 0.0 )
+		{
+			nd_tree_add_center(&b, boxes[i]);
+			num_cells = 1.0;
+		}
+		total_cell_count += num_cells;
+	}
+
+	old_context = MemoryContextSwitchTo(anl_context);
+	*nd_tree_size = offsetof(ND_TREE_STATS, node) + sizeof(float4) * ND_TREE_NODE_SIZE * b.nnodes;
+	nd_tree = palloc0(*nd_tree_size);
+	MemoryContextSwitchTo(old_context);
+
+	nd_tree->ndims = ndims;
+	nd_tree->nnodes = b.nnodes;
+	nd_tree->extent = *extent;
+	nd_tree->histogram_features = histogram_features;
+	nd_tree->histogram_cells = b.nleaves;
+	nd_tree->cells_covered = total_cell_count;
+	memcpy(nd_tree->node, b.node, sizeof(float4) * ND_TREE_NODE_SIZE * b.nnodes);
+
+	pfree(b.node);
+	pfree(boxes);
+	return nd_tree;
+}
+
 /**
  * The gserialized_analyze_nd sets this function as a
  * callback on the stats object when called by the ANALYZE
@@ -1437,6 +2009,47 @@ compute_gserialized_stats_mode(VacAttrStats *stats, AnalyzeAttrFetchFunc fetchfu
 	nd_box_expand(&histo_extent_new, 0.01);
 	histo_extent = histo_extent_new;
 
+	/*
+	 * With postgis.adaptive_histogram on, spend the cell budget
+	 * on a tree that splits where the sample is dense, and store
+	 * it in place of the uniform grid.
+	 */
+	if ( adaptive_histogram )
+	{
+		ND_TREE_STATS *nd_tree;
+		size_t nd_tree_size;
+
+		nd_tree = nd_tree_stats_build(sample_boxes, notnull_cnt, &histo_extent, ndims,
+		                              histo_cells_target, stats->anl_context, &nd_tree_size);
+		if ( ! nd_tree )
+		{
+			POSTGIS_DEBUG(3, " no stats have been gathered");
+			elog(NOTICE, " no features lie in the stats histogram, invalid stats");
+			stats->stats_valid = false;
+			return;
+		}
+
+		nd_tree->sample_features = sample_rows;
+		nd_tree->table_features = total_rows;
+		nd_tree->not_null_features = notnull_cnt;
+
+		stats_slot = ( mode == 2 ? STATISTIC_SLOT_2D : STATISTIC_SLOT_ND );
+		stats_kind = ( mode == 2 ? STATISTIC_KIND_2D_TREE : STATISTIC_KIND_ND_TREE );
+
+		/* Write the statistics data */
+		stats->stakind[stats_slot] = stats_kind;
+		stats->staop[stats_slot] = InvalidOid;
+		stats->stanumbers[stats_slot] = (float4*)nd_tree;
+		stats->numnumbers[stats_slot] = nd_tree_size/sizeof(float4);
+		stats->stanullfrac = (float4)null_cnt/sample_rows;
+		stats->stawidth = total_width/notnull_cnt;
+		stats->stadistinct = -1.0;
+		stats->stats_valid = true;
+
+		POSTGIS_DEBUGF(3, " out: %s", nd_tree_stats_to_json(nd_tree));
+		return;
+	}
+
 	/*
 	 * How should we allocate our histogram cells to the
 	 * different dimensions? We can't do it by raw dimensional width,
@@ -1782,14 +2395,8 @@ Datum gserialized_analyze_nd(PG_FUNCTION_ARGS)
 static float8
 estimate_selectivity(const GBOX *box, const ND_STATS *nd_stats, int mode)
 {
-	int d; /* counter */
 	float8 selectivity;
 	ND_BOX nd_box;
-	ND_IBOX nd_ibox;
-	int at[ND_DIMS];
-	double cell_size[ND_DIMS];
-	double min[ND_DIMS];
-	double max[ND_DIMS];
 	double total_count = 0.0;
 	int ndims_max;
 
@@ -1842,54 +2449,70 @@ estimate_selectivity(const GBOX *box, const ND_STATS *nd_stats, int mode)
 		return 1.0;
 	}
 
-	/* Calculate the overlap of the box on the histogram */
-	if ( ! nd_box_overlap(nd_stats, &nd_box, &nd_ibox) )
+	/* Sum the pro-rated values of the cells the search box overlaps */
+	total_count = nd_stats_count(nd_stats, &nd_box, nd_stats->ndims);
+
+	/* Scale by the number of features in our histogram to get the proportion */
+	selectivity = total_count / nd_stats->histogram_features;
+
+	POSTGIS_DEBUGF(3, " nd_stats->histogram_features = %f", nd_stats->histogram_features);
+	POSTGIS_DEBUGF(3, " nd_stats->histogram_cells = %f", nd_stats->histogram_cells);
+	POSTGIS_DEBUGF(3, " sum(overlapped histogram cells) = %f", total_count);
+	POSTGIS_DEBUGF(3, " selectivity = %f", selectivity);
+
+	/* Prevent rounding overflows */
+	if (selectivity > 1.0) selectivity = 1.0;
+	else if (selectivity < 0.0) selectivity = 0.0;
+
+	return selectivity;
+}
+
+/**
+* The estimate_selectivity() counterpart for an adaptive
+* histogram: sum the leaf values pro-rated by the portion
+* of each leaf cell within the search box.
+*/
+static float8
+estimate_tree_selectivity(const GBOX *box, const ND_TREE_STATS *nd_tree, int mode)
+{
+	float8 selectivity;
+	ND_BOX nd_box;
+	double total_count;
+	int ndims_max;
+
+	if ( ! nd_tree )
 	{
-		POSTGIS_DEBUG(3, " search box overlap with stats histogram failed");
+		elog(NOTICE, " estimate_tree_selectivity called with null input");
 		return FALLBACK_ND_SEL;
 	}
 
-	/* Work out some measurements of the histogram */
-	for ( d = 0; d < nd_stats->ndims; d++ )
-	{
-		/* Cell size in each dim */
-		min[d] = nd_stats->extent.min[d];
-		max[d] = nd_stats->extent.max[d];
-		cell_size[d] = (max[d] - min[d]) / nd_stats->size[d];
-		POSTGIS_DEBUGF(3, " cell_size[%d] : %.9g", d, cell_size[d]);
+	ndims_max = Max(nd_tree->ndims, gbox_ndims(box));
+	nd_box_from_gbox(box, &nd_box);
 
-		/* Initialize the counter */
-		at[d] = nd_ibox.min[d];
-	}
+	/* In 2D mode only the first two dimensions matter */
+	if ( mode == 2 )
+		ndims_max = 2;
 
-	/* Move through all the overlap values and sum them */
-	do
+	/* Search box completely misses histogram extent? */
+	if ( ! nd_box_intersects(&nd_box, &(nd_tree->extent), ndims_max) )
 	{
-		float cell_count, ratio;
-		ND_BOX nd_cell = { {0.0, 0.0, 0.0, 0.0}, {0.0, 0.0, 0.0, 0.0} };
-
-		/* We have to pro-rate partially overlapped cells. */
-		for ( d = 0; d < nd_stats->ndims; d++ )
-		{
-			nd_cell.min[d] = min[d] + (at[d]+0) * cell_size[d];
-			nd_cell.max[d] = min[d] + (at[d]+1) * cell_size[d];
-		}
-
-		ratio = nd_box_ratio(&nd_box, &nd_cell, nd_stats->ndims);
-		cell_count = nd_stats->value[nd_stats_value_index(nd_stats, at)];
+		POSTGIS_DEBUG(3, " search box does not overlap histogram, returning 0");
+		return 0.0;
+	}
 
-		/* Add the pro-rated count for this cell to the overall total */
-		total_count += (double)cell_count * ratio;
-		POSTGIS_DEBUGF(4, " cell (%d,%d), cell value %.6f, ratio %.6f", at[0], at[1], cell_count, ratio);
+	/* Search box completely contains histogram extent! */
+	if ( nd_box_contains(&nd_box, &(nd_tree->extent), ndims_max) )
+	{
+		POSTGIS_DEBUG(3, " search box contains histogram, returning 1");
+		return 1.0;
 	}
-	while ( nd_increment(&nd_ibox, nd_stats->ndims, at) );
+
+	total_count = nd_tree_count(nd_tree, &nd_box, nd_tree->ndims);
 
 	/* Scale by the number of features in our histogram to get the proportion */
-	selectivity = total_count / nd_stats->histogram_features;
+	selectivity = total_count / nd_tree->histogram_features;
 
-	POSTGIS_DEBUGF(3, " nd_stats->histogram_features = %f", nd_stats->histogram_features);
-	POSTGIS_DEBUGF(3, " nd_stats->histogram_cells = %f", nd_stats->histogram_cells);
-	POSTGIS_DEBUGF(3, " sum(overlapped histogram cells) = %f", total_count);
+	POSTGIS_DEBUGF(3, " sum(overlapped histogram leaves) = %f", total_count);
 	POSTGIS_DEBUGF(3, " selectivity = %f", selectivity);
 
 	/* Prevent rounding overflows */
@@ -1911,6 +2534,7 @@ Datum _postgis_gserialized_stats(PG_FUNCTION_ARGS)
 	Oid table_oid = PG_GETARG_OID(0);
 	text *att_text = PG_GETARG_TEXT_P(1);
 	ND_STATS *nd_stats;
+	ND_TREE_STATS *nd_tree;
 	char *str;
 	text *json;
 	int mode = 2; /* default to 2D mode */
@@ -1921,7 +2545,15 @@ Datum _postgis_gserialized_stats(PG_FUNCTION_ARGS)
 		mode = text_p_get_mode(PG_GETARG_TEXT_P(2));
 
 	/* Retrieve the stats object */
-	nd_stats = pg_get_nd_stats_by_name(table_oid, att_text, mode, only_parent);
+	nd_stats = pg_get_nd_stats_by_name(table_oid, att_text, mode, only_parent, &nd_tree);
+	if ( nd_tree )
+	{
+		str = nd_tree_stats_to_json(nd_tree);
+		json = cstring_to_text(str);
+		pfree(str);
+		pfree(nd_tree);
+		PG_RETURN_TEXT_P(json);
+	}
 	if ( ! nd_stats )
 		elog(ERROR, "stats for \"%s.%s\" do not exist", get_rel_name(table_oid), text_to_cstring(att_text));
 
@@ -1949,6 +2581,7 @@ Datum _postgis_gserialized_sel(PG_FUNCTION_ARGS)
 	GBOX gbox; /* search box read from gserialized datum */
 	float8 selectivity = 0;
 	ND_STATS *nd_stats;
+	ND_TREE_STATS *nd_tree;
 	int mode = 2; /* 2D mode by default */
 
 	/* Check if we've been asked to not use 2d mode */
@@ -1956,9 +2589,9 @@ Datum _postgis_gserialized_sel(PG_FUNCTION_ARGS)
 		mode = text_p_get_mode(PG_GETARG_TEXT_P(3));
 
 	/* Retrieve the stats object */
-	nd_stats = pg_get_nd_stats_by_name(table_oid, att_text, mode, false);
+	nd_stats = pg_get_nd_stats_by_name(table_oid, att_text, mode, false, &nd_tree);
 
-	if ( ! nd_stats )
+	if ( ! nd_stats && ! nd_tree )
 		elog(ERROR, "stats for \"%s.%s\" do not exist", get_rel_name(table_oid), text_to_cstring(att_text));
 
 	/* Calculate the gbox */
@@ -1968,9 +2601,16 @@ Datum _postgis_gserialized_sel(PG_FUNCTION_ARGS)
 	POSTGIS_DEBUGF(3, " %s", gbox_to_string(&gbox));
 
 	/* Do the estimation */
-	selectivity = estimate_selectivity(&gbox, nd_stats, mode);
-
-	pfree(nd_stats);
+	if ( nd_tree )
+	{
+		selectivity = estimate_tree_selectivity(&gbox, nd_tree, mode);
+		pfree(nd_tree);
+	}
+	else
+	{
+		selectivity = estimate_selectivity(&gbox, nd_stats, mode);
+		pfree(nd_stats);
+	}
 	PG_RETURN_FLOAT8(selectivity);
 }
 
@@ -1987,18 +2627,19 @@ Datum _postgis_gserialized_joinsel(PG_FUNCTION_ARGS)
 	Oid table_oid2 = PG_GETARG_OID(2);
 	text *att_text2 = PG_GETARG_TEXT_P(3);
 	ND_STATS *nd_stats1, *nd_stats2;
+	ND_TREE_STATS *nd_tree1, *nd_tree2;
 	float8 selectivity = 0;
 	int mode = 2; /* 2D mode by default */
 
 
 	/* Retrieve the stats object */
-	nd_stats1 = pg_get_nd_stats_by_name(table_oid1, att_text1, mode, false);
-	nd_stats2 = pg_get_nd_stats_by_name(table_oid2, att_text2, mode, false);
+	nd_stats1 = pg_get_nd_stats_by_name(table_oid1, att_text1, mode, false, &nd_tree1);
+	nd_stats2 = pg_get_nd_stats_by_name(table_oid2, att_text2, mode, false, &nd_tree2);
 
-	if ( ! nd_stats1 )
+	if ( ! nd_stats1 && ! nd_tree1 )
 		elog(ERROR, "stats for \"%s.%s\" do not exist", get_rel_name(table_oid1), text_to_cstring(att_text1));
 
-	if ( ! nd_stats2 )
+	if ( ! nd_stats2 && ! nd_tree2 )
 		elog(ERROR, "stats for \"%s.%s\" do not exist", get_rel_name(table_oid2), text_to_cstring(att_text2));
 
 	/* Check if we've been asked to not use 2d mode */
@@ -2011,10 +2652,15 @@ Datum _postgis_gserialized_joinsel(PG_FUNCTION_ARGS)
 	}
 
 	/* Do the estimation */
-	selectivity = estimate_join_selectivity(nd_stats1, nd_stats2);
+	if ( nd_tree1 || nd_tree2 )
+		selectivity = estimate_join_selectivity_tree(nd_stats1, nd_tree1, nd_stats2, nd_tree2, 0.0);
+	else
+		selectivity = estimate_join_selectivity(nd_stats1, nd_stats2, 0.0);
 
-	pfree(nd_stats1);
-	pfree(nd_stats2);
+	if ( nd_stats1 ) pfree(nd_stats1);
+	if ( nd_stats2 ) pfree(nd_stats2);
+	if ( nd_tree1 ) pfree(nd_tree1);
+	if ( nd_tree2 ) pfree(nd_tree2);
 	PG_RETURN_FLOAT8(selectivity);
 }
 
@@ -2033,12 +2679,13 @@ Datum _postgis_gserialized_joinsel(PG_FUNCTION_ARGS)
  */
 
 float8
-gserialized_sel_internal(PlannerInfo *root, List *args, int varRelid, int mode)
+gserialized_sel_internal(PlannerInfo *root, List *args, int varRelid, int mode, double distance)
 {
 	VariableStatData vardata;
 	Node *other = NULL;
 	bool varonleft;
 	ND_STATS *nd_stats = NULL;
+	ND_TREE_STATS *nd_tree = NULL;
 
 	GBOX search_box;
 	float8 selectivity = 0;
@@ -2074,14 +2721,24 @@ gserialized_sel_internal(PlannerInfo *root, List *args, int varRelid, int mode)
 		return 0.0;
 	}
 
+	/* Searching within distance of the constant is searching its grown box */
+	if (distance > 0.0)
+		gbox_expand(&search_box, distance);
+
 	if (!vardata.statsTuple)
 	{
 		POSTGIS_DEBUGF(1, "%s: no statistics available on table. Empty? Need to ANALYZE?", __func__);
 		return DEFAULT_ND_SEL;
 	}
 
-	nd_stats = pg_nd_stats_from_tuple(vardata.statsTuple, mode);
+	nd_stats = pg_nd_stats_from_tuple(vardata.statsTuple, mode, &nd_tree);
 	ReleaseVariableStats(vardata);
+	if (nd_tree)
+	{
+		selectivity = estimate_tree_selectivity(&search_box, nd_tree, mode);
+		pfree(nd_tree);
+		return selectivity;
+	}
 	selectivity = estimate_selectivity(&search_box, nd_stats, mode);
 	if (nd_stats)
 		pfree(nd_stats);
@@ -2097,7 +2754,7 @@ Datum gserialized_gist_sel(PG_FUNCTION_ARGS)
 	List *args = (List *) PG_GETARG_POINTER(2);
 	int varRelid = PG_GETARG_INT32(3);
 	int mode = PG_GETARG_INT32(4);
-	float8 selectivity = gserialized_sel_internal(root, args, varRelid, mode);
+	float8 selectivity = gserialized_sel_internal(root, args, varRelid, mode, 0.0);
 	POSTGIS_DEBUGF(2, "%s: selectivity is %g", __func__, selectivity);
 	PG_RETURN_FLOAT8(selectivity);
 }
@@ -2452,6 +3109,8 @@ Datum gserialized_estimated_extent(PG_FUNCTION_ARGS)
 	char *tbl = NULL;
 	Oid tbl_oid, idx_oid = 0;
 	ND_STATS *nd_stats;
+	ND_TREE_STATS *nd_tree;
+	const ND_BOX *extent;
 	GBOX *gbox = NULL;
 	bool only_parent = false;
 	int key_type;
@@ -2520,29 +3179,33 @@ Datum gserialized_estimated_extent(PG_FUNCTION_ARGS)
 			stats_mode = 3;
 
 		/* ND stats include an extent for the histogram */
-		nd_stats = pg_get_nd_stats_by_name(tbl_oid, coltxt, stats_mode, only_parent);
+		nd_stats = pg_get_nd_stats_by_name(tbl_oid, coltxt, stats_mode, only_parent, &nd_tree);
 
 		/* Error out on no stats */
-		if (!nd_stats)
+		if (!nd_stats && !nd_tree)
 		{
 			elog(WARNING, "stats for \"%s.%s\" do not exist", tbl, col);
 			PG_RETURN_NULL();
 		}
 
+		/* Both histogram kinds carry the extent */
+		extent = nd_tree ? &(nd_tree->extent) : &(nd_stats->extent);
+
 		/* Construct the box */
 		gbox = gbox_new(0);
-		gbox->xmin = nd_stats->extent.min[0];
-		gbox->xmax = nd_stats->extent.max[0];
-		gbox->ymin = nd_stats->extent.min[1];
-		gbox->ymax = nd_stats->extent.max[1];
+		gbox->xmin = extent->min[0];
+		gbox->xmax = extent->max[0];
+		gbox->ymin = extent->min[1];
+		gbox->ymax = extent->max[1];
 		if (stats_mode != 2)
 		{
 			FLAGS_SET_Z(gbox->flags, 1);
-			gbox->zmin = nd_stats->extent.min[2];
-			gbox->zmax = nd_stats->extent.max[2];
+			gbox->zmin = extent->min[2];
+			gbox->zmax = extent->max[2];
 		}
 
-		pfree(nd_stats);
+		if (nd_stats) pfree(nd_stats);
+		if (nd_tree) pfree(nd_tree);
 	}
 
 	/* Convert geocentric geography box into a planar box */
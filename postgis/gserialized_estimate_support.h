@@ -44,6 +44,9 @@
 #include <limits.h>
 #include <math.h>
 
+/* Build the adaptive (k-d tree) histogram in ANALYZE, GUC postgis.adaptive_histogram */
+extern bool adaptive_histogram;
+
 /* The maximum number of dimensions our statistics code supports. */
 #define ND_DIMS 4
 
@@ -73,6 +76,32 @@ typedef struct ND_STATS_T {
 	float4 value[1];
 } ND_STATS;
 
+/*
+ * On-disk representation of the adaptive histogram emitted by ANALYZE
+ * when postgis.adaptive_histogram is on.  The nodes of a k-d tree over
+ * the histogram extent are stored in preorder, ND_TREE_NODE_SIZE floats
+ * each: the split dimension (negative for a leaf), the split value (the
+ * feature count for a leaf) and the index of the right child.  The left
+ * child of an inner node always directly follows it.
+ */
+typedef struct ND_TREE_STATS_T {
+	float4 ndims;
+	float4 nnodes;
+	ND_BOX extent;
+	float4 table_features;
+	float4 sample_features;
+	float4 not_null_features;
+	float4 histogram_features;
+	float4 histogram_cells;
+	float4 cells_covered;
+	float4 node[1];
+} ND_TREE_STATS;
+
+#define ND_TREE_NODE_SIZE 3
+
+/* Deepest tree ANALYZE builds, and the deepest one we are willing to walk. */
+#define ND_TREE_MAX_DEPTH 64
+
 /*
  * Return the flattened index for the histogram coordinate expressed by
  * 'indexes'.  A negative result signals that one of the axes fell outside
@@ -234,4 +263,53 @@ nd_box_ratio(const ND_BOX *cover, const ND_BOX *target, int ndims)
 	return ivol / refvol;
 }
 
+/*
+ * Sum the leaf counts of the subtree rooted at 'node', each pro-rated by
+ * the portion of its cell covered by 'box'.  'cell' is the extent of
+ * 'node'.  Subtrees that 'box' misses are not visited; malformed trees
+ * (children that do not follow their parent, split dimensions out of
+ * range, excessive depth) count as empty rather than being trusted.
+ */
+static inline double
+nd_tree_count_node(const ND_TREE_STATS *tree, int node, ND_BOX cell, const ND_BOX *box, int ndims, int depth)
+{
+	const float4 *n;
+	ND_BOX left, right;
+	int d, right_node;
+
+	if (node < 0 || node >= (int)(tree->nnodes) || depth > ND_TREE_MAX_DEPTH)
+		return 0.0;
+
+	for (d = 0; d < ndims; d++)
+	{
+		if (box->max[d] < cell.min[d] || box->min[d] > cell.max[d])
+			return 0.0;
+	}
+
+	n = tree->node + node * ND_TREE_NODE_SIZE;
+	d = (int)(n[0]);
+	if (d < 0)
+		return n[1] * nd_box_ratio(box, &cell, ndims);
+
+	right_node = (int)(n[2]);
+	if (d >= (int)(tree->ndims) || right_node <= node + 1)
+		return 0.0;
+
+	left = right = cell;
+	left.max[d] = n[1];
+	right.min[d] = n[1];
+	return nd_tree_count_node(tree, node + 1, left, box, ndims, depth + 1) +
+	       nd_tree_count_node(tree, right_node, right, box, ndims, depth + 1);
+}
+
+/*
+ * Adaptive histogram counterpart of summing the overlapped cells of an
+ * ND_STATS grid: the number of histogram features falling in 'box'.
+ */
+static inline double
+nd_tree_count(const ND_TREE_STATS *tree, const ND_BOX *box, int ndims)
+{
+	return nd_tree_count_node(tree, 0, tree->extent, box, ndims, 0);
+}
+
 #endif /* POSTGIS_GSERIALIZED_ESTIMATE_SUPPORT_H */
@@ -42,6 +42,7 @@
 #include "access/gist.h"    /* For GiST */
 #include "access/itup.h"
 #include "access/skey.h"
+#include "access/reloptions.h" /* For opclass options */
 #include "utils/sortsupport.h"    /* For index building sort support */
 
 #include "../postgis_config.h"
@@ -60,6 +61,20 @@
 /* How many index tuples does one page fit? Recursive splits will target this. */
 #define INDEX_TUPLES_PER_PAGE 291
 
+/* Minimum share of the entries each side of an R*-tree split gets */
+#define RSTAR_MIN_FILL 0.4
+
+/* Node split strategies, selected with the "split" opclass option */
+#define GIST_SPLIT_DOUBLE_SORTING 0
+#define GIST_SPLIT_RSTAR 1
+
+/* Options of the 2D GiST opclass */
+typedef struct
+{
+	int32 vl_len_; /* varlena header (do not touch directly!) */
+	int split;     /* node split strategy */
+} GistBox2DFOptions;
+
 /*
 ** For debugging
 */
@@ -82,6 +97,7 @@ Datum gserialized_gist_compress_2d(PG_FUNCTION_ARGS);
 Datum gserialized_gist_decompress_2d(PG_FUNCTION_ARGS);
 Datum gserialized_gist_penalty_2d(PG_FUNCTION_ARGS);
 Datum gserialized_gist_picksplit_2d(PG_FUNCTION_ARGS);
+Datum gserialized_gist_options_2d(PG_FUNCTION_ARGS);
 Datum gserialized_gist_union_2d(PG_FUNCTION_ARGS);
 Datum gserialized_gist_same_2d(PG_FUNCTION_ARGS);
 Datum gserialized_gist_distance_2d(PG_FUNCTION_ARGS);
@@ -406,7 +422,7 @@ static inline double pt_distance(double ax, double ay, double bx, double by)
 /**
 * Calculate the box->box distance.
 */
-static double box2df_distance(const BOX2DF *a, const BOX2DF *b)
+double box2df_distance(const BOX2DF *a, const BOX2DF *b)
 {
 	/* Check for overlap */
 	if ( box2df_overlaps(a, b) )
@@ -1751,6 +1767,278 @@ common_entry_cmp(const void *i1, const void *i2)
 		return 0;
 }
 
+/*
+ * Entry of an R*-tree split, with its box copied out of the entry vector.
+ */
+typedef struct
+{
+	BOX2DF box;
+	OffsetNumber off;
+} RStarEntry;
+
+/*
+ * Sort keys of an R*-tree split: by lower bound then upper bound, or
+ * upper bound then lower bound, along X or Y.
+ */
+enum rstar_sort
+{
+	RSTAR_X_LOWER = 0,
+	RSTAR_X_UPPER,
+	RSTAR_Y_LOWER,
+	RSTAR_Y_UPPER
+};
+
+static inline int
+float_cmp(float a, float b)
+{
+	return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+static int
+rstar_entry_cmp(const void *a, const void *b, void *arg)
+{
+	const BOX2DF *b1 = &((const RStarEntry *) a)->box;
+	const BOX2DF *b2 = &((const RStarEntry *) b)->box;
+	int cmp;
+
+	switch (*(int *) arg)
+	{
+		case RSTAR_X_LOWER:
+			cmp = float_cmp(b1->xmin, b2->xmin);
+			return cmp ? cmp : float_cmp(b1->xmax, b2->xmax);
+		case RSTAR_X_UPPER:
+			cmp = float_cmp(b1->xmax, b2->xmax);
+			return cmp ? cmp : float_cmp(b1->xmin, b2->xmin);
+		case RSTAR_Y_LOWER:
+			cmp = float_cmp(b1->ymin, b2->ymin);
+			return cmp ? cmp : float_cmp(b1->ymax, b2->ymax);
+		default:
+			cmp = float_cmp(b1->ymax, b2->ymax);
+			return cmp ? cmp : float_cmp(b1->ymin, b2->ymin);
+	}
+}
+
+static inline double
+box2df_margin(const BOX2DF *b)
+{
+	return ((double) b->xmax - b->xmin) + ((double) b->ymax - b->ymin);
+}
+
+static inline double
+box2df_area(const BOX2DF *b)
+{
+	return ((double) b->xmax - b->xmin) * ((double) b->ymax - b->ymin);
+}
+
+static inline double
+box2df_overlap_area(const BOX2DF *a, const BOX2DF *b)
+{
+	double dx = (double) Min(a->xmax, b->xmax) - Max(a->xmin, b->xmin);
+	double dy = (double) Min(a->ymax, b->ymax) - Max(a->ymin, b->ymin);
+	return (dx > 0 && dy > 0) ? dx * dy : 0;
+}
+
+/*
+ * Sort the entries, and fill prefix[k] with the bounding box of the
+ * first k + 1 entries and suffix[k] with that of the entries from k on.
+ */
+static void
+rstar_sort_entries(RStarEntry *entries, int n, int sort, BOX2DF *prefix, BOX2DF *suffix)
+{
+	int k;
+
+	qsort_arg(entries, n, sizeof(RStarEntry), rstar_entry_cmp, &sort);
+
+	prefix[0] = entries[0].box;
+	for (k = 1; k < n; k++)
+	{
+		prefix[k] = prefix[k - 1];
+		adjustBox(&prefix[k], &entries[k].box);
+	}
+
+	suffix[n - 1] = entries[n - 1].box;
+	for (k = n - 2; k >= 0; k--)
+	{
+		suffix[k] = suffix[k + 1];
+		adjustBox(&suffix[k], &entries[k].box);
+	}
+}
+
+/*
+ * --------------------------------------------------------------------------
+ * R*-tree split algorithm (Beckmann et al., "The R*-tree: an efficient and
+ * robust access method for points and rectangles", SIGMOD 1990).
+ *
+ * The entries are sorted along each axis, by lower and by upper bound, and
+ * every distribution of the sorted entries into a first and a second group
+ * holding at least RSTAR_MIN_FILL of them is considered. The split axis is
+ * the one whose distributions have the smallest sum of margins (perimeters),
+ * which favours square-ish pages. On that axis, the distribution with the
+ * least overlap between the two groups is chosen, breaking ties by total
+ * area and then total margin.
+ *
+ * Compared to the double sorting split, this trades a somewhat more costly
+ * split for pages that overlap less on skewed data, such as dense clusters
+ * of points surrounded by empty space.
+ *
+ * Empty entries do not take part, and are added to the smaller group.
+ * --------------------------------------------------------------------------
+ */
+static GIST_SPLITVEC *
+gserialized_gist_picksplit_rstar_2d(GistEntryVector *entryvec, GIST_SPLITVEC *v)
+{
+	OffsetNumber i, maxoff = entryvec->n - 1;
+	int nentries = maxoff - FirstOffsetNumber + 1;
+	RStarEntry *entries = palloc(nentries * sizeof(RStarEntry));
+	OffsetNumber *empties = palloc(nentries * sizeof(OffsetNumber));
+	BOX2DF *prefix, *suffix, *leftBox, *rightBox;
+	int n = 0, nempties = 0, m, k, dim, best_dim = 0;
+	double best_margin = DBL_MAX;
+	double best_overlap = DBL_MAX, best_area = DBL_MAX, best_split_margin = DBL_MAX;
+	int sort, best_sort = RSTAR_X_LOWER;
+	int best_k = 0;
+
+	for (i = FirstOffsetNumber; i <= maxoff; i = OffsetNumberNext(i))
+	{
+		BOX2DF *box = (BOX2DF *) DatumGetPointer(entryvec->vector[i].key);
+		if (box2df_is_empty(box))
+		{
+			empties[nempties++] = i;
+		}
+		else
+		{
+			entries[n].box = *box;
+			entries[n].off = i;
+			n++;
+		}
+	}
+
+	/* Nothing to choose from, split in halves */
+	if (n < 2)
+	{
+		pfree(entries);
+		pfree(empties);
+		fallbackSplit(entryvec, v);
+		return v;
+	}
+
+	m = Max(1, (int) (RSTAR_MIN_FILL * n));
+	/* Recursive picksplit called, this is going to be the last split, keep split into 2 parts */
+	if (n > INDEX_TUPLES_PER_PAGE && n <= 2 * INDEX_TUPLES_PER_PAGE)
+		m = Max(m, n - INDEX_TUPLES_PER_PAGE);
+	m = Min(m, n / 2);
+
+	prefix = palloc(n * sizeof(BOX2DF));
+	suffix = palloc(n * sizeof(BOX2DF));
+
+	/* Choose the split axis, by smallest sum of margins */
+	for (dim = 0; dim < 2; dim++)
+	{
+		double margin = 0;
+		for (sort = dim * 2; sort <= dim * 2 + 1; sort++)
+		{
+			rstar_sort_entries(entries, n, sort, prefix, suffix);
+			for (k = m; k <= n - m; k++)
+				margin += box2df_margin(&prefix[k - 1]) + box2df_margin(&suffix[k]);
+		}
+		if (margin < best_margin)
+		{
+			best_margin = margin;
+			best_dim = dim;
+		}
+	}
+
+	/* Choose the distribution along that axis, by smallest overlap */
+	for (sort = best_dim * 2; sort <= best_dim * 2 + 1; sort++)
+	{
+		rstar_sort_entries(entries, n, sort, prefix, suffix);
+		for (k = m; k <= n - m; k++)
+		{
+			double overlap = box2df_overlap_area(&prefix[k - 1], &suffix[k]);
+			double area = box2df_area(&prefix[k - 1]) + box2df_area(&suffix[k]);
+			double margin = box2df_margin(&prefix[k - 1]) + box2df_margin(&suffix[k]);
+
+			if (overlap < best_overlap ||
+			    (overlap == best_overlap && (area < best_area ||
+			    (area == best_area && margin < best_split_margin))))
+			{
+				best_overlap = overlap;
+				best_area = area;
+				best_split_margin = margin;
+				best_sort = sort;
+				best_k = k;
+			}
+		}
+	}
+
+	POSTGIS_DEBUGF(4, "R* split: axis %d, sort %d, %d/%d entries, %d empty",
+		best_dim, best_sort, best_k, n - best_k, nempties);
+
+	/* Lay out the chosen distribution */
+	rstar_sort_entries(entries, n, best_sort, prefix, suffix);
+
+	v->spl_left = (OffsetNumber *) palloc(nentries * sizeof(OffsetNumber));
+	v->spl_right = (OffsetNumber *) palloc(nentries * sizeof(OffsetNumber));
+	v->spl_nleft = v->spl_nright = 0;
+	leftBox = palloc(sizeof(BOX2DF));
+	rightBox = palloc(sizeof(BOX2DF));
+	*leftBox = prefix[best_k - 1];
+	*rightBox = suffix[best_k];
+
+	for (k = 0; k < n; k++)
+	{
+		if (k < best_k)
+			v->spl_left[v->spl_nleft++] = entries[k].off;
+		else
+			v->spl_right[v->spl_nright++] = entries[k].off;
+	}
+
+	for (k = 0; k < nempties; k++)
+	{
+		if (v->spl_nleft < v->spl_nright)
+			v->spl_left[v->spl_nleft++] = empties[k];
+		else
+			v->spl_right[v->spl_nright++] = empties[k];
+	}
+
+	v->spl_ldatum = PointerGetDatum(leftBox);
+	v->spl_rdatum = PointerGetDatum(rightBox);
+
+	pfree(prefix);
+	pfree(suffix);
+	pfree(entries);
+	pfree(empties);
+	return v;
+}
+
+/*
+** GiST support function. Declare the options of the 2D opclass, of which
+** "split" selects the node split strategy:
+**   CREATE INDEX ON t USING GIST (geom gist_geometry_ops_2d (split = 'rstar'));
+*/
+static relopt_enum_elt_def gist_split_strategies[] =
+{
+	{"double_sorting", GIST_SPLIT_DOUBLE_SORTING},
+	{"rstar", GIST_SPLIT_RSTAR},
+	{(const char *) NULL}
+};
+
+PG_FUNCTION_INFO_V1(gserialized_gist_options_2d);
+Datum gserialized_gist_options_2d(PG_FUNCTION_ARGS)
+{
+	local_relopts *relopts = (local_relopts *) PG_GETARG_POINTER(0);
+
+	init_local_reloptions(relopts, sizeof(GistBox2DFOptions));
+	add_local_enum_reloption(relopts, "split",
+				 "node split strategy",
+				 gist_split_strategies,
+				 GIST_SPLIT_DOUBLE_SORTING,
+				 "Valid values are \"double_sorting\" and \"rstar\".",
+				 offsetof(GistBox2DFOptions, split));
+
+	PG_RETURN_VOID();
+}
+
 /*
  * --------------------------------------------------------------------------
  * Double sorting split algorithm. This is used for both boxes and points.
@@ -1795,6 +2083,10 @@ Datum gserialized_gist_picksplit_2d(PG_FUNCTION_ARGS)
 
 	POSTGIS_DEBUG(3, "[GIST] 'picksplit' entered");
 
+	if (PG_HAS_OPCLASS_OPTIONS() &&
+	    ((GistBox2DFOptions *) PG_GET_OPCLASS_OPTIONS())->split == GIST_SPLIT_RSTAR)
+		PG_RETURN_POINTER(gserialized_gist_picksplit_rstar_2d(entryvec, v));
+
 	memset(&context, 0, sizeof(ConsiderSplitContext));
 
 	maxoff = entryvec->n - 1;
@@ -40,6 +40,7 @@
 #include "access/gist.h" /* For GiST */
 #include "access/itup.h"
 #include "access/skey.h"
+#include "utils/sortsupport.h" /* For index building sort support */
 
 #include "../postgis_config.h"
 
@@ -83,6 +84,7 @@ Datum gserialized_gist_union(PG_FUNCTION_ARGS);
 Datum gserialized_gist_same(PG_FUNCTION_ARGS);
 Datum gserialized_gist_distance(PG_FUNCTION_ARGS);
 Datum gserialized_gist_geog_distance(PG_FUNCTION_ARGS);
+Datum gserialized_gist_sortsupport(PG_FUNCTION_ARGS);
 
 /*
 ** ND Operator prototypes
@@ -1790,6 +1792,130 @@ Datum gserialized_gist_picksplit(PG_FUNCTION_ARGS)
 	PG_RETURN_POINTER(v);
 }
 
+/*
+** Map a float onto an unsigned integer with the same ordering,
+** so that negative coordinates sort below positive ones.
+*/
+static inline uint32_t
+gidx_sortable_float_bits(float f)
+{
+	union floatuint {
+		uint32_t u;
+		float f;
+	} v;
+
+	v.f = f;
+	if (v.u & 0x80000000)
+		return ~v.u;
+	return v.u | 0x80000000;
+}
+
+/*
+** Space filling curve key of the GIDX center. Two dimensional keys
+** get a Hilbert code, as in the 2D opclass. Higher dimensional keys
+** (3D/4D geometry, geocentric geography) get a Morton code that
+** interleaves the leading 64/ndims bits of every dimension.
+** Unknown keys hash to zero, which the abbreviated comparator
+** hands to the full comparator.
+*/
+static inline uint64_t
+gidx_get_sortable_hash(const GIDX *g)
+{
+	uint32_t u[GIDX_MAX_DIM];
+	uint32_t ndims, bits, b, d;
+	uint64_t hash = 0;
+
+	if (gidx_is_unknown(g))
+		return 0;
+
+	ndims = Min(GIDX_NDIMS(g), GIDX_MAX_DIM);
+	for (d = 0; d < ndims; d++)
+		u[d] = gidx_sortable_float_bits((GIDX_GET_MIN(g, d) + GIDX_GET_MAX(g, d)) / 2);
+
+	if (ndims == 2)
+		return uint32_hilbert(u[1], u[0]);
+
+	bits = Min(64 / ndims, 32);
+	for (b = 0; b < bits; b++)
+		for (d = 0; d < ndims; d++)
+			hash = (hash << 1) | ((u[d] >> (31 - b)) & 1);
+
+	return hash;
+}
+
+static int
+gserialized_gist_cmp_abbrev(Datum x, Datum y, SortSupport ssup)
+{
+	/* Empty is a special case */
+	if (x == 0 || y == 0 || x == y)
+		return 0; /* 0 means "ask bigger comparator" and not equality*/
+	else if (x > y)
+		return 1;
+	else
+		return -1;
+}
+
+static bool
+gserialized_gist_abbrev_abort(int memtupcount, SortSupport ssup)
+{
+	return LW_FALSE;
+}
+
+static Datum
+gserialized_gist_abbrev_convert(Datum original, SortSupport ssup)
+{
+	return gidx_get_sortable_hash((GIDX *)DatumGetPointer(original));
+}
+
+static int
+gserialized_gist_cmp_full(Datum a, Datum b, SortSupport ssup)
+{
+	GIDX *g1 = (GIDX *)DatumGetPointer(a);
+	GIDX *g2 = (GIDX *)DatumGetPointer(b);
+	size_t size1 = VARSIZE(g1);
+	size_t size2 = VARSIZE(g2);
+	uint64_t hash1, hash2;
+	int cmp;
+
+	cmp = memcmp(g1, g2, Min(size1, size2));
+	if (cmp == 0 && size1 == size2)
+		return 0;
+
+	hash1 = gidx_get_sortable_hash(g1);
+	hash2 = gidx_get_sortable_hash(g2);
+	if (hash1 > hash2)
+		return 1;
+	else if (hash1 < hash2)
+		return -1;
+
+	if (cmp != 0)
+		return cmp > 0 ? 1 : -1;
+	return size1 > size2 ? 1 : -1;
+}
+
+/*
+** GiST support function. Sort keys along a space filling curve,
+** so that ND and geography indexes can be built by sorting.
+*/
+PG_FUNCTION_INFO_V1(gserialized_gist_sortsupport);
+Datum gserialized_gist_sortsupport(PG_FUNCTION_ARGS)
+{
+	SortSupport ssup = (SortSupport)PG_GETARG_POINTER(0);
+
+	ssup->comparator = gserialized_gist_cmp_full;
+	ssup->ssup_extra = NULL;
+	/* Enable sortsupport only on 64 bit Datum */
+	if (ssup->abbreviate && sizeof(Datum) == 8)
+	{
+		ssup->comparator = gserialized_gist_cmp_abbrev;
+		ssup->abbrev_converter = gserialized_gist_abbrev_convert;
+		ssup->abbrev_abort = gserialized_gist_abbrev_abort;
+		ssup->abbrev_full_comparator = gserialized_gist_cmp_full;
+	}
+
+	PG_RETURN_VOID();
+}
+
 /*
 ** The GIDX key must be defined as a PostgreSQL type, even though it is only
 ** ever used internally. These no-op stubs are used to bind the type.
@@ -0,0 +1,1282 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.net
+ *
+ * PostGIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * PostGIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PostGIS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **********************************************************************/
+
+/*
+ * Grid partitioned spatial join.
+ *
+ * Joins of two geometry inputs on ST_Intersects, ST_DWithin or &&
+ * without a usable index end up as nested loops that run the
+ * predicate on every pair of rows. When postgis.partition_join is on
+ * we offer the planner a custom join instead: both inputs are read
+ * into memory with their bounding boxes, the boxes are laid out on a
+ * grid over the common extent of the inputs, and each grid cell is
+ * swept along X to find the pairs of boxes that overlap. Only those
+ * candidate pairs are handed to the join clauses for the exact check.
+ *
+ * A pair of boxes overlapping in several cells is reported only by
+ * the cell holding the lower left corner of their overlap, so every
+ * pair comes out once. For ST_DWithin the boxes of the outer input
+ * are grown by the radius.
+ *
+ * The inputs are kept in memory as long as they fit in hash_mem. Past
+ * that, both are written to temporary files and split into bands of
+ * the common extent along Y, and the bands are gridded and swept one
+ * at a time. A box crossing several bands goes to each of them, and a
+ * pair is reported only by the band holding the lower edge of its
+ * overlap. In parallel plans each worker joins its share of the outer
+ * input to all of the inner input, like a hash join that does not
+ * share its hash table.
+ */
+
+#include "../postgis_config.h"
+
+/* PostgreSQL */
+#include "postgres.h"
+#include "fmgr.h"
+#include "miscadmin.h"
+#include "catalog/pg_type.h"
+#include "executor/executor.h"
+#include "executor/nodeHash.h"
+#include "nodes/extensible.h"
+#include "nodes/makefuncs.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/cost.h"
+#include "optimizer/pathnode.h"
+#include "optimizer/paths.h"
+#include "optimizer/restrictinfo.h"
+#include "storage/buffile.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+
+/* PostGIS */
+#include "liblwgeom.h"
+#include "lwgeom_pg.h"
+#include "gserialized_gist.h"
+#include "gserialized_partition_join.h"
+
+#include <float.h>
+#include <math.h>
+
+/* Join geometry inputs on a grid, GUC postgis.partition_join */
+bool partition_join = false;
+
+/* Target number of input rows per grid cell */
+#define PARTITION_JOIN_CELL_ITEMS 16
+
+/* Upper bound on the number of grid cells */
+#define PARTITION_JOIN_MAX_CELLS (1 << 20)
+
+/*
+ * Coarsen the grid while boxes spanning several cells push the
+ * number of cell entries beyond this many per input row.
+ */
+#define PARTITION_JOIN_MAX_COPIES 4
+
+/* Per row memory of the join beyond the tuple itself, for the planner */
+#define PARTITION_JOIN_ROW_OVERHEAD 64
+
+/* Cost of reading, boxing and gridding an input row, in cpu_operator_cost */
+#define PARTITION_JOIN_ROW_COST 8
+
+/* Upper bound on the number of bands of spilled inputs */
+#define PARTITION_JOIN_MAX_BANDS 1024
+
+/* An input row, with the box of its join key */
+typedef struct
+{
+	BOX2DF box;
+	MinimalTuple tuple;
+} PartitionJoinItem;
+
+/* One input of the join */
+typedef struct
+{
+	PartitionJoinItem *items;  /* Rows of the current band, all rows if not spilled */
+	int nitems;
+	int maxitems;
+	int *cell_start;       /* Items of cell c are cell_item[cell_start[c]] to cell_item[cell_start[c+1]-1] */
+	int *cell_item;
+	AttrNumber key;        /* Join key column of the input rows */
+	TupleTableSlot *slot;  /* For deforming the stored rows */
+	BOX2DF extent;         /* Extent of all the rows read */
+	double nrows;          /* Number of rows read with a usable key */
+	BufFile *file;         /* Rows read once spilling started */
+	BufFile **band_files;  /* Rows of each band */
+} PartitionJoinSide;
+
+/* Position of the sweep of a cell, see partition_join_next_pair */
+typedef struct
+{
+	int cell;              /* Cell being swept */
+	int *outer;            /* Outer and inner items of the cell by xmin */
+	int *inner;
+	int nouter, ninner;
+	int o, i;              /* Next unswept outer and inner item */
+	int k;                 /* Next item of the other input to pair the leading one with */
+	bool outer_leads;      /* Is the leading item an outer one? */
+	bool running;          /* Are we pairing the leading item? */
+} PartitionJoinSweep;
+
+typedef struct
+{
+	CustomScanState css;
+	PartitionJoinSide outer;
+	PartitionJoinSide inner;
+	double radius;         /* Search radius of ST_DWithin, zero otherwise */
+	MemoryContext context; /* Holds the temporary files while the join runs */
+	MemoryContext band_context; /* Holds the rows of the current band */
+	MemoryContext key_context;  /* Detoasted join keys, reset for every row */
+	Size hash_mem;         /* Memory for rows before spilling them */
+	bool loaded;           /* Inputs read and gridded? */
+	bool spilled;          /* Inputs written to temporary files? */
+	double spill_bytes;    /* Size of the temporary files */
+	BOX2DF join_extent;    /* Common extent of the inputs */
+	int nbands, band;      /* Number of bands and current band */
+	double band_height;
+	BOX2DF extent;         /* Extent covered by the grid of the current band */
+	int nx, ny;            /* Grid size */
+	double cell_width, cell_height;
+	int cell;              /* Next cell to sweep */
+	PartitionJoinSweep sweep; /* Sweep of the current cell */
+} PartitionJoinState;
+
+static set_join_pathlist_hook_type prev_set_join_pathlist_hook = NULL;
+
+static Plan *partition_join_plan(PlannerInfo *root, RelOptInfo *rel, CustomPath *best_path,
+                                 List *tlist, List *clauses, List *custom_plans);
+static Node *partition_join_create_state(CustomScan *cscan);
+static void partition_join_begin(CustomScanState *node, EState *estate, int eflags);
+static TupleTableSlot *partition_join_exec(CustomScanState *node);
+static void partition_join_end(CustomScanState *node);
+static void partition_join_rescan(CustomScanState *node);
+
+static const CustomPathMethods partition_join_path_methods = {
+	.CustomName = "SpatialPartitionJoin",
+	.PlanCustomPath = partition_join_plan,
+};
+
+static const CustomScanMethods partition_join_scan_methods = {
+	.CustomName = "SpatialPartitionJoin",
+	.CreateCustomScanState = partition_join_create_state,
+};
+
+static const CustomExecMethods partition_join_exec_methods = {
+	.CustomName = "SpatialPartitionJoin",
+	.BeginCustomScan = partition_join_begin,
+	.ExecCustomScan = partition_join_exec,
+	.EndCustomScan = partition_join_end,
+	.ReScanCustomScan = partition_join_rescan,
+};
+
+/*
+ * Is the clause one we can drive the join with? It has to compare a
+ * geometry column of each input with ST_Intersects, && or ST_DWithin
+ * with a constant radius.
+ */
+static bool
+partition_join_clause(RestrictInfo *rinfo, RelOptInfo *outerrel, RelOptInfo *innerrel,
+                      Var **outer_var, Var **inner_var, double *radius)
+{
+	Expr *clause = rinfo->clause;
+	Oid geometryOid = postgis_oid(GEOMETRYOID);
+	Oid funcid;
+	List *args;
+	char *fn_name;
+	Var *a, *b;
+
+	if (IsA(clause, FuncExpr))
+	{
+		funcid = ((FuncExpr *) clause)->funcid;
+		args = ((FuncExpr *) clause)->args;
+	}
+	else if (IsA(clause, OpExpr))
+	{
+		funcid = get_opcode(((OpExpr *) clause)->opno);
+		args = ((OpExpr *) clause)->args;
+	}
+	else
+		return false;
+
+	fn_name = get_func_name(funcid);
+	if (!fn_name)
+		return false;
+
+	*radius = 0.0;
+	if (list_length(args) == 3 && strcmp(fn_name, "st_dwithin") == 0)
+	{
+		Const *radiusconst = (Const *) lthird(args);
+
+		if (!IsA(radiusconst, Const) || radiusconst->constisnull ||
+		    radiusconst->consttype != FLOAT8OID)
+			return false;
+
+		*radius = DatumGetFloat8(radiusconst->constvalue);
+		if (!(*radius >= 0.0) || !isfinite(*radius))
+			return false;
+	}
+	else if (list_length(args) != 2 ||
+	         (strcmp(fn_name, "st_intersects") != 0 && strcmp(fn_name, "geometry_overlaps") != 0))
+	{
+		return false;
+	}
+
+	a = (Var *) linitial(args);
+	b = (Var *) lsecond(args);
+	if (!IsA(a, Var) || !IsA(b, Var) ||
+	    a->varlevelsup != 0 || b->varlevelsup != 0 ||
+	    a->vartype != geometryOid || b->vartype != geometryOid)
+		return false;
+
+	if (bms_is_member(a->varno, outerrel->relids) && bms_is_member(b->varno, innerrel->relids))
+	{
+		*outer_var = a;
+		*inner_var = b;
+	}
+	else if (bms_is_member(b->varno, outerrel->relids) && bms_is_member(a->varno, innerrel->relids))
+	{
+		*outer_var = b;
+		*inner_var = a;
+	}
+	else
+		return false;
+
+	return true;
+}
+
+/*
+ * The join copies the input rows into its scan tuple as they come
+ * out of the inputs, which works when the inputs emit plain columns.
+ */
+static bool
+partition_join_target_is_plain(RelOptInfo *rel)
+{
+	ListCell *lc;
+
+	foreach (lc, rel->reltarget->exprs)
+	{
+		if (!IsA(lfirst(lc), Var))
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Cost of the temporary files if we do not expect both inputs to fit
+ * in memory. The rows are written and read back once before being
+ * split into bands, and once more as bands.
+ */
+static Cost
+partition_join_spill_cost(Path *outer_path, Path *inner_path)
+{
+	double outer_bytes = outer_path->rows * (outer_path->pathtarget->width + PARTITION_JOIN_ROW_OVERHEAD);
+	double inner_bytes = inner_path->rows * (inner_path->pathtarget->width + PARTITION_JOIN_ROW_OVERHEAD);
+	double pages;
+
+	if (outer_bytes + inner_bytes <= (double) get_hash_memory_limit())
+		return 0.0;
+
+	pages = ceil((outer_bytes + inner_bytes) / BLCKSZ);
+	return 4 * pages * seq_page_cost;
+}
+
+static CustomPath *
+partition_join_path(PlannerInfo *root, RelOptInfo *joinrel, Path *outer_path, Path *inner_path,
+                    List *restrictlist, Var *outer_var, Var *inner_var, double radius, double rows)
+{
+	CustomPath *cpath = makeNode(CustomPath);
+	QualCost qual_cost;
+
+	cpath->path.pathtype = T_CustomScan;
+	cpath->path.parent = joinrel;
+	cpath->path.pathtarget = joinrel->reltarget;
+	cpath->path.param_info = NULL;
+	cpath->path.parallel_aware = false;
+	cpath->path.parallel_safe = joinrel->consider_parallel &&
+	                            outer_path->parallel_safe && inner_path->parallel_safe;
+	cpath->path.parallel_workers = outer_path->parallel_workers;
+	cpath->path.pathkeys = NIL;
+	cpath->path.rows = rows;
+#if POSTGIS_PGSQL_VERSION >= 180
+	cpath->path.disabled_nodes = outer_path->disabled_nodes + inner_path->disabled_nodes;
+#endif
+
+	/*
+	 * Both inputs are read and gridded before the first row comes out.
+	 * After that the join clauses run on the pairs with overlapping
+	 * boxes, which is what the join size is estimated from anyway.
+	 */
+	cost_qual_eval(&qual_cost, extract_actual_clauses(restrictlist, false), root);
+	cpath->path.startup_cost = outer_path->total_cost + inner_path->total_cost +
+		PARTITION_JOIN_ROW_COST * cpu_operator_cost * (outer_path->rows + inner_path->rows) +
+		partition_join_spill_cost(outer_path, inner_path) + qual_cost.startup;
+	cpath->path.total_cost = cpath->path.startup_cost +
+		rows * (qual_cost.per_tuple + cpu_tuple_cost);
+
+	cpath->flags = 0;
+	cpath->custom_paths = list_make2(outer_path, inner_path);
+	cpath->custom_private = list_make4(restrictlist, outer_var, inner_var,
+	                                   makeFloat(psprintf("%.17g", radius)));
+	cpath->methods = &partition_join_path_methods;
+	return cpath;
+}
+
+static void
+partition_join_pathlist(PlannerInfo *root, RelOptInfo *joinrel, RelOptInfo *outerrel,
+                        RelOptInfo *innerrel, JoinType jointype, JoinPathExtraData *extra)
+{
+	Var *outer_var = NULL;
+	Var *inner_var = NULL;
+	double radius = 0.0;
+	bool found = false;
+	Path *outer_path, *inner_path;
+	ListCell *lc;
+
+	if (prev_set_join_pathlist_hook)
+		prev_set_join_pathlist_hook(root, joinrel, outerrel, innerrel, jointype, extra);
+
+	if (!partition_join || jointype != JOIN_INNER)
+		return;
+
+	if (!bms_is_empty(joinrel->lateral_relids))
+		return;
+
+	foreach (lc, extra->restrictlist)
+	{
+		RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
+
+		/* We have no place for a gating Result */
+		if (rinfo->pseudoconstant)
+			return;
+
+		if (!found)
+			found = partition_join_clause(rinfo, outerrel, innerrel, &outer_var, &inner_var, &radius);
+	}
+	if (!found)
+		return;
+
+	if (!partition_join_target_is_plain(outerrel) || !partition_join_target_is_plain(innerrel))
+		return;
+
+	outer_path = outerrel->cheapest_total_path;
+	inner_path = innerrel->cheapest_total_path;
+	if (!outer_path || !inner_path ||
+	    !bms_is_empty(PATH_REQ_OUTER(outer_path)) || !bms_is_empty(PATH_REQ_OUTER(inner_path)))
+		return;
+
+	add_path(joinrel, (Path *) partition_join_path(root, joinrel, outer_path, inner_path,
+	                                               extra->restrictlist, outer_var, inner_var,
+	                                               radius, joinrel->rows));
+
+	/* Each worker joins its part of the outer input to all of the inner one */
+	if (joinrel->consider_parallel && outerrel->partial_pathlist && inner_path->parallel_safe)
+	{
+		Path *outer_partial = (Path *) linitial(outerrel->partial_pathlist);
+		double rows = joinrel->rows * outer_partial->rows / Max(outerrel->rows, 1.0);
+
+		if (bms_is_empty(PATH_REQ_OUTER(outer_partial)))
+		{
+			add_partial_path(joinrel, (Path *) partition_join_path(root, joinrel, outer_partial, inner_path,
+			                                                       extra->restrictlist, outer_var, inner_var,
+			                                                       radius, rows));
+		}
+	}
+}
+
+/* Is the target list entry the column of the join key? */
+static bool
+partition_join_same_column(Expr *expr, Var *var)
+{
+	return IsA(expr, Var) &&
+	       ((Var *) expr)->varno == var->varno &&
+	       ((Var *) expr)->varattno == var->varattno &&
+	       ((Var *) expr)->varlevelsup == 0;
+}
+
+/*
+ * The scan tuple of the join is the output columns of the outer
+ * input followed by those of the inner one. The join clauses are
+ * checked on it as the scan qual.
+ */
+static Plan *
+partition_join_plan(PlannerInfo *root, RelOptInfo *rel, CustomPath *best_path,
+                    List *tlist, List *clauses, List *custom_plans)
+{
+	CustomScan *cscan = makeNode(CustomScan);
+	List *restrictlist = (List *) linitial(best_path->custom_private);
+	Var *outer_var = (Var *) lsecond(best_path->custom_private);
+	Var *inner_var = (Var *) lthird(best_path->custom_private);
+	Plan *outer_plan = (Plan *) linitial(custom_plans);
+	Plan *inner_plan = (Plan *) lsecond(custom_plans);
+	List *scan_tlist = NIL;
+	AttrNumber resno = 1;
+	AttrNumber outer_key = InvalidAttrNumber;
+	AttrNumber inner_key = InvalidAttrNumber;
+	ListCell *lc;
+
+	foreach (lc, outer_plan->targetlist)
+	{
+		TargetEntry *tle = lfirst_node(TargetEntry, lc);
+		if (outer_key == InvalidAttrNumber && partition_join_same_column(tle->expr, outer_var))
+			outer_key = tle->resno;
+		scan_tlist = lappend(scan_tlist, makeTargetEntry(copyObject(tle->expr), resno++, NULL, false));
+	}
+	foreach (lc, inner_plan->targetlist)
+	{
+		TargetEntry *tle = lfirst_node(TargetEntry, lc);
+		if (inner_key == InvalidAttrNumber && partition_join_same_column(tle->expr, inner_var))
+			inner_key = tle->resno;
+		scan_tlist = lappend(scan_tlist, makeTargetEntry(copyObject(tle->expr), resno++, NULL, false));
+	}
+
+	if (outer_key == InvalidAttrNumber || inner_key == InvalidAttrNumber)
+		elog(ERROR, "%s: join key not found in the input target lists", __func__);
+
+	cscan->scan.plan.targetlist = tlist;
+	cscan->scan.plan.qual = extract_actual_clauses(restrictlist, false);
+	cscan->scan.scanrelid = 0;
+	cscan->flags = best_path->flags;
+	cscan->custom_plans = custom_plans;
+	cscan->custom_scan_tlist = scan_tlist;
+	cscan->custom_private = list_make3(makeInteger(outer_key), makeInteger(inner_key),
+	                                   lfourth(best_path->custom_private));
+	cscan->methods = &partition_join_scan_methods;
+
+	return &cscan->scan.plan;
+}
+
+static Node *
+partition_join_create_state(CustomScan *cscan)
+{
+	PartitionJoinState *state = palloc0(sizeof(PartitionJoinState));
+
+	NodeSetTag(state, T_CustomScanState);
+	state->css.flags = cscan->flags;
+	state->css.methods = &partition_join_exec_methods;
+	return (Node *) state;
+}
+
+static void
+partition_join_begin(CustomScanState *node, EState *estate, int eflags)
+{
+	PartitionJoinState *state = (PartitionJoinState *) node;
+	CustomScan *cscan = (CustomScan *) node->ss.ps.plan;
+	PlanState *outer_ps, *inner_ps;
+
+	/* The inputs are read once, front to back */
+	eflags &= ~(EXEC_FLAG_REWIND | EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK);
+	outer_ps = ExecInitNode((Plan *) linitial(cscan->custom_plans), estate, eflags);
+	inner_ps = ExecInitNode((Plan *) lsecond(cscan->custom_plans), estate, eflags);
+	node->custom_ps = list_make2(outer_ps, inner_ps);
+
+	state->outer.key = intVal(linitial(cscan->custom_private));
+	state->inner.key = intVal(lsecond(cscan->custom_private));
+	state->radius = floatVal(lthird(cscan->custom_private));
+
+	state->outer.slot = MakeSingleTupleTableSlot(ExecGetResultType(outer_ps), &TTSOpsMinimalTuple);
+	state->inner.slot = MakeSingleTupleTableSlot(ExecGetResultType(inner_ps), &TTSOpsMinimalTuple);
+
+	state->context = AllocSetContextCreate(estate->es_query_cxt,
+	                                       "PostGIS partition join",
+	                                       ALLOCSET_DEFAULT_SIZES);
+	state->band_context = AllocSetContextCreate(estate->es_query_cxt,
+	                                            "PostGIS partition join band",
+	                                            ALLOCSET_DEFAULT_SIZES);
+	state->key_context = AllocSetContextCreate(estate->es_query_cxt,
+	                                           "PostGIS partition join key",
+	                                           ALLOCSET_SMALL_SIZES);
+	state->hash_mem = get_hash_memory_limit();
+	state->loaded = false;
+	state->spilled = false;
+}
+
+/* Append a row and the box of its key to a temporary file */
+static void
+partition_join_write(BufFile *file, BOX2DF *box, MinimalTuple tuple)
+{
+	BufFileWrite(file, (void *) box, sizeof(BOX2DF));
+	BufFileWrite(file, (void *) tuple, tuple->t_len);
+}
+
+static void
+partition_join_read_exact(BufFile *file, void *ptr, size_t size)
+{
+	size_t nread = BufFileRead(file, ptr, size);
+
+	if (nread != size)
+		ereport(ERROR,
+		        (errcode_for_file_access(),
+		         errmsg("could not read from partition join temporary file: read only %zu of %zu bytes",
+		                nread, size)));
+}
+
+/*
+ * Read back a row written by partition_join_write, into the current
+ * memory context. Returns false at the end of the file.
+ */
+static bool
+partition_join_read(BufFile *file, BOX2DF *box, MinimalTuple *tuple)
+{
+	uint32 t_len;
+	size_t nread;
+
+	nread = BufFileRead(file, (void *) box, sizeof(BOX2DF));
+	if (nread == 0)
+		return false;
+	if (nread != sizeof(BOX2DF))
+		ereport(ERROR,
+		        (errcode_for_file_access(),
+		         errmsg("could not read from partition join temporary file: read only %zu of %zu bytes",
+		                nread, sizeof(BOX2DF))));
+
+	partition_join_read_exact(file, (void *) &t_len, sizeof(uint32));
+	*tuple = (MinimalTuple) palloc(t_len);
+	(*tuple)->t_len = t_len;
+	partition_join_read_exact(file, (void *) ((char *) *tuple + sizeof(uint32)), t_len - sizeof(uint32));
+	return true;
+}
+
+static void
+partition_join_rewind(BufFile *file)
+{
+	if (BufFileSeek(file, 0, 0L, SEEK_SET))
+		ereport(ERROR,
+		        (errcode_for_file_access(),
+		         errmsg("could not rewind partition join temporary file")));
+}
+
+/* Keep a row in memory, the tuple is expected in band_context */
+static void
+partition_join_add_item(PartitionJoinState *state, PartitionJoinSide *side, const BOX2DF *box, MinimalTuple tuple)
+{
+	MemoryContext old_context = MemoryContextSwitchTo(state->band_context);
+	PartitionJoinItem *item;
+
+	if (side->nitems == side->maxitems)
+	{
+		side->maxitems = side->maxitems ? 2 * side->maxitems : 1024;
+		if (side->items)
+			side->items = repalloc_huge(side->items, sizeof(PartitionJoinItem) * side->maxitems);
+		else
+			side->items = palloc_extended(sizeof(PartitionJoinItem) * side->maxitems, MCXT_ALLOC_HUGE);
+	}
+	item = &(side->items[side->nitems++]);
+	item->box = *box;
+	item->tuple = tuple;
+	MemoryContextSwitchTo(old_context);
+}
+
+/* Drop the rows held in memory along with their grid */
+static void
+partition_join_reset_band(PartitionJoinState *state)
+{
+	MemoryContextReset(state->band_context);
+	state->outer.items = state->inner.items = NULL;
+	state->outer.nitems = state->outer.maxitems = 0;
+	state->inner.nitems = state->inner.maxitems = 0;
+	state->outer.cell_start = state->outer.cell_item = NULL;
+	state->inner.cell_start = state->inner.cell_item = NULL;
+	state->nx = state->ny = 0;
+	state->cell = 0;
+	memset(&(state->sweep), 0, sizeof(PartitionJoinSweep));
+}
+
+static void
+partition_join_close_files(PartitionJoinState *state, PartitionJoinSide *side)
+{
+	int b;
+
+	if (side->file)
+		BufFileClose(side->file);
+	side->file = NULL;
+
+	if (side->band_files)
+	{
+		for (b = 0; b < state->nbands; b++)
+			BufFileClose(side->band_files[b]);
+		pfree(side->band_files);
+	}
+	side->band_files = NULL;
+}
+
+/*
+ * The rows held in memory have outgrown hash_mem: move them to
+ * temporary files, where the rows still to come will go as well.
+ */
+static void
+partition_join_spill(PartitionJoinState *state)
+{
+	PartitionJoinSide *sides[2] = {&(state->outer), &(state->inner)};
+	MemoryContext old_context = MemoryContextSwitchTo(state->context);
+	int s, i;
+
+	for (s = 0; s < 2; s++)
+	{
+		PartitionJoinSide *side = sides[s];
+
+		side->file = BufFileCreateTemp(false);
+		for (i = 0; i < side->nitems; i++)
+		{
+			partition_join_write(side->file, &(side->items[i].box), side->items[i].tuple);
+			state->spill_bytes += sizeof(BOX2DF) + side->items[i].tuple->t_len;
+		}
+	}
+	MemoryContextSwitchTo(old_context);
+
+	partition_join_reset_band(state);
+	state->spilled = true;
+}
+
+/*
+ * Read all the rows of an input with a usable key box. Rows with a
+ * NULL or empty key cannot satisfy the join clauses.
+ */
+static void
+partition_join_load(PartitionJoinState *state, PlanState *input, PartitionJoinSide *side, double radius)
+{
+	side->extent.xmin = side->extent.ymin = FLT_MAX;
+	side->extent.xmax = side->extent.ymax = -FLT_MAX;
+	side->nrows = 0;
+
+	for (;;)
+	{
+		TupleTableSlot *slot = ExecProcNode(input);
+		MemoryContext old_context;
+		MinimalTuple tuple;
+		BOX2DF box;
+		Datum key;
+		bool isnull, usable;
+
+		if (TupIsNull(slot))
+			break;
+
+		/* Reading the box may detoast the key, do not keep that around */
+		old_context = MemoryContextSwitchTo(state->key_context);
+		key = slot_getattr(slot, side->key, &isnull);
+		usable = !isnull && gserialized_datum_get_box2df_p(key, &box) == LW_SUCCESS &&
+		         !isnan(box.xmin) && !isnan(box.xmax) && !isnan(box.ymin) && !isnan(box.ymax);
+		MemoryContextSwitchTo(old_context);
+
+		if (usable)
+		{
+			if (radius > 0.0)
+			{
+				box.xmin = next_float_down((double)box.xmin - radius);
+				box.ymin = next_float_down((double)box.ymin - radius);
+				box.xmax = next_float_up((double)box.xmax + radius);
+				box.ymax = next_float_up((double)box.ymax + radius);
+			}
+
+			side->extent.xmin = Min(side->extent.xmin, box.xmin);
+			side->extent.ymin = Min(side->extent.ymin, box.ymin);
+			side->extent.xmax = Max(side->extent.xmax, box.xmax);
+			side->extent.ymax = Max(side->extent.ymax, box.ymax);
+			side->nrows++;
+
+			if (state->spilled)
+			{
+				bool should_free;
+
+				old_context = MemoryContextSwitchTo(state->key_context);
+				tuple = ExecFetchSlotMinimalTuple(slot, &should_free);
+				partition_join_write(side->file, &box, tuple);
+				state->spill_bytes += sizeof(BOX2DF) + tuple->t_len;
+				MemoryContextSwitchTo(old_context);
+			}
+			else
+			{
+				old_context = MemoryContextSwitchTo(state->band_context);
+				tuple = ExecCopySlotMinimalTuple(slot);
+				MemoryContextSwitchTo(old_context);
+
+				partition_join_add_item(state, side, &box, tuple);
+				if (MemoryContextMemAllocated(state->band_context, false) > state->hash_mem)
+					partition_join_spill(state);
+			}
+		}
+
+		MemoryContextReset(state->key_context);
+	}
+}
+
+static void
+partition_join_extent(const PartitionJoinSide *side, BOX2DF *extent)
+{
+	int i;
+
+	extent->xmin = extent->ymin = FLT_MAX;
+	extent->xmax = extent->ymax = -FLT_MAX;
+	for (i = 0; i < side->nitems; i++)
+	{
+		const BOX2DF *box = &(side->items[i].box);
+		extent->xmin = Min(extent->xmin, box->xmin);
+		extent->ymin = Min(extent->ymin, box->ymin);
+		extent->xmax = Max(extent->xmax, box->xmax);
+		extent->ymax = Max(extent->ymax, box->ymax);
+	}
+}
+
+/* Band of Y, clamped to the bands */
+static inline int
+partition_join_band(const PartitionJoinState *state, double y)
+{
+	double b;
+
+	if (state->nbands <= 1)
+		return 0;
+	b = floor((y - state->join_extent.ymin) / state->band_height);
+	if (!(b > 0.0))
+		return 0;
+	if (b >= state->nbands - 1)
+		return state->nbands - 1;
+	return (int)b;
+}
+
+/*
+ * Split the spilled rows of an input into bands, a row going to each
+ * band its box crosses
+ */
+static void
+partition_join_split(PartitionJoinState *state, PartitionJoinSide *side)
+{
+	MemoryContext old_context = MemoryContextSwitchTo(state->context);
+	MinimalTuple tuple;
+	BOX2DF box;
+	int b;
+
+	side->band_files = palloc(sizeof(BufFile *) * state->nbands);
+	for (b = 0; b < state->nbands; b++)
+		side->band_files[b] = BufFileCreateTemp(false);
+
+	partition_join_rewind(side->file);
+	MemoryContextSwitchTo(state->key_context);
+	while (partition_join_read(side->file, &box, &tuple))
+	{
+		if (box2df_overlaps(&box, &(state->join_extent)))
+		{
+			int b1 = partition_join_band(state, box.ymax);
+
+			for (b = partition_join_band(state, box.ymin); b <= b1; b++)
+				partition_join_write(side->band_files[b], &box, tuple);
+		}
+		MemoryContextReset(state->key_context);
+	}
+	MemoryContextSwitchTo(old_context);
+
+	BufFileClose(side->file);
+	side->file = NULL;
+}
+
+/* Read the rows of the current band of an input into memory */
+static void
+partition_join_load_band(PartitionJoinState *state, PartitionJoinSide *side)
+{
+	BufFile *file = side->band_files[state->band];
+	MemoryContext old_context;
+	MinimalTuple tuple;
+	BOX2DF box;
+	bool found;
+
+	partition_join_rewind(file);
+	for (;;)
+	{
+		old_context = MemoryContextSwitchTo(state->band_context);
+		found = partition_join_read(file, &box, &tuple);
+		MemoryContextSwitchTo(old_context);
+		if (!found)
+			break;
+		partition_join_add_item(state, side, &box, tuple);
+	}
+}
+
+/* Grid column of X, clamped to the grid */
+static inline int
+partition_join_cell_x(const PartitionJoinState *state, double x)
+{
+	double c;
+
+	if (state->nx == 1)
+		return 0;
+	c = floor((x - state->extent.xmin) / state->cell_width);
+	if (!(c > 0.0))
+		return 0;
+	if (c >= state->nx - 1)
+		return state->nx - 1;
+	return (int)c;
+}
+
+/* Grid row of Y, clamped to the grid */
+static inline int
+partition_join_cell_y(const PartitionJoinState *state, double y)
+{
+	double c;
+
+	if (state->ny == 1)
+		return 0;
+	c = floor((y - state->extent.ymin) / state->cell_height);
+	if (!(c > 0.0))
+		return 0;
+	if (c >= state->ny - 1)
+		return state->ny - 1;
+	return (int)c;
+}
+
+/*
+ * Count the cell entries the boxes of an input take up on the grid,
+ * into cell_start[c+1] if cell_start is given.
+ */
+static double
+partition_join_count_cells(const PartitionJoinState *state, const PartitionJoinSide *side, int *cell_start)
+{
+	double entries = 0;
+	int i, x, y;
+
+	for (i = 0; i < side->nitems; i++)
+	{
+		const BOX2DF *box = &(side->items[i].box);
+		int x0, x1, y0, y1;
+
+		if (!box2df_overlaps(box, &(state->extent)))
+			continue;
+
+		x0 = partition_join_cell_x(state, box->xmin);
+		x1 = partition_join_cell_x(state, box->xmax);
+		y0 = partition_join_cell_y(state, box->ymin);
+		y1 = partition_join_cell_y(state, box->ymax);
+		entries += (double)(x1 - x0 + 1) * (y1 - y0 + 1);
+
+		if (cell_start)
+		{
+			for (y = y0; y <= y1; y++)
+				for (x = x0; x <= x1; x++)
+					cell_start[y * state->nx + x + 1]++;
+		}
+	}
+	return entries;
+}
+
+/* Lay the boxes of an input out on the grid */
+static void
+partition_join_fill_cells(PartitionJoinState *state, PartitionJoinSide *side)
+{
+	int ncells = state->nx * state->ny;
+	int *next;
+	int c, i, x, y;
+
+	side->cell_start = palloc0(sizeof(int) * (ncells + 1));
+	partition_join_count_cells(state, side, side->cell_start);
+	for (c = 0; c < ncells; c++)
+		side->cell_start[c + 1] += side->cell_start[c];
+
+	side->cell_item = palloc_extended(sizeof(int) * Max(side->cell_start[ncells], 1), MCXT_ALLOC_HUGE);
+	next = palloc(sizeof(int) * ncells);
+	memcpy(next, side->cell_start, sizeof(int) * ncells);
+
+	for (i = 0; i < side->nitems; i++)
+	{
+		const BOX2DF *box = &(side->items[i].box);
+		int x0, x1, y0, y1;
+
+		if (!box2df_overlaps(box, &(state->extent)))
+			continue;
+
+		x0 = partition_join_cell_x(state, box->xmin);
+		x1 = partition_join_cell_x(state, box->xmax);
+		y0 = partition_join_cell_y(state, box->ymin);
+		y1 = partition_join_cell_y(state, box->ymax);
+		for (y = y0; y <= y1; y++)
+			for (x = x0; x <= x1; x++)
+				side->cell_item[next[y * state->nx + x]++] = i;
+	}
+	pfree(next);
+}
+
+static void
+partition_join_set_grid(PartitionJoinState *state, int ncells)
+{
+	double width = (double)state->extent.xmax - (double)state->extent.xmin;
+	double height = (double)state->extent.ymax - (double)state->extent.ymin;
+
+	/* Keep the cells about square */
+	if (width > 0.0 && height > 0.0)
+		state->nx = (int)Min(ceil(sqrt(ncells * width / height)), ncells);
+	else if (width > 0.0)
+		state->nx = ncells;
+	else
+		state->nx = 1;
+	state->nx = Max(1, state->nx);
+	state->ny = Max(1, ncells / state->nx);
+
+	state->cell_width = width / state->nx;
+	state->cell_height = height / state->ny;
+}
+
+/*
+ * Grid the rows held in memory. The grid covers the overlap of their
+ * extents, as no join pairs are found outside it, and is coarsened as
+ * long as large boxes fill too many of its cells.
+ */
+static void
+partition_join_grid(PartitionJoinState *state)
+{
+	BOX2DF outer_extent, inner_extent;
+	MemoryContext old_context;
+	double nitems;
+	int ncells;
+
+	state->nx = state->ny = 0;
+	state->cell = 0;
+	memset(&(state->sweep), 0, sizeof(PartitionJoinSweep));
+
+	if (!state->outer.nitems || !state->inner.nitems)
+		return;
+
+	partition_join_extent(&(state->outer), &outer_extent);
+	partition_join_extent(&(state->inner), &inner_extent);
+	if (!box2df_overlaps(&outer_extent, &inner_extent))
+		return;
+
+	state->extent.xmin = Max(outer_extent.xmin, inner_extent.xmin);
+	state->extent.ymin = Max(outer_extent.ymin, inner_extent.ymin);
+	state->extent.xmax = Min(outer_extent.xmax, inner_extent.xmax);
+	state->extent.ymax = Min(outer_extent.ymax, inner_extent.ymax);
+
+	nitems = (double)state->outer.nitems + state->inner.nitems;
+	ncells = (int)Min(nitems / PARTITION_JOIN_CELL_ITEMS, PARTITION_JOIN_MAX_CELLS);
+	ncells = Max(ncells, 1);
+	for (;;)
+	{
+		double entries;
+
+		partition_join_set_grid(state, ncells);
+		if (ncells == 1)
+			break;
+
+		entries = partition_join_count_cells(state, &(state->outer), NULL) +
+		          partition_join_count_cells(state, &(state->inner), NULL);
+		if (entries <= PARTITION_JOIN_MAX_COPIES * nitems)
+			break;
+
+		ncells /= 4;
+	}
+
+	old_context = MemoryContextSwitchTo(state->band_context);
+	partition_join_fill_cells(state, &(state->outer));
+	partition_join_fill_cells(state, &(state->inner));
+	MemoryContextSwitchTo(old_context);
+}
+
+/*
+ * Read both inputs. If they fit in memory, grid them; otherwise split
+ * the temporary files into bands, about two per hash_mem of rows, for
+ * partition_join_next_band to grid one by one.
+ */
+static void
+partition_join_build(PartitionJoinState *state)
+{
+	PlanState *outer_ps = (PlanState *) linitial(state->css.custom_ps);
+	PlanState *inner_ps = (PlanState *) lsecond(state->css.custom_ps);
+	double height;
+
+	partition_join_load(state, outer_ps, &(state->outer), state->radius);
+	partition_join_load(state, inner_ps, &(state->inner), 0.0);
+
+	state->loaded = true;
+	state->nbands = 0;
+	state->band = -1;
+
+	if (!state->outer.nrows || !state->inner.nrows ||
+	    !box2df_overlaps(&(state->outer.extent), &(state->inner.extent)))
+	{
+		partition_join_reset_band(state);
+		return;
+	}
+
+	state->join_extent.xmin = Max(state->outer.extent.xmin, state->inner.extent.xmin);
+	state->join_extent.ymin = Max(state->outer.extent.ymin, state->inner.extent.ymin);
+	state->join_extent.xmax = Min(state->outer.extent.xmax, state->inner.extent.xmax);
+	state->join_extent.ymax = Min(state->outer.extent.ymax, state->inner.extent.ymax);
+
+	if (!state->spilled)
+	{
+		state->nbands = 1;
+		state->band = 0;
+		partition_join_grid(state);
+		return;
+	}
+
+	height = (double)state->join_extent.ymax - (double)state->join_extent.ymin;
+	state->nbands = 1;
+	if (height > 0.0)
+		state->nbands = (int)Min(ceil(2.0 * state->spill_bytes / state->hash_mem), PARTITION_JOIN_MAX_BANDS);
+	state->nbands = Max(state->nbands, 1);
+	state->band_height = height / state->nbands;
+
+	partition_join_split(state, &(state->outer));
+	partition_join_split(state, &(state->inner));
+}
+
+/* Move on to the next band of spilled rows, if any */
+static bool
+partition_join_next_band(PartitionJoinState *state)
+{
+	if (!state->spilled || state->band + 1 >= state->nbands)
+		return false;
+
+	partition_join_reset_band(state);
+	state->band++;
+	partition_join_load_band(state, &(state->outer));
+	partition_join_load_band(state, &(state->inner));
+	partition_join_grid(state);
+	return true;
+}
+
+static int
+partition_join_cmp_xmin(const void *a, const void *b, void *arg)
+{
+	const PartitionJoinItem *items = (const PartitionJoinItem *) arg;
+	float xa = items[*((const int *) a)].box.xmin;
+	float xb = items[*((const int *) b)].box.xmin;
+	return xa < xb ? -1 : (xa > xb ? 1 : 0);
+}
+
+/* Sort the items of a cell along X to sweep it */
+static void
+partition_join_start_cell(PartitionJoinState *state, int cell)
+{
+	PartitionJoinSweep *sweep = &(state->sweep);
+
+	sweep->cell = cell;
+	sweep->outer = state->outer.cell_item + state->outer.cell_start[cell];
+	sweep->inner = state->inner.cell_item + state->inner.cell_start[cell];
+	sweep->nouter = state->outer.cell_start[cell + 1] - state->outer.cell_start[cell];
+	sweep->ninner = state->inner.cell_start[cell + 1] - state->inner.cell_start[cell];
+	sweep->o = sweep->i = sweep->k = 0;
+	sweep->running = false;
+
+	if (!sweep->nouter || !sweep->ninner)
+		return;
+
+	qsort_arg(sweep->outer, sweep->nouter, sizeof(int), partition_join_cmp_xmin, state->outer.items);
+	qsort_arg(sweep->inner, sweep->ninner, sizeof(int), partition_join_cmp_xmin, state->inner.items);
+}
+
+/*
+ * Keep a pair of overlapping boxes if the lower left corner of their
+ * overlap is in the swept cell of the current band. Pairs overlapping
+ * in several cells or bands are kept by exactly one of them.
+ */
+static inline bool
+partition_join_keep_pair(const PartitionJoinState *state, int o, int i)
+{
+	const BOX2DF *a = &(state->outer.items[o].box);
+	const BOX2DF *b = &(state->inner.items[i].box);
+	double x, y;
+
+	if (!box2df_overlaps(a, b))
+		return false;
+
+	x = Max(a->xmin, b->xmin);
+	y = Max(a->ymin, b->ymin);
+	if (partition_join_band(state, y) != state->band)
+		return false;
+
+	return partition_join_cell_y(state, y) * state->nx + partition_join_cell_x(state, x) == state->sweep.cell;
+}
+
+/*
+ * Next candidate pair of the swept cell. The items of both inputs are
+ * taken in xmin order, and each one is paired with the items of the
+ * other input that start before it ends. The sweep stops after each
+ * pair, so no more than one pair is ever held.
+ */
+static bool
+partition_join_next_pair(PartitionJoinState *state, int *outer_item, int *inner_item)
+{
+	PartitionJoinSweep *sweep = &(state->sweep);
+	PartitionJoinItem *outer_items = state->outer.items;
+	PartitionJoinItem *inner_items = state->inner.items;
+
+	for (;;)
+	{
+		int o, i;
+
+		if (!sweep->running)
+		{
+			if (sweep->o >= sweep->nouter || sweep->i >= sweep->ninner)
+				return false;
+
+			sweep->outer_leads = outer_items[sweep->outer[sweep->o]].box.xmin <=
+			                     inner_items[sweep->inner[sweep->i]].box.xmin;
+			sweep->k = sweep->outer_leads ? sweep->i : sweep->o;
+			sweep->running = true;
+		}
+
+		if (sweep->outer_leads)
+		{
+			o = sweep->outer[sweep->o];
+			if (sweep->k >= sweep->ninner ||
+			    inner_items[sweep->inner[sweep->k]].box.xmin > outer_items[o].box.xmax)
+			{
+				sweep->o++;
+				sweep->running = false;
+				continue;
+			}
+			i = sweep->inner[sweep->k++];
+		}
+		else
+		{
+			i = sweep->inner[sweep->i];
+			if (sweep->k >= sweep->nouter ||
+			    outer_items[sweep->outer[sweep->k]].box.xmin > inner_items[i].box.xmax)
+			{
+				sweep->i++;
+				sweep->running = false;
+				continue;
+			}
+			o = sweep->outer[sweep->k++];
+		}
+
+		if (partition_join_keep_pair(state, o, i))
+		{
+			*outer_item = o;
+			*inner_item = i;
+			return true;
+		}
+	}
+}
+
+/* Next candidate pair of rows, as a scan tuple for the join clauses to check */
+static TupleTableSlot *
+partition_join_next(ScanState *node)
+{
+	PartitionJoinState *state = (PartitionJoinState *) node;
+	TupleTableSlot *slot = node->ss_ScanTupleSlot;
+	TupleTableSlot *outer_slot = state->outer.slot;
+	TupleTableSlot *inner_slot = state->inner.slot;
+	int outer_natts, inner_natts;
+	int o, i;
+
+	if (!state->loaded)
+		partition_join_build(state);
+
+	while (!partition_join_next_pair(state, &o, &i))
+	{
+		CHECK_FOR_INTERRUPTS();
+		if (state->cell < state->nx * state->ny)
+			partition_join_start_cell(state, state->cell++);
+		else if (!partition_join_next_band(state))
+			return ExecClearTuple(slot);
+	}
+
+	ExecStoreMinimalTuple(state->outer.items[o].tuple, outer_slot, false);
+	ExecStoreMinimalTuple(state->inner.items[i].tuple, inner_slot, false);
+	slot_getallattrs(outer_slot);
+	slot_getallattrs(inner_slot);
+	outer_natts = outer_slot->tts_tupleDescriptor->natts;
+	inner_natts = inner_slot->tts_tupleDescriptor->natts;
+
+	ExecClearTuple(slot);
+	memcpy(slot->tts_values, outer_slot->tts_values, sizeof(Datum) * outer_natts);
+	memcpy(slot->tts_isnull, outer_slot->tts_isnull, sizeof(bool) * outer_natts);
+	memcpy(slot->tts_values + outer_natts, inner_slot->tts_values, sizeof(Datum) * inner_natts);
+	memcpy(slot->tts_isnull + outer_natts, inner_slot->tts_isnull, sizeof(bool) * inner_natts);
+	return ExecStoreVirtualTuple(slot);
+}
+
+static bool
+partition_join_recheck(ScanState *node, TupleTableSlot *slot)
+{
+	return true;
+}
+
+static TupleTableSlot *
+partition_join_exec(CustomScanState *node)
+{
+	return ExecScan(&(node->ss),
+	                (ExecScanAccessMtd) partition_join_next,
+	                (ExecScanRecheckMtd) partition_join_recheck);
+}
+
+static void
+partition_join_end(CustomScanState *node)
+{
+	PartitionJoinState *state = (PartitionJoinState *) node;
+	ListCell *lc;
+
+	ExecDropSingleTupleTableSlot(state->outer.slot);
+	ExecDropSingleTupleTableSlot(state->inner.slot);
+	foreach (lc, node->custom_ps)
+		ExecEndNode((PlanState *) lfirst(lc));
+	partition_join_close_files(state, &(state->outer));
+	partition_join_close_files(state, &(state->inner));
+	MemoryContextDelete(state->key_context);
+	MemoryContextDelete(state->band_context);
+	MemoryContextDelete(state->context);
+}
+
+static void
+partition_join_rescan(CustomScanState *node)
+{
+	PartitionJoinState *state = (PartitionJoinState *) node;
+	ListCell *lc;
+
+	/* Same inputs, so just run the grid, or the bands, again */
+	if (state->loaded && node->ss.ps.chgParam == NULL)
+	{
+		if (state->spilled)
+		{
+			partition_join_reset_band(state);
+			state->band = -1;
+		}
+		else
+		{
+			state->cell = 0;
+			memset(&(state->sweep), 0, sizeof(PartitionJoinSweep));
+		}
+		return;
+	}
+
+	foreach (lc, node->custom_ps)
+	{
+		PlanState *child = (PlanState *) lfirst(lc);
+		UpdateChangedParamSet(child, node->ss.ps.chgParam);
+		if (child->chgParam == NULL)
+			ExecReScan(child);
+	}
+
+	partition_join_close_files(state, &(state->outer));
+	partition_join_close_files(state, &(state->inner));
+	partition_join_reset_band(state);
+	MemoryContextReset(state->context);
+	state->spilled = false;
+	state->spill_bytes = 0;
+	state->loaded = false;
+}
+
+void
+partition_join_init(void)
+{
+	prev_set_join_pathlist_hook = set_join_pathlist_hook;
+	set_join_pathlist_hook = partition_join_pathlist;
+
+	/* A library reloaded during an upgrade finds the name taken */
+	if (!GetCustomScanMethods(partition_join_scan_methods.CustomName, true))
+		RegisterCustomScanMethods(&partition_join_scan_methods);
+}
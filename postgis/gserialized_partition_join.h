@@ -0,0 +1,15 @@
+#ifndef _GSERIALIZED_PARTITION_JOIN_H
+#define _GSERIALIZED_PARTITION_JOIN_H 1
+
+/*
+ * When set, the planner may join two geometry inputs on ST_Intersects,
+ * ST_DWithin or && by gridding their boxes and sweeping each grid cell,
+ * instead of running the predicate for every pair of rows.
+ * Set by the postgis.partition_join GUC.
+ */
+extern bool partition_join;
+
+/* Install the join path hook and register the custom scan */
+void partition_join_init(void);
+
+#endif /* _GSERIALIZED_PARTITION_JOIN_H */
@@ -81,6 +81,7 @@
 #include "lwgeom_pg.h"        /* For debugging macros. */
 #include <gserialized_gist.h> /* For utility functions. */
 #include <lwgeom_pg.h>        /* For debugging macros. */
+#include <float.h>
 #include <math.h>
 
 /*
@@ -281,6 +282,59 @@ overAbove4D(RectBox *rect_box, BOX2DF *query)
 	return rect_box->left.ymin >= query->ymin;
 }
 
+/*
+ * Lower bound of the distance between query and any box in rect_box
+ *
+ * The boxes of a quadrant can stretch from the lowest possible minimum
+ * to the highest possible maximum on each axis, so the distance from
+ * that extent to the query is never more than the distance of the
+ * boxes below it.
+ */
+static double
+distanceRectBox(RectBox *rect_box, BOX2DF *query)
+{
+	double dx = 0.0, dy = 0.0;
+
+	if (query->xmax < rect_box->left.xmin)
+		dx = (double)rect_box->left.xmin - (double)query->xmax;
+	else if (query->xmin > rect_box->right.xmax)
+		dx = (double)query->xmin - (double)rect_box->right.xmax;
+
+	if (query->ymax < rect_box->left.ymin)
+		dy = (double)rect_box->left.ymin - (double)query->ymax;
+	else if (query->ymin > rect_box->right.ymax)
+		dy = (double)query->ymin - (double)rect_box->right.ymax;
+
+	return sqrt(dx * dx + dy * dy);
+}
+
+/*
+ * Fill in the ordering distances of a quadrant, one per ORDER BY <->
+ */
+static double *
+orderbyDistances(RectBox *rect_box, ScanKey orderbys, int norderbys)
+{
+	double *distances = (double *)palloc(sizeof(double) * norderbys);
+	int i;
+
+	for (i = 0; i < norderbys; i++)
+	{
+		BOX2DF query_gbox_index;
+
+		if (orderbys[i].sk_strategy != RTKNNSearchStrategyNumber)
+			elog(ERROR, "unrecognized strategy: %d", orderbys[i].sk_strategy);
+
+		/* Empty queries sort last, as they do in the GiST index */
+		if (DatumGetPointer(orderbys[i].sk_argument) == NULL ||
+		    gserialized_datum_get_box2df_p(orderbys[i].sk_argument, &query_gbox_index) == LW_FAILURE)
+			distances[i] = FLT_MAX;
+		else
+			distances[i] = distanceRectBox(rect_box, &query_gbox_index);
+	}
+
+	return distances;
+}
+
 /*
  * SP-GiST config function
  */
@@ -415,6 +469,15 @@ PGDLLEXPORT Datum gserialized_spgist_inner_consistent_2d(PG_FUNCTION_ARGS)
 	uint8 quadrant;
 	BOX2DF *centroid;
 
+	/*
+	 * We are saving the traversal value or initialize it an unbounded one, if
+	 * we have just begun to walk the tree.
+	 */
+	if (in->traversalValue)
+		rect_box = in->traversalValue;
+	else
+		rect_box = initRectBox();
+
 	if (in->allTheSame)
 	{
 		/* Report that all nodes should be visited */
@@ -423,24 +486,25 @@ PGDLLEXPORT Datum gserialized_spgist_inner_consistent_2d(PG_FUNCTION_ARGS)
 		for (i = 0; i < in->nNodes; i++)
 			out->nodeNumbers[i] = i;
 
+		/* All nodes share the bounds of their parent */
+		if (in->norderbys > 0 && in->nNodes > 0)
+		{
+			out->distances = (double **)palloc(sizeof(double *) * in->nNodes);
+			for (i = 0; i < in->nNodes; i++)
+				out->distances[i] = orderbyDistances(rect_box, in->orderbys, in->norderbys);
+		}
+
 		PG_RETURN_VOID();
 	}
 
-	/*
-	 * We are saving the traversal value or initialize it an unbounded one, if
-	 * we have just begun to walk the tree.
-	 */
-	if (in->traversalValue)
-		rect_box = in->traversalValue;
-	else
-		rect_box = initRectBox();
-
 	centroid = (BOX2DF *)DatumGetPointer(in->prefixDatum);
 
 	/* Allocate enough memory for nodes */
 	out->nNodes = 0;
 	out->nodeNumbers = (int *)palloc(sizeof(int) * in->nNodes);
 	out->traversalValues = (void **)palloc(sizeof(void *) * in->nNodes);
+	if (in->norderbys > 0)
+		out->distances = (double **)palloc(sizeof(double *) * in->nNodes);
 
 	/*
 	 * We switch memory context, because we want to allocate memory for new
@@ -532,6 +596,8 @@ PGDLLEXPORT Datum gserialized_spgist_inner_consistent_2d(PG_FUNCTION_ARGS)
 		{
 			out->traversalValues[out->nNodes] = next_rect_box;
 			out->nodeNumbers[out->nNodes] = quadrant;
+			if (in->norderbys > 0)
+				out->distances[out->nNodes] = orderbyDistances(next_rect_box, in->orderbys, in->norderbys);
 			out->nNodes++;
 		}
 		else
@@ -657,6 +723,26 @@ PGDLLEXPORT Datum gserialized_spgist_leaf_consistent_2d(PG_FUNCTION_ARGS)
 			break;
 	}
 
+	/* Only boxes are indexed, the executor rechecks the true distance */
+	if (flag && in->norderbys > 0)
+	{
+		out->distances = (double *)palloc(sizeof(double) * in->norderbys);
+		out->recheckDistances = true;
+		for (i = 0; i < in->norderbys; i++)
+		{
+			BOX2DF query_gbox_index;
+
+			if (in->orderbys[i].sk_strategy != RTKNNSearchStrategyNumber)
+				elog(ERROR, "unrecognized strategy: %d", in->orderbys[i].sk_strategy);
+
+			if (box2df_is_empty(key) || DatumGetPointer(in->orderbys[i].sk_argument) == NULL ||
+			    gserialized_datum_get_box2df_p(in->orderbys[i].sk_argument, &query_gbox_index) == LW_FAILURE)
+				out->distances[i] = FLT_MAX;
+			else
+				out->distances[i] = box2df_distance(key, &query_gbox_index);
+		}
+	}
+
 	PG_RETURN_BOOL(flag);
 }
 
@@ -363,6 +363,104 @@ overBack6D(CubeBox3D *cube_box, BOX3D *query)
 	return (cube_box->left.zmin >= query->zmin);
 }
 
+/*
+ * Lower bound of the distance between query and any box in cube_box
+ *
+ * Only X and Y are used: <<->> measures in 2D as soon as one side has
+ * no Z, and such geometries are indexed with a zero Z range.
+ */
+static double
+distanceCubeBox(CubeBox3D *cube_box, const GBOX *query)
+{
+	double dx = 0.0, dy = 0.0;
+
+	if (query->xmax < cube_box->left.xmin)
+		dx = cube_box->left.xmin - query->xmax;
+	else if (query->xmin > cube_box->right.xmax)
+		dx = query->xmin - cube_box->right.xmax;
+
+	if (query->ymax < cube_box->left.ymin)
+		dy = cube_box->left.ymin - query->ymax;
+	else if (query->ymin > cube_box->right.ymax)
+		dy = query->ymin - cube_box->right.ymax;
+
+	return sqrt(dx * dx + dy * dy);
+}
+
+/*
+ * XY distance between two boxes, zero if they overlap
+ */
+static double
+distanceBox3D(BOX3D *leaf, const GBOX *query)
+{
+	double dx = 0.0, dy = 0.0;
+
+	if (query->xmax < leaf->xmin)
+		dx = leaf->xmin - query->xmax;
+	else if (query->xmin > leaf->xmax)
+		dx = query->xmin - leaf->xmax;
+
+	if (query->ymax < leaf->ymin)
+		dy = leaf->ymin - query->ymax;
+	else if (query->ymin > leaf->ymax)
+		dy = query->ymin - leaf->ymax;
+
+	return sqrt(dx * dx + dy * dy);
+}
+
+/*
+ * Bounding boxes of the ORDER BY <<->> arguments, NULL for NULL or
+ * EMPTY arguments
+ */
+static GBOX **
+orderbyBoxes(ScanKey orderbys, int norderbys)
+{
+	GBOX **boxes = (GBOX **)palloc(sizeof(GBOX *) * norderbys);
+	int i;
+
+	for (i = 0; i < norderbys; i++)
+	{
+		Datum arg = orderbys[i].sk_argument;
+		GBOX *box = (GBOX *)palloc(sizeof(GBOX));
+
+		if (orderbys[i].sk_strategy != SPGKNNSearchStrategyNumber)
+			elog(ERROR, "unrecognized strategy: %d", orderbys[i].sk_strategy);
+
+		if (DatumGetPointer(arg) == NULL || gserialized_datum_get_gbox_p(arg, box) == LW_FAILURE)
+		{
+			pfree(box);
+			box = NULL;
+		}
+		boxes[i] = box;
+	}
+
+	return boxes;
+}
+
+static double
+orderbyDistance(CubeBox3D *cube_box, BOX3D *leaf, const GBOX *query)
+{
+	/*
+	 * <<->> measures zero against EMPTY rather than returning NULL, so
+	 * zero is the only bound that does not overtake the recheck
+	 */
+	if (!query)
+		return 0.0;
+	return cube_box ? distanceCubeBox(cube_box, query) : distanceBox3D(leaf, query);
+}
+
+static double *
+orderbyDistances(CubeBox3D *cube_box, GBOX **boxes, int norderbys)
+{
+	double *distances = (double *)palloc(sizeof(double) * norderbys);
+	int i;
+
+	for (i = 0; i < norderbys; i++)
+		distances[i] = orderbyDistance(cube_box, NULL, boxes[i]);
+
+	return distances;
+}
+
 /*
  * SP-GiST config function
  */
@@ -515,6 +613,20 @@ PGDLLEXPORT Datum gserialized_spgist_inner_consistent_3d(PG_FUNCTION_ARGS)
 	BOX3D *centroid;
 	int *nodeNumbers;
 	void **traversalValues;
+	double **distances = NULL;
+	GBOX **orderby_boxes = NULL;
+
+	/*
+	 * We are saving the traversal value or initialize it an unbounded one, if
+	 * we have just begun to walk the tree.
+	 */
+	if (in->traversalValue)
+		cube_box = in->traversalValue;
+	else
+		cube_box = initCubeBox();
+
+	if (in->norderbys > 0)
+		orderby_boxes = orderbyBoxes(in->orderbys, in->norderbys);
 
 	if (in->allTheSame)
 	{
@@ -524,24 +636,25 @@ PGDLLEXPORT Datum gserialized_spgist_inner_consistent_3d(PG_FUNCTION_ARGS)
 		for (i = 0; i < in->nNodes; i++)
 			out->nodeNumbers[i] = i;
 
+		/* All nodes share the bounds of their parent */
+		if (in->norderbys > 0 && in->nNodes > 0)
+		{
+			out->distances = (double **)palloc(sizeof(double *) * in->nNodes);
+			for (i = 0; i < in->nNodes; i++)
+				out->distances[i] = orderbyDistances(cube_box, orderby_boxes, in->norderbys);
+		}
+
 		PG_RETURN_VOID();
 	}
 
-	/*
-	 * We are saving the traversal value or initialize it an unbounded one, if
-	 * we have just begun to walk the tree.
-	 */
-	if (in->traversalValue)
-		cube_box = in->traversalValue;
-	else
-		cube_box = initCubeBox();
-
 	centroid = DatumGetBox3DP(in->prefixDatum);
 
 	/* Allocate enough memory for nodes */
 	out->nNodes = 0;
 	nodeNumbers = (int *)palloc(sizeof(int) * in->nNodes);
 	traversalValues = (void **)palloc(sizeof(void *) * in->nNodes);
+	if (in->norderbys > 0)
+		distances = (double **)palloc(sizeof(double *) * in->nNodes);
 
 	/*
 	 * We switch memory context, because we want to allocate memory for new
@@ -634,6 +747,8 @@ PGDLLEXPORT Datum gserialized_spgist_inner_consistent_3d(PG_FUNCTION_ARGS)
 		{
 			traversalValues[out->nNodes] = next_cube_box;
 			nodeNumbers[out->nNodes] = octant;
+			if (distances)
+				distances[out->nNodes] = orderbyDistances(next_cube_box, orderby_boxes, in->norderbys);
 			out->nNodes++;
 		}
 		else
@@ -657,6 +772,14 @@ PGDLLEXPORT Datum gserialized_spgist_inner_consistent_3d(PG_FUNCTION_ARGS)
 	pfree(nodeNumbers);
 	pfree(traversalValues);
 
+	if (distances)
+	{
+		out->distances = (double **)palloc(sizeof(double *) * out->nNodes);
+		for (i = 0; i < out->nNodes; i++)
+			out->distances[i] = distances[i];
+		pfree(distances);
+	}
+
 	/* Switch after */
 	MemoryContextSwitchTo(old_ctx);
 
@@ -764,6 +887,17 @@ PGDLLEXPORT Datum gserialized_spgist_leaf_consistent_3d(PG_FUNCTION_ARGS)
 			break;
 	}
 
+	/* Only boxes are indexed, the executor rechecks the true distance */
+	if (flag && in->norderbys > 0)
+	{
+		GBOX **orderby_boxes = orderbyBoxes(in->orderbys, in->norderbys);
+
+		out->distances = (double *)palloc(sizeof(double) * in->norderbys);
+		out->recheckDistances = true;
+		for (i = 0; i < in->norderbys; i++)
+			out->distances[i] = orderbyDistance(NULL, leaf, orderby_boxes[i]);
+	}
+
 	PG_RETURN_BOOL(flag);
 }
 
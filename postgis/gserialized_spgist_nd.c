@@ -258,6 +258,112 @@ containND(CubeGIDX *cube_box, GIDX *query)
 	return result;
 }
 
+/*
+ * Lower bound of the distance between query and any box in cube_box
+ *
+ * Only X and Y are used, as in the 3D opclass: <<->> measures in 2D as
+ * soon as one side has no Z, and the M term is never negative.  Unbounded
+ * dimensions span the whole axis and so contribute nothing.
+ */
+static double
+distanceCubeND(CubeGIDX *cube_box, GIDX *query)
+{
+	int i, ndims;
+	double d, sum = 0.0;
+
+	ndims = Min(Min(GIDX_NDIMS(cube_box->left), GIDX_NDIMS(query)), 2);
+
+	for (i = 0; i < ndims; i++)
+	{
+		d = 0.0;
+		if (GIDX_GET_MAX(query, i) < GIDX_GET_MIN(cube_box->left, i))
+			d = GIDX_GET_MIN(cube_box->left, i) - GIDX_GET_MAX(query, i);
+		else if (GIDX_GET_MIN(query, i) > GIDX_GET_MAX(cube_box->right, i))
+			d = GIDX_GET_MIN(query, i) - GIDX_GET_MAX(cube_box->right, i);
+		sum += d * d;
+	}
+	return sqrt(sum);
+}
+
+/*
+ * XY distance between two boxes, zero if they overlap
+ */
+static double
+distanceGIDX(GIDX *leaf, GIDX *query)
+{
+	int i;
+	double d, sum = 0.0;
+
+	/* Non-finite leaves can still have finite distances */
+	if (gidx_is_unknown(leaf))
+		return 0.0;
+
+	for (i = 0; i < 2; i++)
+	{
+		d = 0.0;
+		if (GIDX_GET_MAX(query, i) < GIDX_GET_MIN(leaf, i))
+			d = GIDX_GET_MIN(leaf, i) - GIDX_GET_MAX(query, i);
+		else if (GIDX_GET_MIN(query, i) > GIDX_GET_MAX(leaf, i))
+			d = GIDX_GET_MIN(query, i) - GIDX_GET_MAX(leaf, i);
+		sum += d * d;
+	}
+	return sqrt(sum);
+}
+
+/*
+ * Bounding boxes of the ORDER BY <<->> arguments, NULL for NULL, EMPTY
+ * or non-finite arguments, which cannot bound anything
+ */
+static GIDX **
+orderbyBoxes(ScanKey orderbys, int norderbys)
+{
+	GIDX **boxes = (GIDX **)palloc(sizeof(GIDX *) * norderbys);
+	char gidxmem[GIDX_MAX_SIZE];
+	GIDX *box = (GIDX *)gidxmem;
+	int i;
+
+	for (i = 0; i < norderbys; i++)
+	{
+		Datum arg = orderbys[i].sk_argument;
+
+		if (orderbys[i].sk_strategy != SPGKNNSearchStrategyNumber)
+			elog(ERROR, "unrecognized strategy: %d", orderbys[i].sk_strategy);
+
+		boxes[i] = NULL;
+		if (DatumGetPointer(arg) != NULL && gserialized_datum_get_gidx_p(arg, box) == LW_SUCCESS &&
+		    isfinite(GIDX_GET_MIN(box, 0)) && isfinite(GIDX_GET_MAX(box, 0)) &&
+		    isfinite(GIDX_GET_MIN(box, 1)) && isfinite(GIDX_GET_MAX(box, 1)))
+			boxes[i] = gidx_copy(box);
+	}
+
+	return boxes;
+}
+
+/*
+ * Distances of the ORDER BY arguments to cube_box, or to the whole space
+ * when we have no traversal value yet
+ */
+static double *
+orderbyDistances(CubeGIDX *cube_box, GIDX **boxes, int norderbys)
+{
+	double *distances = (double *)palloc(sizeof(double) * norderbys);
+	int i;
+
+	for (i = 0; i < norderbys; i++)
+	{
+		/*
+		 * <<->> measures zero against EMPTY rather than returning NULL,
+		 * so zero is the only bound that does not overtake the recheck
+		 */
+		if (!boxes[i] || !cube_box)
+			distances[i] = 0.0;
+		else
+			distances[i] = distanceCubeND(cube_box, boxes[i]);
+	}
+
+	return distances;
+}
+
 /*
  * SP-GiST config function
  */
@@ -401,11 +507,16 @@ PGDLLEXPORT Datum gserialized_spgist_inner_consistent_nd(PG_FUNCTION_ARGS)
 	CubeGIDX *cube_box;
 	int *nodeNumbers, i, j;
 	void **traversalValues;
+	double **distances = NULL;
+	GIDX **orderby_boxes = NULL;
 	char gidxmem[GIDX_MAX_SIZE];
 	GIDX *centroid, *query_gbox_index = (GIDX *)gidxmem;
 
 	POSTGIS_DEBUG(4, "[SPGIST] 'inner consistent' function called");
 
+	if (in->norderbys > 0)
+		orderby_boxes = orderbyBoxes(in->orderbys, in->norderbys);
+
 	if (in->allTheSame)
 	{
 		/* Report that all nodes should be visited */
@@ -414,6 +525,14 @@ PGDLLEXPORT Datum gserialized_spgist_inner_consistent_nd(PG_FUNCTION_ARGS)
 		for (i = 0; i < in->nNodes; i++)
 			out->nodeNumbers[i] = i;
 
+		/* All nodes share the bounds of their parent */
+		if (in->norderbys > 0 && in->nNodes > 0)
+		{
+			out->distances = (double **)palloc(sizeof(double *) * in->nNodes);
+			for (i = 0; i < in->nNodes; i++)
+				out->distances[i] = orderbyDistances(in->traversalValue, orderby_boxes, in->norderbys);
+		}
+
 		PG_RETURN_VOID();
 	}
 
@@ -439,6 +558,8 @@ PGDLLEXPORT Datum gserialized_spgist_inner_consistent_nd(PG_FUNCTION_ARGS)
 	out->nNodes = 0;
 	nodeNumbers = (int *)palloc(sizeof(int) * in->nNodes);
 	traversalValues = (void **)palloc(sizeof(void *) * in->nNodes);
+	if (in->norderbys > 0)
+		distances = (double **)palloc(sizeof(double *) * in->nNodes);
 
 	for (i = 0; i < in->nNodes; i++)
 	{
@@ -491,6 +612,8 @@ PGDLLEXPORT Datum gserialized_spgist_inner_consistent_nd(PG_FUNCTION_ARGS)
 		{
 			traversalValues[out->nNodes] = next_cube_box;
 			nodeNumbers[out->nNodes] = i;
+			if (in->norderbys > 0)
+				distances[out->nNodes] = orderbyDistances(next_cube_box, orderby_boxes, in->norderbys);
 			out->nNodes++;
 		}
 		else
@@ -506,13 +629,19 @@ PGDLLEXPORT Datum gserialized_spgist_inner_consistent_nd(PG_FUNCTION_ARGS)
 	/* Pass to the next level only the values that need to be traversed */
 	out->nodeNumbers = (int *)palloc(sizeof(int) * out->nNodes);
 	out->traversalValues = (void **)palloc(sizeof(void *) * out->nNodes);
+	if (in->norderbys > 0)
+		out->distances = (double **)palloc(sizeof(double *) * out->nNodes);
 	for (i = 0; i < out->nNodes; i++)
 	{
 		out->nodeNumbers[i] = nodeNumbers[i];
 		out->traversalValues[i] = traversalValues[i];
+		if (in->norderbys > 0)
+			out->distances[i] = distances[i];
 	}
 	pfree(nodeNumbers);
 	pfree(traversalValues);
+	if (distances)
+		pfree(distances);
 
 	/* Switch after */
 	MemoryContextSwitchTo(old_ctx);
@@ -589,6 +718,17 @@ PGDLLEXPORT Datum gserialized_spgist_leaf_consistent_nd(PG_FUNCTION_ARGS)
 			break;
 	}
 
+	/* Box distances are lower bounds, the executor rechecks them */
+	if (flag && in->norderbys > 0)
+	{
+		GIDX **orderby_boxes = orderbyBoxes(in->orderbys, in->norderbys);
+
+		out->distances = (double *)palloc(sizeof(double) * in->norderbys);
+		out->recheckDistances = true;
+		for (i = 0; i < in->norderbys; i++)
+			out->distances[i] = orderby_boxes[i] ? distanceGIDX(leaf, orderby_boxes[i]) : 0.0;
+	}
+
 	PG_RETURN_BOOL(flag);
 }
 
@@ -46,12 +46,14 @@
 #include "liblwgeom.h"
 #include "lwgeom_pg.h"
 
+#include <math.h>
+
 /* Local prototypes */
 Datum postgis_index_supportfn(PG_FUNCTION_ARGS);
 
 /* From gserialized_estimate.c */
-float8 gserialized_joinsel_internal(PlannerInfo *root, List *args, JoinType jointype, int mode);
-float8 gserialized_sel_internal(PlannerInfo *root, List *args, int varRelid, int mode);
+float8 gserialized_joinsel_internal(PlannerInfo *root, List *args, JoinType jointype, int mode, double distance);
+float8 gserialized_sel_internal(PlannerInfo *root, List *args, int varRelid, int mode, double distance);
 
 enum ST_FUNCTION_IDX
 {
@@ -301,6 +303,41 @@ expandFunctionOid(Oid geotype, Oid callingfunc)
 	return expandfn_oid;
 }
 
+/*
+* For the "within distance" functions the estimators
+* grow the search by the radius argument, when we can
+* tell its value at plan time. The radius comes back in
+* the units of the planner statistics, which for
+* geography are geocentric coordinates on the unit sphere.
+*/
+static double
+searchDistance(PlannerInfo *root, List *args, const IndexableFunction *idxfn)
+{
+	Node *radiusarg;
+	Const *radiusconst;
+	double distance;
+
+	if (!idxfn->expand_arg || list_length(args) < idxfn->expand_arg)
+		return 0.0;
+
+	radiusarg = estimate_expression_value(root, (Node *) list_nth(args, idxfn->expand_arg - 1));
+	if (!IsA(radiusarg, Const))
+		return 0.0;
+
+	radiusconst = (Const *) radiusarg;
+	if (radiusconst->constisnull || radiusconst->consttype != FLOAT8OID)
+		return 0.0;
+
+	distance = DatumGetFloat8(radiusconst->constvalue);
+	if (!(distance > 0.0) || !isfinite(distance))
+		return 0.0;
+
+	if (exprType(linitial(args)) == postgis_oid(GEOGRAPHYOID))
+		distance /= WGS84_RADIUS;
+
+	return distance;
+}
+
 /*
 * For functions that we want enhanced with spatial
 * index lookups, add this support function to the
@@ -381,14 +418,19 @@ Datum postgis_index_supportfn(PG_FUNCTION_ARGS)
 	if (IsA(rawreq, SupportRequestSelectivity))
 	{
 		SupportRequestSelectivity *req = (SupportRequestSelectivity *) rawreq;
+		IndexableFunction idxfn = {NULL, 0, 0, 0, 0};
+		double distance = 0.0;
+
+		if (needsSpatialIndex(req->funcid, &idxfn))
+			distance = searchDistance(req->root, req->args, &idxfn);
 
 		if (req->is_join)
 		{
-			req->selectivity = gserialized_joinsel_internal(req->root, req->args, req->jointype, 2);
+			req->selectivity = gserialized_joinsel_internal(req->root, req->args, req->jointype, 2, distance);
 		}
 		else
 		{
-			req->selectivity = gserialized_sel_internal(req->root, req->args, req->varRelid, 2);
+			req->selectivity = gserialized_sel_internal(req->root, req->args, req->varRelid, 2, distance);
 		}
 		POSTGIS_DEBUGF(2, "%s: got selectivity %g", __func__, req->selectivity);
 		PG_RETURN_POINTER(req);
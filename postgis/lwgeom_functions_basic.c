@@ -269,16 +269,106 @@ Datum postgis_libxml_version(PG_FUNCTION_ARGS)
 	PG_RETURN_TEXT_P(result);
 }
 
+/*
+* The counts and measures below only need the coordinates, so they read
+* them straight off the serialization with a cursor instead of building
+* an LWGEOM, and fall back to the LWGEOM for what the cursor cannot walk.
+*/
+typedef enum
+{
+	GSERIALIZED_AREA,
+	GSERIALIZED_PERIMETER,
+	GSERIALIZED_PERIMETER_2D,
+	GSERIALIZED_LENGTH,
+	GSERIALIZED_LENGTH_2D
+} gserialized_measure_t;
+
+static int
+gserialized_count_vertices(const GSERIALIZED *g, int *npoints)
+{
+	GSERIALIZED_CURSOR cursor;
+
+	if (gserialized_cursor_init(&cursor, g) == LW_FAILURE)
+		return LW_FAILURE;
+
+	*npoints = 0;
+	while (gserialized_cursor_next(&cursor))
+		*npoints += cursor.pa.npoints;
+	return LW_SUCCESS;
+}
+
+/*
+* Area and perimeter of a (multi)polygon, or length of a (multi)linestring.
+* Each polygon or line is totalled on its own first, as lwgeom_area() and
+* friends do, so the results are the same to the bit.
+*/
+static int
+gserialized_measure(const GSERIALIZED *g, gserialized_measure_t measure, double *result)
+{
+	GSERIALIZED_CURSOR cursor;
+	uint32_t type = gserialized_get_type(g);
+	double total = 0.0, part = 0.0;
+
+	if (measure == GSERIALIZED_LENGTH || measure == GSERIALIZED_LENGTH_2D)
+	{
+		if (type != LINETYPE && type != MULTILINETYPE)
+			return LW_FAILURE;
+	}
+	else if (type != POLYGONTYPE && type != MULTIPOLYGONTYPE)
+		return LW_FAILURE;
+
+	if (gserialized_cursor_init(&cursor, g) == LW_FAILURE)
+		return LW_FAILURE;
+
+	while (gserialized_cursor_next(&cursor))
+	{
+		const POINTARRAY *pa = &cursor.pa;
+
+		/* A new polygon or line */
+		if (cursor.ring == 0)
+		{
+			total += part;
+			part = 0.0;
+		}
+
+		switch (measure)
+		{
+		case GSERIALIZED_AREA:
+			/* Empty or messed-up ring. */
+			if (pa->npoints < 3)
+				break;
+			if (cursor.ring == 0)
+				part += fabs(ptarray_signed_area(pa));
+			else
+				part -= fabs(ptarray_signed_area(pa));
+			break;
+		case GSERIALIZED_PERIMETER:
+		case GSERIALIZED_LENGTH:
+			part += ptarray_length(pa);
+			break;
+		case GSERIALIZED_PERIMETER_2D:
+		case GSERIALIZED_LENGTH_2D:
+			part += ptarray_length_2d(pa);
+			break;
+		}
+	}
+	*result = total + part;
+	return LW_SUCCESS;
+}
+
 /** number of points in an object */
 PG_FUNCTION_INFO_V1(LWGEOM_npoints);
 Datum LWGEOM_npoints(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = PG_GETARG_GSERIALIZED_P(0);
-	LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
 	int npoints = 0;
 
-	npoints = lwgeom_count_vertices(lwgeom);
-	lwgeom_free(lwgeom);
+	if (gserialized_count_vertices(geom, &npoints) == LW_FAILURE)
+	{
+		LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
+		npoints = lwgeom_count_vertices(lwgeom);
+		lwgeom_free(lwgeom);
+	}
 
 	PG_FREE_IF_COPY(geom, 0);
 	PG_RETURN_INT32(npoints);
@@ -309,12 +399,15 @@ PG_FUNCTION_INFO_V1(ST_Area);
 Datum ST_Area(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = PG_GETARG_GSERIALIZED_P(0);
-	LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
 	double area = 0.0;
 
-	area = lwgeom_area(lwgeom);
+	if (gserialized_measure(geom, GSERIALIZED_AREA, &area) == LW_FAILURE)
+	{
+		LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
+		area = lwgeom_area(lwgeom);
+		lwgeom_free(lwgeom);
+	}
 
-	lwgeom_free(lwgeom);
 	PG_FREE_IF_COPY(geom, 0);
 
 	PG_RETURN_FLOAT8(area);
@@ -331,9 +424,14 @@ PG_FUNCTION_INFO_V1(LWGEOM_length2d_linestring);
 Datum LWGEOM_length2d_linestring(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = PG_GETARG_GSERIALIZED_P(0);
-	LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
-	double dist = lwgeom_length_2d(lwgeom);
-	lwgeom_free(lwgeom);
+	double dist = 0.0;
+
+	if (gserialized_measure(geom, GSERIALIZED_LENGTH_2D, &dist) == LW_FAILURE)
+	{
+		LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
+		dist = lwgeom_length_2d(lwgeom);
+		lwgeom_free(lwgeom);
+	}
 	PG_FREE_IF_COPY(geom, 0);
 	PG_RETURN_FLOAT8(dist);
 }
@@ -349,9 +447,14 @@ PG_FUNCTION_INFO_V1(LWGEOM_length_linestring);
 Datum LWGEOM_length_linestring(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = PG_GETARG_GSERIALIZED_P(0);
-	LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
-	double dist = lwgeom_length(lwgeom);
-	lwgeom_free(lwgeom);
+	double dist = 0.0;
+
+	if (gserialized_measure(geom, GSERIALIZED_LENGTH, &dist) == LW_FAILURE)
+	{
+		LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
+		dist = lwgeom_length(lwgeom);
+		lwgeom_free(lwgeom);
+	}
 	PG_FREE_IF_COPY(geom, 0);
 	PG_RETURN_FLOAT8(dist);
 }
@@ -367,10 +470,14 @@ PG_FUNCTION_INFO_V1(LWGEOM_perimeter_poly);
 Datum LWGEOM_perimeter_poly(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = PG_GETARG_GSERIALIZED_P(0);
-	LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
 	double perimeter = 0.0;
 
-	perimeter = lwgeom_perimeter(lwgeom);
+	if (gserialized_measure(geom, GSERIALIZED_PERIMETER, &perimeter) == LW_FAILURE)
+	{
+		LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
+		perimeter = lwgeom_perimeter(lwgeom);
+		lwgeom_free(lwgeom);
+	}
 	PG_FREE_IF_COPY(geom, 0);
 	PG_RETURN_FLOAT8(perimeter);
 }
@@ -386,10 +493,14 @@ PG_FUNCTION_INFO_V1(LWGEOM_perimeter2d_poly);
 Datum LWGEOM_perimeter2d_poly(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = PG_GETARG_GSERIALIZED_P(0);
-	LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
 	double perimeter = 0.0;
 
-	perimeter = lwgeom_perimeter_2d(lwgeom);
+	if (gserialized_measure(geom, GSERIALIZED_PERIMETER_2D, &perimeter) == LW_FAILURE)
+	{
+		LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
+		perimeter = lwgeom_perimeter_2d(lwgeom);
+		lwgeom_free(lwgeom);
+	}
 	PG_FREE_IF_COPY(geom, 0);
 	PG_RETURN_FLOAT8(perimeter);
 }
@@ -734,14 +845,13 @@ Datum ST_Distance(PG_FUNCTION_ARGS)
 	double mindist;
 	GSERIALIZED *geom1 = PG_GETARG_GSERIALIZED_P(0);
 	GSERIALIZED *geom2 = PG_GETARG_GSERIALIZED_P(1);
-	LWGEOM *lwgeom1 = lwgeom_from_gserialized(geom1);
-	LWGEOM *lwgeom2 = lwgeom_from_gserialized(geom2);
 	gserialized_error_if_srid_mismatch(geom1, geom2, __func__);
 
-	mindist = lwgeom_mindistance2d(lwgeom1, lwgeom2);
-
-	lwgeom_free(lwgeom1);
-	lwgeom_free(lwgeom2);
+	/* Scratch geometries go with the arena */
+	lwpg_arena_open();
+	mindist = lwgeom_mindistance2d(lwgeom_from_gserialized(geom1),
+	                               lwgeom_from_gserialized(geom2));
+	lwpg_arena_close();
 
 	PG_FREE_IF_COPY(geom1, 0);
 	PG_FREE_IF_COPY(geom2, 1);
@@ -765,8 +875,6 @@ Datum ST_DWithinUncached(PG_FUNCTION_ARGS)
 	GSERIALIZED *geom1 = PG_GETARG_GSERIALIZED_P(0);
 	GSERIALIZED *geom2 = PG_GETARG_GSERIALIZED_P(1);
 	double tolerance = PG_GETARG_FLOAT8(2);
-	LWGEOM *lwgeom1 = lwgeom_from_gserialized(geom1);
-	LWGEOM *lwgeom2 = lwgeom_from_gserialized(geom2);
 
 	if (tolerance < 0)
 	{
@@ -776,12 +884,17 @@ Datum ST_DWithinUncached(PG_FUNCTION_ARGS)
 
 	gserialized_error_if_srid_mismatch(geom1, geom2, __func__);
 
-	if (lwgeom_is_empty(lwgeom1) || lwgeom_is_empty(lwgeom2))
+	if (gserialized_is_empty(geom1) || gserialized_is_empty(geom2))
 	{
 		PG_RETURN_BOOL(false);
 	}
 
-	mindist = lwgeom_mindistance2d_tolerance(lwgeom1, lwgeom2, tolerance);
+	/* Scratch geometries go with the arena */
+	lwpg_arena_open();
+	mindist = lwgeom_mindistance2d_tolerance(lwgeom_from_gserialized(geom1),
+	                                         lwgeom_from_gserialized(geom2),
+	                                         tolerance);
+	lwpg_arena_close();
 
 	PG_FREE_IF_COPY(geom1, 0);
 	PG_FREE_IF_COPY(geom2, 1);
@@ -799,11 +912,13 @@ Datum LWGEOM_maxdistance2d_linestring(PG_FUNCTION_ARGS)
 	double maxdist;
 	GSERIALIZED *geom1 = PG_GETARG_GSERIALIZED_P(0);
 	GSERIALIZED *geom2 = PG_GETARG_GSERIALIZED_P(1);
-	LWGEOM *lwgeom1 = lwgeom_from_gserialized(geom1);
-	LWGEOM *lwgeom2 = lwgeom_from_gserialized(geom2);
 	gserialized_error_if_srid_mismatch(geom1, geom2, __func__);
 
-	maxdist = lwgeom_maxdistance2d(lwgeom1, lwgeom2);
+	/* Scratch geometries go with the arena */
+	lwpg_arena_open();
+	maxdist = lwgeom_maxdistance2d(lwgeom_from_gserialized(geom1),
+	                               lwgeom_from_gserialized(geom2));
+	lwpg_arena_close();
 
 	PG_FREE_IF_COPY(geom1, 0);
 	PG_FREE_IF_COPY(geom2, 1);
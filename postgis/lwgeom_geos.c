@@ -88,6 +88,8 @@ Datum pgis_union_geometry_array(PG_FUNCTION_ARGS);
 ** Prototypes end
 */
 
+bool partitioned_overlay = false;
+
 PG_FUNCTION_INFO_V1(postgis_geos_version);
 Datum postgis_geos_version(PG_FUNCTION_ARGS)
 {
@@ -1424,7 +1426,10 @@ Datum ST_Intersection(PG_FUNCTION_ARGS)
 	lwgeom1 = lwgeom_from_gserialized(geom1);
 	lwgeom2 = lwgeom_from_gserialized(geom2);
 
-	lwresult = lwgeom_intersection_prec(lwgeom1, lwgeom2, prec);
+	if (partitioned_overlay)
+		lwresult = lwgeom_intersection_partitioned(lwgeom1, lwgeom2, prec);
+	else
+		lwresult = lwgeom_intersection_prec(lwgeom1, lwgeom2, prec);
 	result = geometry_serialize(lwresult);
 
 	lwgeom_free(lwgeom1);
@@ -1454,7 +1459,10 @@ Datum ST_Difference(PG_FUNCTION_ARGS)
 	lwgeom1 = lwgeom_from_gserialized(geom1);
 	lwgeom2 = lwgeom_from_gserialized(geom2);
 
-	lwresult = lwgeom_difference_prec(lwgeom1, lwgeom2, prec);
+	if (partitioned_overlay)
+		lwresult = lwgeom_difference_partitioned(lwgeom1, lwgeom2, prec);
+	else
+		lwresult = lwgeom_difference_prec(lwgeom1, lwgeom2, prec);
 	result = geometry_serialize(lwresult);
 
 	lwgeom_free(lwgeom1);
@@ -47,6 +47,13 @@ Datum LWGEOM_area_polygon(PG_FUNCTION_ARGS);
 Datum LWGEOM_mindistance2d(PG_FUNCTION_ARGS);
 Datum ST_3DDistance(PG_FUNCTION_ARGS);
 
+/*
+ * When set, ST_Intersection and ST_Difference only overlay the parts
+ * of collection inputs whose boxes reach the other input.
+ * Set by the postgis.partitioned_overlay GUC.
+ */
+extern bool partitioned_overlay;
+
 
 /* Return NULL on GEOS error
  *
@@ -28,6 +28,8 @@
 #include <assert.h>
 
 #include "../postgis_config.h"
+#include "funcapi.h"
+#include "access/htup_details.h"
 #include "lwgeom_geos_prepared.h"
 #include "lwgeom_cache.h"
 
@@ -56,6 +58,11 @@
 **  get hooked into a MemoryContext that is in turn used as a
 **  key in the PrepGeomHash.
 **
+**  PrepGeomBackendCache, an optional backend-lifetime array of
+**  prepared geometries keyed on their serialized form, that
+**  PrepGeomCache entries borrow from (with a reference count)
+**  instead of owning their own GEOS objects.
+**
 **  All this is to allow us to clean up external malloc'ed objects
 **  (the GEOS Geometry and PreparedGeometry) before the structure
 **  that references them (PrepGeomCache) is pfree'd by PgSQL. The
@@ -84,6 +91,7 @@ typedef struct
 	MemoryContext context;
 	const GEOSPreparedGeometry* prepared_geom;
 	const GEOSGeometry* geom;
+	int32 backend_slot;
 }
 PrepGeomHashEntry;
 
@@ -94,6 +102,85 @@ static void AddPrepGeomHashEntry(PrepGeomHashEntry pghe);
 static PrepGeomHashEntry *GetPrepGeomHashEntry(MemoryContext mcxt);
 static void DeletePrepGeomHashEntry(MemoryContext mcxt);
 
+/*
+** Backend prepared geometry cache
+**
+** Entries live for the life of the backend (or until evicted),
+** unlike the PrepGeomCache entries that die with their function
+** call context. Keys are the serialized geometry, so any call
+** site that prepares the same geometry can use the entry. Only
+** entries no function context is currently using get evicted.
+*/
+int prepared_geometry_cache_size = 0;
+
+typedef struct
+{
+	const GEOSPreparedGeometry* prepared_geom;
+	const GEOSGeometry* geom;
+}
+PrepGeomBackendValue;
+
+static void
+PrepGeomBackendFree(void *value)
+{
+	PrepGeomBackendValue *pgbv = (PrepGeomBackendValue *)value;
+	GEOSPreparedGeom_destroy(pgbv->prepared_geom);
+	GEOSGeom_destroy((GEOSGeometry *)pgbv->geom);
+	pfree(pgbv);
+}
+
+static BackendCache PrepGeomBackendCache =
+{
+	.name = "PostGIS Prepared Geometry Backend Cache",
+	.size = &prepared_geometry_cache_size,
+	.value_free = PrepGeomBackendFree
+};
+
+/*
+* Find the prepared form of lwgeom in the backend cache, or
+* prepare it and add it to the cache. Returns the slot number
+* (with a reference taken), or -1 if it is not in the cache, in
+* which case *geom and *prepared_geom are a private copy for the
+* caller, or NULL if preparing failed.
+*/
+static int32
+PrepGeomBackendAcquire(const LWGEOM *lwgeom, const GEOSGeometry **geom, const GEOSPreparedGeometry **prepared_geom)
+{
+	PrepGeomBackendValue *pgbv;
+	GSERIALIZED *key;
+	uint32 hash;
+	int32 slot;
+
+	slot = BackendCacheFind(&PrepGeomBackendCache, lwgeom, &key, &hash);
+	if (slot < 0)
+	{
+		*geom = LWGEOM2GEOS(lwgeom, 0);
+		*prepared_geom = *geom ? GEOSPrepare(*geom) : NULL;
+		if (!key)
+			return -1;
+		if (!*prepared_geom)
+		{
+			pfree(key);
+			return -1;
+		}
+
+		pgbv = MemoryContextAlloc(PrepGeomBackendCache.context, sizeof(PrepGeomBackendValue));
+		pgbv->geom = *geom;
+		pgbv->prepared_geom = *prepared_geom;
+		slot = BackendCacheAdd(&PrepGeomBackendCache, key, hash, pgbv);
+		if (slot < 0)
+		{
+			pfree(pgbv);
+			return -1;
+		}
+	}
+
+	pgbv = (PrepGeomBackendValue *)PrepGeomBackendCache.entries[slot].value;
+	PrepGeomBackendCache.entries[slot].refcount++;
+	*geom = pgbv->geom;
+	*prepared_geom = pgbv->prepared_geom;
+	return slot;
+}
 
 static void
 PreparedCacheDelete(void *ptr)
@@ -110,11 +197,18 @@ PreparedCacheDelete(void *ptr)
 
 	POSTGIS_DEBUGF(3, "deleting geom object (%p) and prepared geom object (%p) with MemoryContext key (%p)", pghe->geom, pghe->prepared_geom, context);
 
-	/* Free them */
-	if ( pghe->prepared_geom )
-		GEOSPreparedGeom_destroy( pghe->prepared_geom );
-	if ( pghe->geom )
-		GEOSGeom_destroy( (GEOSGeometry *)pghe->geom );
+	/* Free them, or hand them back to the backend cache */
+	if ( pghe->backend_slot >= 0 )
+	{
+		BackendCacheRelease(&PrepGeomBackendCache, pghe->backend_slot);
+	}
+	else
+	{
+		if ( pghe->prepared_geom )
+			GEOSPreparedGeom_destroy( pghe->prepared_geom );
+		if ( pghe->geom )
+			GEOSGeom_destroy( (GEOSGeometry *)pghe->geom );
+	}
 
 	/* Remove the hash entry as it is no longer needed */
 	DeletePrepGeomHashEntry(context);
@@ -164,6 +258,7 @@ AddPrepGeomHashEntry(PrepGeomHashEntry pghe)
 		he->context = pghe.context;
 		he->geom = pghe.geom;
 		he->prepared_geom = pghe.prepared_geom;
+		he->backend_slot = pghe.backend_slot;
 	}
 	else
 	{
@@ -206,6 +301,7 @@ DeletePrepGeomHashEntry(MemoryContext mcxt)
 
 	he->prepared_geom = NULL;
 	he->geom = NULL;
+	he->backend_slot = -1;
 }
 
 /**
@@ -254,6 +350,7 @@ PrepGeomCacheBuilder(const LWGEOM *lwgeom, GeomCache *cache)
 		pghe.context = prepcache->context_callback;
 		pghe.geom = 0;
 		pghe.prepared_geom = 0;
+		pghe.backend_slot = -1;
 		AddPrepGeomHashEntry( pghe );
 	}
 
@@ -267,9 +364,9 @@ PrepGeomCacheBuilder(const LWGEOM *lwgeom, GeomCache *cache)
 		return LW_FAILURE;
     }
 
-	prepcache->geom = LWGEOM2GEOS( lwgeom , 0);
+	/* Borrow from the backend cache if we can, else prepare our own */
+	prepcache->backend_slot = PrepGeomBackendAcquire(lwgeom, &(prepcache->geom), &(prepcache->prepared_geom));
 	if ( ! prepcache->geom ) return LW_FAILURE;
-	prepcache->prepared_geom = GEOSPrepare( prepcache->geom );
 	if ( ! prepcache->prepared_geom ) return LW_FAILURE;
 	prepcache->gcache.argnum = cache->argnum;
 
@@ -286,6 +383,7 @@ PrepGeomCacheBuilder(const LWGEOM *lwgeom, GeomCache *cache)
 
 	pghe->geom = prepcache->geom;
 	pghe->prepared_geom = prepcache->prepared_geom;
+	pghe->backend_slot = prepcache->backend_slot;
 
 	return LW_SUCCESS;
 }
@@ -321,16 +419,26 @@ PrepGeomCacheCleaner(GeomCache *cache)
 	}
 	pghe->geom = 0;
 	pghe->prepared_geom = 0;
+	pghe->backend_slot = -1;
 
 	/*
-	* Free the GEOS objects and free the index tree
+	* Free the GEOS objects and free the index tree, or just
+	* drop our reference if they belong to the backend cache
 	*/
 	POSTGIS_DEBUGF(3, "PrepGeomCacheFreeer: freeing %p argnum %d", prepcache, prepcache->gcache.argnum);
-	GEOSPreparedGeom_destroy( prepcache->prepared_geom );
-	GEOSGeom_destroy( (GEOSGeometry *)prepcache->geom );
+	if ( prepcache->backend_slot >= 0 )
+	{
+		BackendCacheRelease(&PrepGeomBackendCache, prepcache->backend_slot);
+	}
+	else
+	{
+		GEOSPreparedGeom_destroy( prepcache->prepared_geom );
+		GEOSGeom_destroy( (GEOSGeometry *)prepcache->geom );
+	}
 	prepcache->gcache.argnum = 0;
 	prepcache->prepared_geom = 0;
 	prepcache->geom	= 0;
+	prepcache->backend_slot = -1;
 
 	return LW_SUCCESS;
 }
@@ -341,6 +449,7 @@ PrepGeomCacheAllocator(void)
 	PrepGeomCache* prepcache = palloc(sizeof(PrepGeomCache));
 	memset(prepcache, 0, sizeof(PrepGeomCache));
 	prepcache->context_statement = CurrentMemoryContext;
+	prepcache->backend_slot = -1;
 	prepcache->gcache.type = PREP_CACHE_ENTRY;
 	return (GeomCache*)prepcache;
 }
@@ -371,3 +480,28 @@ GetPrepGeomCache(FunctionCallInfo fcinfo, SHARED_GSERIALIZED *g1, SHARED_GSERIAL
 	return (PrepGeomCache*)GetGeomCache(fcinfo, &PrepGeomCacheMethods, g1, g2);
 }
 
+
+/**
+* Report the hits, misses and current number of entries of
+* the backend prepared geometry cache.
+*/
+PG_FUNCTION_INFO_V1(postgis_prepared_geometry_cache_stats);
+Datum postgis_prepared_geometry_cache_stats(PG_FUNCTION_ARGS)
+{
+	TupleDesc resultTupleDesc;
+	HeapTuple resultTuple;
+	Datum result_values[3];
+	bool result_is_null[3] = {false, false, false};
+	int32 entries = BackendCacheCount(&PrepGeomBackendCache);
+
+	if (get_call_result_type(fcinfo, NULL, &resultTupleDesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "%s: return type must be a row type", __func__);
+	BlessTupleDesc(resultTupleDesc);
+
+	result_values[0] = Int64GetDatum((int64)PrepGeomBackendCache.hits);
+	result_values[1] = Int64GetDatum((int64)PrepGeomBackendCache.misses);
+	result_values[2] = Int32GetDatum(entries);
+
+	resultTuple = heap_form_tuple(resultTupleDesc, result_values, result_is_null);
+	PG_RETURN_DATUM(HeapTupleGetDatum(resultTuple));
+}
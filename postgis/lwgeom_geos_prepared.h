@@ -53,8 +53,18 @@ typedef struct {
 	MemoryContext               context_callback;
 	const GEOSPreparedGeometry* prepared_geom;
 	const GEOSGeometry*         geom;
+	int32                       backend_slot; /* -1 when not from the backend cache */
 } PrepGeomCache;
 
+/*
+ * Prepared geometries can also be kept in a backend-lifetime
+ * cache, keyed on the serialized geometry, so later statements
+ * in the same backend reuse them. The number of entries is set
+ * by the postgis.prepared_geometry_cache_size GUC, zero (the
+ * default) disables it.
+ */
+extern int prepared_geometry_cache_size;
+
 
 /*
  * Get the current cache, given the input geometries.
@@ -132,18 +132,29 @@ Datum LWGEOM_in(PG_FUNCTION_ARGS)
 	if ( str[0] == '0' )
 	{
 		size_t hexsize = strlen(str);
+		size_t ret_size;
 		unsigned char *wkb = bytes_from_hexbytes(str, hexsize);
 		/* TODO: 20101206: No parser checks! This is inline with current 1.5 behavior, but needs discussion */
-		lwgeom = lwgeom_from_wkb(wkb, hexsize/2, LW_PARSER_CHECK_NONE);
-		/* Parser should throw error, but if not, catch here. */
-		if ( !lwgeom ) PG_RETURN_NULL();
-		/* If we picked up an SRID at the head of the WKB set it manually */
-		if ( srid ) lwgeom_set_srid(lwgeom, srid);
-		/* Add a bbox if necessary */
-		if ( lwgeom_needs_bbox(lwgeom) ) lwgeom_add_bbox(lwgeom);
+		/* Bulk loads are mostly simple features, serialize those without an LWGEOM */
+		ret = gserialized_from_wkb(wkb, hexsize/2, LW_PARSER_CHECK_NONE, &ret_size);
+		if ( ret )
+		{
+			SET_VARSIZE(ret, ret_size);
+			if ( srid ) gserialized_set_srid(ret, srid);
+		}
+		else
+		{
+			lwgeom = lwgeom_from_wkb(wkb, hexsize/2, LW_PARSER_CHECK_NONE);
+			/* Parser should throw error, but if not, catch here. */
+			if ( !lwgeom ) PG_RETURN_NULL();
+			/* If we picked up an SRID at the head of the WKB set it manually */
+			if ( srid ) lwgeom_set_srid(lwgeom, srid);
+			/* Add a bbox if necessary */
+			if ( lwgeom_needs_bbox(lwgeom) ) lwgeom_add_bbox(lwgeom);
+			ret = geometry_serialize(lwgeom);
+			lwgeom_free(lwgeom);
+		}
 		lwfree(wkb);
-		ret = geometry_serialize(lwgeom);
-		lwgeom_free(lwgeom);
 	}
 	else if (str[0] == '{')
 	{
@@ -356,6 +367,17 @@ Datum LWGEOMFromEWKB(PG_FUNCTION_ARGS)
 	GSERIALIZED *geom;
 	LWGEOM *lwgeom;
 	uint8_t *wkb = (uint8_t*)VARDATA(bytea_wkb);
+	size_t geom_size;
+
+	geom = gserialized_from_wkb(wkb, VARSIZE_ANY_EXHDR(bytea_wkb), LW_PARSER_CHECK_ALL, &geom_size);
+	if (geom)
+	{
+		SET_VARSIZE(geom, geom_size);
+		if ((PG_NARGS() > 1) && (!PG_ARGISNULL(1)))
+			gserialized_set_srid(geom, PG_GETARG_INT32(1));
+		PG_FREE_IF_COPY(bytea_wkb, 0);
+		PG_RETURN_POINTER(geom);
+	}
 
 	lwgeom = lwgeom_from_wkb(wkb, VARSIZE_ANY_EXHDR(bytea_wkb), LW_PARSER_CHECK_ALL);
 	if (!lwgeom)
@@ -696,27 +718,37 @@ Datum LWGEOM_recv(PG_FUNCTION_ARGS)
 	int32 geom_typmod = -1;
 	GSERIALIZED *geom;
 	LWGEOM *lwgeom;
+	size_t geom_size;
 
 	if ( (PG_NARGS()>2) && (!PG_ARGISNULL(2)) ) {
 		geom_typmod = PG_GETARG_INT32(2);
 	}
 
-	lwgeom = lwgeom_from_wkb((uint8_t*)buf->data, buf->len, LW_PARSER_CHECK_ALL);
-	if ( !lwgeom )
+	/* Binary COPY lands here, serialize simple features without an LWGEOM */
+	geom = gserialized_from_wkb((uint8_t*)buf->data, buf->len, LW_PARSER_CHECK_ALL, &geom_size);
+	if ( geom )
 	{
-		ereport(ERROR,(errmsg("recv error - invalid geometry")));
-		PG_RETURN_NULL();
+		SET_VARSIZE(geom, geom_size);
 	}
+	else
+	{
+		lwgeom = lwgeom_from_wkb((uint8_t*)buf->data, buf->len, LW_PARSER_CHECK_ALL);
+		if ( !lwgeom )
+		{
+			ereport(ERROR,(errmsg("recv error - invalid geometry")));
+			PG_RETURN_NULL();
+		}
 
-	if ( lwgeom_needs_bbox(lwgeom) )
-		lwgeom_add_bbox(lwgeom);
+		if ( lwgeom_needs_bbox(lwgeom) )
+			lwgeom_add_bbox(lwgeom);
+
+		geom = geometry_serialize(lwgeom);
+		lwgeom_free(lwgeom);
+	}
 
 	/* Set cursor to the end of buffer (so the backend is happy) */
 	buf->cursor = buf->len;
 
-	geom = geometry_serialize(lwgeom);
-	lwgeom_free(lwgeom);
-
 	if ( geom_typmod >= 0 )
 	{
 		geom = postgis_valid_typmod(geom, geom_typmod);
@@ -26,6 +26,8 @@
 #include "postgres.h"
 #include "funcapi.h"
 #include "fmgr.h"
+#include "catalog/pg_type.h" /* for BOOLOID */
+#include "utils/array.h"
 
 /* Liblwgeom */
 #include "liblwgeom.h"
@@ -40,6 +42,7 @@
 
 /* Prototypes */
 Datum ST_IntersectsIntervalTree(PG_FUNCTION_ARGS);
+Datum ST_IntersectsPoints(PG_FUNCTION_ARGS);
 
 
 /**********************************************************************
@@ -290,3 +293,92 @@ Datum ST_IntersectsIntervalTree(PG_FUNCTION_ARGS)
 
 	PG_RETURN_BOOL(itree_point_in_multipolygon(itree, lwpt) != ITREE_OUTSIDE);
 }
+
+
+/**********************************************************************
+* ST_IntersectsPoints
+**********************************************************************/
+
+/*
+ * Test a whole array of points against one polygon, returning a
+ * boolean array that says which of them intersect it. The points
+ * are swept through the polygon interval tree as one batch.
+ */
+PG_FUNCTION_INFO_V1(ST_IntersectsPoints);
+Datum ST_IntersectsPoints(PG_FUNCTION_ARGS)
+{
+	SHARED_GSERIALIZED *shared_gpoly = ToastCacheGetGeometry(fcinfo, 0);
+	const GSERIALIZED *gpoly = shared_gserialized_get(shared_gpoly);
+	ArrayType *array = PG_GETARG_ARRAYTYPE_P(1);
+	ArrayType *result;
+	ArrayIterator iterator;
+	IntervalTreeResult *pip_results;
+	POINT2D *pts;
+	Datum *values;
+	bool *nulls;
+	Datum value;
+	bool isnull;
+	int32_t srid = gserialized_get_srid(gpoly);
+	int type = gserialized_get_type(gpoly);
+	int nelems, i = 0;
+	int dims[1], lbs[1] = {1};
+
+	if (type != POLYGONTYPE && type != MULTIPOLYGONTYPE)
+		elog(ERROR, "%s: first argument must be a polygon or multipolygon", __func__);
+
+	nelems = ArrayGetNItems(ARR_NDIM(array), ARR_DIMS(array));
+	if (nelems == 0)
+		PG_RETURN_ARRAYTYPE_P(construct_empty_array(BOOLOID));
+
+	pts = palloc(sizeof(POINT2D) * nelems);
+	values = palloc(sizeof(Datum) * nelems);
+	nulls = palloc(sizeof(bool) * nelems);
+	pip_results = palloc(sizeof(IntervalTreeResult) * nelems);
+
+	/* Read the points, marking nulls and empties as non-finite */
+	iterator = array_create_iterator(array, 0, NULL);
+	while (array_iterate(iterator, &value, &isnull))
+	{
+		POINT4D pt;
+		nulls[i] = isnull;
+		pts[i].x = pts[i].y = NAN;
+
+		if (!isnull)
+		{
+			const GSERIALIZED *gpt = (GSERIALIZED *)DatumGetPointer(value);
+			gserialized_error_if_srid_mismatch_reference(gpt, srid, __func__);
+			if (gserialized_get_type(gpt) != POINTTYPE)
+				elog(ERROR, "%s: second argument must be an array of points", __func__);
+			if (!gserialized_is_empty(gpt) && gserialized_peek_first_point(gpt, &pt) == LW_SUCCESS)
+			{
+				pts[i].x = pt.x;
+				pts[i].y = pt.y;
+			}
+		}
+		i++;
+	}
+	array_free_iterator(iterator);
+
+	if (gserialized_is_empty(gpoly))
+	{
+		for (i = 0; i < nelems; i++)
+			pip_results[i] = ITREE_OUTSIDE;
+	}
+	else
+	{
+		IntervalTree *itree = GetIntervalTree(fcinfo, shared_gpoly);
+		itree_points_in_multipolygon(itree, pts, nelems, pip_results);
+	}
+
+	for (i = 0; i < nelems; i++)
+		values[i] = BoolGetDatum(pip_results[i] != ITREE_OUTSIDE);
+
+	dims[0] = nelems;
+	result = construct_md_array(values, nulls, 1, dims, lbs, BOOLOID, 1, true, 'c');
+
+	pfree(pts);
+	pfree(values);
+	pfree(nulls);
+	pfree(pip_results);
+	PG_RETURN_ARRAYTYPE_P(result);
+}
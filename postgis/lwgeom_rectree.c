@@ -62,7 +62,8 @@ static int
 RectTreeBuilder(const LWGEOM *lwgeom, GeomCache *cache)
 {
 	RectTreeGeomCache *rect_cache = (RectTreeGeomCache*)cache;
-	RECT_NODE *tree = rect_tree_from_lwgeom(lwgeom);
+	/* Cached trees are queried many times, so pack them */
+	RECT_NODE *tree = rect_tree_pack(rect_tree_from_lwgeom(lwgeom));
 
 	if ( rect_cache->index )
 	{
@@ -31,9 +31,12 @@ static void state_append(UnionState *state, const GSERIALIZED *gser);
 static bytea* state_serialize(const UnionState *state);
 static UnionState* state_deserialize(const bytea* serialized);
 static void state_combine(UnionState *state1, UnionState *state2);
+static void state_dissolve(UnionState *state);
 
 static LWGEOM* gserialized_list_union(List* list, float8 gridSize);
 
+bool parallel_union_dissolve = false;
+
 
 PG_FUNCTION_INFO_V1(pgis_geometry_union_parallel_transfn);
 Datum pgis_geometry_union_parallel_transfn(PG_FUNCTION_ARGS)
@@ -122,11 +125,21 @@ Datum pgis_geometry_union_parallel_combinefn(PG_FUNCTION_ARGS)
 PG_FUNCTION_INFO_V1(pgis_geometry_union_parallel_serialfn);
 Datum pgis_geometry_union_parallel_serialfn(PG_FUNCTION_ARGS)
 {
+	MemoryContext aggcontext, old;
 	UnionState *state;
 
-	CheckAggContext();
+	GetAggContext(&aggcontext);
 
 	state = (UnionState*) PG_GETARG_POINTER(0);
+
+	/* Union the partial state here, in the worker */
+	if (parallel_union_dissolve)
+	{
+		old = MemoryContextSwitchTo(aggcontext);
+		state_dissolve(state);
+		MemoryContextSwitchTo(old);
+	}
+
 	PG_RETURN_BYTEA_P(state_serialize(state));
 }
 
@@ -265,6 +278,32 @@ void state_combine(UnionState *state1, UnionState *state2)
 }
 
 
+/*
+ * Replace the list of geometries in the state by their union.
+ */
+void state_dissolve(UnionState *state)
+{
+	LWGEOM *geom;
+	GSERIALIZED *gser;
+
+	if (list_length(state->list) < 2)
+		return;
+
+	geom = gserialized_list_union(state->list, state->gridSize);
+	list_free_deep(state->list);
+	state->list = NIL;
+	state->size = 0;
+
+	if (!geom)
+		return;
+
+	gser = geometry_serialize(geom);
+	lwgeom_free(geom);
+	state->list = list_make1(gser);
+	state->size = VARSIZE(gser);
+}
+
+
 LWGEOM* gserialized_list_union(List* list, float8 gridSize)
 {
 	int ngeoms = 0;
@@ -11,4 +11,12 @@ typedef struct UnionState
 	int32 size; /* total size of GSERIAZLIZED values in list in bytes */
 } UnionState;
 
+/*
+ * When set, the partial states of the parallel union aggregate
+ * are unioned before they leave the worker, so the final step
+ * only has to union the already dissolved partial results.
+ * Set by the postgis.parallel_union_dissolve GUC.
+ */
+extern bool parallel_union_dissolve;
+
 #endif /* _LWGEOM_UNION_H */
@@ -464,6 +464,7 @@ Datum ST_ClusterKMeans(PG_FUNCTION_ARGS)
 		int       i, k, N;
 		bool      isnull, isout;
 		double max_radius = 0.0;
+		uint32_t batch_size = 0;
 		LWGEOM    **geoms;
 		int       *r;
 		Datum argdatum;
@@ -496,6 +497,14 @@ Datum ST_ClusterKMeans(PG_FUNCTION_ARGS)
 				max_radius = 0.0;
 		}
 
+		/* Mini-batch sample size. 0 if not set, for the full algorithm */
+		if (PG_NARGS() > 3)
+		{
+			argdatum = WinGetFuncArgCurrent(winobj, 3, &isnull);
+			if (!isnull && DatumGetInt32(argdatum) > 0)
+				batch_size = DatumGetInt32(argdatum);
+		}
+
 		/* Error out if N < K */
 		if (N<k)
 			lwpgerror("K (%d) must be smaller than the number of rows in the group (%d)", k, N);
@@ -520,7 +529,7 @@ Datum ST_ClusterKMeans(PG_FUNCTION_ARGS)
 		}
 
 		/* Calculate k-means on the list! */
-		r = lwgeom_cluster_kmeans((const LWGEOM **)geoms, N, k, max_radius);
+		r = lwgeom_cluster_kmeans((const LWGEOM **)geoms, N, k, max_radius, batch_size);
 
 		/* Clean up */
 		for (i = 0; i < N; i++)
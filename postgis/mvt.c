@@ -43,7 +43,13 @@
 
 #include "vector_tile.pb-c.h"
 
-#define FEATURES_CAPACITY_INITIAL 50
+/* Initial size of the buffer holding the packed features of the layer */
+#define FEATURES_BUFFER_INITIAL_SIZE 16384
+
+/* Protobuf keys (field number << 3 | length-delimited wire type) */
+#define MVT_TILE_LAYERS_KEY ((3 << 3) | 2)
+#define MVT_LAYER_NAME_KEY ((1 << 3) | 2)
+#define MVT_LAYER_FEATURES_KEY ((2 << 3) | 2)
 
 enum mvt_cmd_id
 {
@@ -105,19 +111,62 @@ static void feature_init(struct feature_builder *builder)
 	builder->geometry = NULL;
 }
 
-static VectorTile__Tile__Feature *feature_build(struct feature_builder *builder)
+static size_t varint_size(uint64_t value)
 {
-	VectorTile__Tile__Feature *feature = palloc(sizeof(*feature));
-	vector_tile__tile__feature__init(feature);
-
-	feature->has_id = builder->has_id;
-	feature->id = builder->id;
-	feature->n_tags = builder->n_tags;
-	feature->tags = builder->tags;
-	feature->type = builder->type;
-	feature->n_geometry = builder->n_geometry;
-	feature->geometry = builder->geometry;
-	return feature;
+	size_t size = 1;
+	while (value >= 0x80)
+	{
+		value >>= 7;
+		size++;
+	}
+	return size;
+}
+
+static size_t varint_pack(uint64_t value, uint8_t *out)
+{
+	size_t i = 0;
+	while (value >= 0x80)
+	{
+		out[i++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	out[i++] = (uint8_t)value;
+	return i;
+}
+
+/**
+ * Pack the feature as a Layer.features field at the end of the buffer,
+ * and release the builder arrays. Only the encoded bytes are kept while
+ * aggregating, so memory grows with the size of the tile and not with
+ * the number of protobuf objects.
+ */
+static void feature_pack(struct feature_builder *builder, StringInfo buf)
+{
+	VectorTile__Tile__Feature feature;
+	uint8_t header[1 + 10];
+	size_t header_size, size;
+
+	vector_tile__tile__feature__init(&feature);
+	feature.has_id = builder->has_id;
+	feature.id = builder->id;
+	feature.n_tags = builder->n_tags;
+	feature.tags = builder->tags;
+	feature.type = builder->type;
+	feature.n_geometry = builder->n_geometry;
+	feature.geometry = builder->geometry;
+
+	size = vector_tile__tile__feature__get_packed_size(&feature);
+	header[0] = MVT_LAYER_FEATURES_KEY;
+	header_size = 1 + varint_pack(size, header + 1);
+	appendBinaryStringInfo(buf, (char *)header, header_size);
+	enlargeStringInfo(buf, size);
+	vector_tile__tile__feature__pack(&feature, (uint8_t *)buf->data + buf->len);
+	buf->len += size;
+	buf->data[buf->len] = '\0';
+
+	pfree(builder->tags);
+	if (builder->geometry)
+		pfree(builder->geometry);
 }
 
 static void feature_add_property(struct feature_builder *builder, uint32_t key_id, uint32_t value_id)
@@ -995,7 +1044,7 @@ void mvt_agg_init_context(mvt_agg_context *ctx)
 		elog(ERROR, "mvt_agg_init_context: extent cannot be 0");
 
 	ctx->tile = NULL;
-	ctx->features_capacity = FEATURES_CAPACITY_INITIAL;
+	ctx->n_features = 0;
 	ctx->keys_hash = NULL;
 	ctx->string_values_hash = NULL;
 	ctx->float_values_hash = NULL;
@@ -1015,18 +1064,19 @@ void mvt_agg_init_context(mvt_agg_context *ctx)
 	layer->version = 2;
 	layer->name = ctx->name;
 	layer->extent = ctx->extent;
-	layer->features = palloc(ctx->features_capacity * sizeof(*layer->features));
 
 	ctx->layer = layer;
+
+	initStringInfo(&ctx->features);
+	enlargeStringInfo(&ctx->features, FEATURES_BUFFER_INITIAL_SIZE);
 }
 
 /**
  * Aggregation step. Parse a row, turn it into a feature, and add it to the layer.
  *
- * Expands features array if needed by a factor of 2.
- * Allocates a new feature, increment feature counter and
- * encode geometry and properties into it.
- */
+ * Encodes geometry and properties into a new feature, and packs
+ * it straight into the features buffer of the context.
+ */
 void mvt_agg_transfn(mvt_agg_context *ctx)
 {
 	bool isnull = false;
@@ -1034,7 +1084,6 @@ void mvt_agg_transfn(mvt_agg_context *ctx)
 	GSERIALIZED *gs;
 	LWGEOM *lwgeom;
 	struct feature_builder feature_builder;
-	VectorTile__Tile__Layer *layer = ctx->layer;
 	POSTGIS_DEBUG(2, "mvt_agg_transfn called");
 
 	/* geom_index is the cached index of the geometry. if missing, it needs to be initialized */
@@ -1056,47 +1105,67 @@ void mvt_agg_transfn(mvt_agg_context *ctx)
 	/* Set the geometry of the feature */
 	encode_feature_geometry(&feature_builder, lwgeom);
 	lwgeom_free(lwgeom);
-	// TODO: free detoasted datum?
+	if ((void *) gs != DatumGetPointer(datum))
+		pfree(gs);
 
 	/* Parse properties */
 	parse_values(ctx, &feature_builder);
 
-	/* Grow the features array of the layer */
-	POSTGIS_DEBUGF(3, "mvt_agg_transfn encoded feature count: %zd", layer->n_features);
-	if (layer->n_features >= ctx->features_capacity)
-	{
-		size_t new_capacity = ctx->features_capacity * 2;
-		layer->features = repalloc(layer->features, new_capacity *
-			sizeof(*layer->features));
-		ctx->features_capacity = new_capacity;
-		POSTGIS_DEBUGF(3, "mvt_agg_transfn new_capacity: %zd", new_capacity);
-	}
-
-	/* Build and add the feature to the layer */
-	layer->features[layer->n_features++] = feature_build(&feature_builder);
+	/* Pack the feature into the layer */
+	feature_pack(&feature_builder, &ctx->features);
+	ctx->n_features++;
+	POSTGIS_DEBUGF(3, "mvt_agg_transfn encoded feature count: %u", ctx->n_features);
 }
 
-static VectorTile__Tile * mvt_ctx_to_tile(mvt_agg_context *ctx)
+/**
+ * Pack the layer being aggregated as a one layer Tile. The layer is
+ * packed without features, and the already packed features are
+ * spliced in right after the name field, which is where protobuf-c
+ * would have written them, so the output is the same as packing a
+ * Tile holding every feature object.
+ */
+static bytea *mvt_layer_to_bytea(mvt_agg_context *ctx)
 {
-	int n_layers = 1;
-	VectorTile__Tile *tile;
+	VectorTile__Tile__Layer *layer = ctx->layer;
+	size_t name_len = strlen(layer->name);
+	size_t split, rest_size, layer_size, len;
+	uint8_t *rest, *out;
+	bytea *ba;
+
 	encode_keys(ctx);
 	encode_values(ctx);
 
-	tile = palloc(sizeof(VectorTile__Tile));
-	vector_tile__tile__init(tile);
-	tile->layers = palloc(sizeof(VectorTile__Tile__Layer*) * n_layers);
-	tile->layers[0] = ctx->layer;
-	tile->n_layers = n_layers;
-	return tile;
+	rest_size = vector_tile__tile__layer__get_packed_size(layer);
+	rest = palloc(rest_size);
+	vector_tile__tile__layer__pack(layer, rest);
+
+	/* Any field order is valid protobuf, but try to match protobuf-c */
+	split = 1 + varint_size(name_len) + name_len;
+	if (split > rest_size || rest[0] != MVT_LAYER_NAME_KEY)
+		split = rest_size;
+
+	layer_size = rest_size + ctx->features.len;
+	len = VARHDRSZ + 1 + varint_size(layer_size) + layer_size;
+	ba = palloc(len);
+	out = (uint8_t *)VARDATA(ba);
+	*out++ = MVT_TILE_LAYERS_KEY;
+	out += varint_pack(layer_size, out);
+	memcpy(out, rest, split);
+	out += split;
+	memcpy(out, ctx->features.data, ctx->features.len);
+	out += ctx->features.len;
+	memcpy(out, rest + split, rest_size - split);
+	SET_VARSIZE(ba, len);
+
+	pfree(rest);
+	return ba;
 }
 
 static bytea *mvt_ctx_to_bytea(mvt_agg_context *ctx)
 {
-	/* Fill out the tile slot, if it's not already filled. */
-	/* We should only have a filled slot when all the work of building */
-	/* out the data is complete, so after a serialize/deserialize cycle */
-	/* or after a context combine */
+	/* The tile slot is only filled after a serialize/deserialize cycle */
+	/* or after a context combine. Before that, the layer is still the */
+	/* one being aggregated, with its features packed in a buffer */
 	size_t len;
 	bytea *ba;
 
@@ -1106,19 +1175,25 @@ static bytea *mvt_ctx_to_bytea(mvt_agg_context *ctx)
 		SET_VARSIZE(ba, VARHDRSZ);
 		return ba;
 	}
-	if (!ctx->tile)
-	{
-		ctx->tile = mvt_ctx_to_tile(ctx);
-	}
 
 	/* Zero features => empty bytea output */
-	if (ctx->layer && ctx->layer->n_features == 0)
+	if (!ctx->tile && ctx->n_features == 0)
 	{
+		/* Rows with NULL geometries still pinned the tupdesc, see encode_values */
+		if (ctx->column_cache.tupdesc)
+		{
+			ReleaseTupleDesc(ctx->column_cache.tupdesc);
+			memset(&ctx->column_cache, 0, sizeof(ctx->column_cache));
+		}
 		ba = palloc(VARHDRSZ);
 		SET_VARSIZE(ba, VARHDRSZ);
 		return ba;
 	}
 
+	/* Still aggregating, the features are packed in the context buffer */
+	if (!ctx->tile)
+		return mvt_layer_to_bytea(ctx);
+
 	/* Serialize the Tile */
 	len = VARHDRSZ + vector_tile__tile__get_packed_size(ctx->tile);
 	ba = palloc(len);
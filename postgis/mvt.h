@@ -36,6 +36,7 @@
 #include "executor/executor.h"
 #include "access/htup_details.h"
 #include "access/htup.h"
+#include "lib/stringinfo.h"
 #include "../postgis_config.h"
 #include "liblwgeom.h"
 #include "lwgeom_pg.h"
@@ -74,8 +75,10 @@ typedef struct mvt_agg_context
 	HeapTupleHeader row;
 	/* The layer which stores all the aggregated features. Aggregation can only yield a single layer. */
 	VectorTile__Tile__Layer *layer;
-	/* The size of the features array in the layer */
-	size_t features_capacity;
+	/* The features of the layer, already packed as protobuf Layer.features fields */
+	StringInfoData features;
+	/* Number of features packed into the features buffer */
+	uint32_t n_features;
 	/* The cached result of the aggregation. It can only be set once the operation is complete. */
 	VectorTile__Tile *tile;
 
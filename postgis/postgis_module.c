@@ -34,6 +34,12 @@
 
 #include "lwgeom_log.h"
 #include "lwgeom_pg.h"
+#include "lwgeom_geos_prepared.h"
+#include "lwgeom_union.h"
+#include "lwgeom_geos.h"
+#include "geography_measurement_trees.h"
+#include "gserialized_estimate_support.h"
+#include "gserialized_partition_join.h"
 #include "geos_c.h"
 
 #ifdef HAVE_LIBPROTOBUF
@@ -136,6 +142,135 @@ _PG_init(void)
 	proj_log_func(NULL, NULL, pjLogFunction);
 #endif
 
+	if ( postgis_guc_find_option("postgis.prepared_geometry_cache_size") )
+	{
+		/* In this narrow case the previously installed GUC is tied to the */
+		/* variable in the previously loaded library. Probably this is */
+		/* happening during an upgrade, so the old library is where it ties to. */
+		elog(WARNING, "'%s' is already set and cannot be changed until you reconnect", "postgis.prepared_geometry_cache_size");
+	}
+	else
+	{
+		DefineCustomIntVariable(
+			"postgis.prepared_geometry_cache_size", /* name */
+			"Number of prepared geometries kept across statements.", /* short_desc */
+			"Prepared geometries are kept for the life of the backend, keyed on their content, so later statements can reuse them. Zero disables the cache.", /* long_desc */
+			&prepared_geometry_cache_size, /* valueAddr */
+			0, /* bootValue */
+			0, /* minValue */
+			BACKEND_CACHE_MAX, /* maxValue */
+			PGC_USERSET, /* GucContext context */
+			0, /* int flags */
+			NULL, /* GucIntCheckHook check_hook */
+			NULL, /* GucIntAssignHook assign_hook */
+			NULL  /* GucShowHook show_hook */
+		);
+	}
+
+	if ( postgis_guc_find_option("postgis.geography_tree_cache_size") )
+	{
+		elog(WARNING, "'%s' is already set and cannot be changed until you reconnect", "postgis.geography_tree_cache_size");
+	}
+	else
+	{
+		DefineCustomIntVariable(
+			"postgis.geography_tree_cache_size", /* name */
+			"Number of geography distance trees kept across statements.", /* short_desc */
+			"Circle trees built for geography distance functions are kept packed for the life of the backend, keyed on the geography, so later statements can reuse them. Zero disables the cache.", /* long_desc */
+			&geography_tree_cache_size, /* valueAddr */
+			0, /* bootValue */
+			0, /* minValue */
+			BACKEND_CACHE_MAX, /* maxValue */
+			PGC_USERSET, /* GucContext context */
+			0, /* int flags */
+			NULL, /* GucIntCheckHook check_hook */
+			NULL, /* GucIntAssignHook assign_hook */
+			NULL  /* GucShowHook show_hook */
+		);
+	}
+
+	if ( postgis_guc_find_option("postgis.parallel_union_dissolve") )
+	{
+		elog(WARNING, "'%s' is already set and cannot be changed until you reconnect", "postgis.parallel_union_dissolve");
+	}
+	else
+	{
+		DefineCustomBoolVariable(
+			"postgis.parallel_union_dissolve", /* name */
+			"Union the partial results of parallel ST_Union in the workers.", /* short_desc */
+			"Each parallel worker unions the geometries it collected before passing them on, so the final union only merges the dissolved partial results.", /* long_desc */
+			&parallel_union_dissolve, /* valueAddr */
+			false, /* bootValue */
+			PGC_USERSET, /* GucContext context */
+			0, /* int flags */
+			NULL, /* GucBoolCheckHook check_hook */
+			NULL, /* GucBoolAssignHook assign_hook */
+			NULL  /* GucShowHook show_hook */
+		);
+	}
+
+	if ( postgis_guc_find_option("postgis.partitioned_overlay") )
+	{
+		elog(WARNING, "'%s' is already set and cannot be changed until you reconnect", "postgis.partitioned_overlay");
+	}
+	else
+	{
+		DefineCustomBoolVariable(
+			"postgis.partitioned_overlay", /* name */
+			"Overlay only the parts of collections near the other input.", /* short_desc */
+			"ST_Intersection and ST_Difference hand GEOS only the parts of multi-geometries whose boxes overlap the other input. Parts of a multipolygon away from the subtracted geometry are copied to the ST_Difference result unchanged.", /* long_desc */
+			&partitioned_overlay, /* valueAddr */
+			false, /* bootValue */
+			PGC_USERSET, /* GucContext context */
+			0, /* int flags */
+			NULL, /* GucBoolCheckHook check_hook */
+			NULL, /* GucBoolAssignHook assign_hook */
+			NULL  /* GucShowHook show_hook */
+		);
+	}
+
+	if ( postgis_guc_find_option("postgis.adaptive_histogram") )
+	{
+		elog(WARNING, "'%s' is already set and cannot be changed until you reconnect", "postgis.adaptive_histogram");
+	}
+	else
+	{
+		DefineCustomBoolVariable(
+			"postgis.adaptive_histogram", /* name */
+			"Build adaptive spatial histograms in ANALYZE.", /* short_desc */
+			"ANALYZE splits the spatial histogram recursively where the sample is dense instead of laying a uniform grid over it, so skewed data gets the same cell budget spent where the features are.", /* long_desc */
+			&adaptive_histogram, /* valueAddr */
+			false, /* bootValue */
+			PGC_USERSET, /* GucContext context */
+			0, /* int flags */
+			NULL, /* GucBoolCheckHook check_hook */
+			NULL, /* GucBoolAssignHook assign_hook */
+			NULL  /* GucShowHook show_hook */
+		);
+	}
+
+	if ( postgis_guc_find_option("postgis.partition_join") )
+	{
+		elog(WARNING, "'%s' is already set and cannot be changed until you reconnect", "postgis.partition_join");
+	}
+	else
+	{
+		DefineCustomBoolVariable(
+			"postgis.partition_join", /* name */
+			"Allow grid partitioned joins on ST_Intersects, ST_DWithin and &&.", /* short_desc */
+			"Lets the planner join two geometry inputs by laying their boxes out on a grid and sweeping each cell for overlapping pairs, instead of checking the join predicate on every pair of rows when no index can be used.", /* long_desc */
+			&partition_join, /* valueAddr */
+			false, /* bootValue */
+			PGC_USERSET, /* GucContext context */
+			0, /* int flags */
+			NULL, /* GucBoolCheckHook check_hook */
+			NULL, /* GucBoolAssignHook assign_hook */
+			NULL  /* GucShowHook show_hook */
+		);
+	}
+
+	/* Offer the grid partitioned join to the planner */
+	partition_join_init();
 }
 
 /*
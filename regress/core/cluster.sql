@@ -84,3 +84,7 @@ from (values (null::geometry), ('POINT(1 1)'), ('POINT EMPTY'), ('POINT(0 0)'),
 
 select 'weight-and-limit-support-1', count(distinct cid) from (select ST_ClusterKMeans(ST_Force2D(geom), 1, 1) over () as cid from (values ('POINT(0 0 0 1)'::geometry), ('POINT(1 0 0 1)'), ('POINT(2 0 0 10000)')) g(geom)) kmeans;
 select 'weight-and-limit-support-2', count(distinct cid) from (select ST_ClusterKMeans(geom, 1, 1) over () as cid from (values ('POINT(0 0 0 1)'::geometry), ('POINT(1 0 0 1)'), ('POINT(2 0 0 10000)')) g(geom)) kmeans;
+
+-- mini-batch mode still separates well separated groups
+select 'minibatch-1', count(distinct cid), count(distinct (blob, cid)) from (select blob, ST_ClusterKMeans(ST_Point(100 * blob + i * 0.001, 0), 4, null, 50) over () as cid from generate_series(0, 3) blob, generate_series(1, 500) i) kmeans;
+select 'minibatch-2', count(distinct cid), count(distinct (blob, cid)) from (select blob, ST_ClusterKMeans(ST_Point(100 * blob + i * 0.001, 0), 1, 10, 50) over () as cid from generate_series(0, 3) blob, generate_series(1, 500) i) kmeans;
@@ -165,3 +165,13 @@ SELECT 'ticket_6076_perimeter', round(ST_Perimeter(ST_GeogFromText('GEOMETRYCOLL
 --SELECT 'lrs_cp_2', ST_AsText(ST_ClosestPoint(geography 'Point(25 20)', geography 'Linestring(0 20, 50 20)'), 3);
 
 SELECT 'lrs_sl_1', ST_AsText(ST_ShortestLine(geography 'linestring(0 40, 50 40)', 'Point(25 40)', true), 2);
+
+-- Backend circle tree cache, reused by a second statement
+SET postgis.geography_tree_cache_size = 4;
+SELECT 'treecache1', ST_DWithin('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0))'::geography, p::geography, 1000), ST_Distance('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0))'::geography, p::geography) = 0 FROM ( VALUES
+('POINT(5 5)'),('POINT(5 5)'),('POINT(50 50)')
+) AS v(p);
+SELECT 'treecache2', ST_DWithin('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0))'::geography, p::geography, 1000), ST_Distance('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0))'::geography, p::geography) = 0 FROM ( VALUES
+('POINT(5 5)'),('POINT(5 5)'),('POINT(50 50)')
+) AS v(p);
+RESET postgis.geography_tree_cache_size;
@@ -48,3 +48,32 @@ SELECT 'geog_covers_donut', ST_Covers(
 	ST_BUFFER('Point(0 0)'::geography, 50000),
 	'Polygon((0.1 0.2, 0.1 0.3, 0.2 0.3, 0.2 0.2, 0.1 0.2), (0.15 0.22, 0.15 0.25, 0.18 0.25, 0.18 0.22, 0.15 0.22))'::geography
 	);
+
+-- repeated region, answered from the cached tree
+SELECT c, ST_Covers(p::geography, g::geography), ST_CoveredBy(g::geography, p::geography) FROM
+( VALUES
+    ('geog_covers_cached_in', 'POINT (2 2)'),
+    ('geog_covers_cached_hole', 'POINT (5 5)'),
+    ('geog_covers_cached_out', 'POINT (20 20)'),
+    ('geog_covers_cached_corner', 'POINT (9 9)'),
+    ('geog_covers_cached_edge_side', 'POINT (5 1)')
+) AS u(c, g),
+( VALUES ('POLYGON((0 0, 10 0, 10 10, 0 10, 0 0),(4 4, 6 4, 6 6, 4 6, 4 4))') ) AS v(p)
+ORDER BY c;
+
+SELECT c, ST_Covers(p::geography, g::geography) FROM
+( VALUES
+    ('geog_covers_cached_multi_1', 'POINT (5 5)'),
+    ('geog_covers_cached_multi_2', 'POINT (25 5)'),
+    ('geog_covers_cached_multi_gap', 'POINT (15 5)'),
+    ('geog_covers_cached_multi_out', 'POINT (50 50)')
+) AS u(c, g),
+( VALUES ('MULTIPOLYGON(((0 0, 10 0, 10 10, 0 10, 0 0)),((20 0, 30 0, 30 10, 20 10, 20 0)))') ) AS v(p)
+ORDER BY c;
+
+-- many points inside the repeated region, answered from the cached tree
+SELECT 'geog_covers_cached_grid',
+	count(*) FILTER (WHERE ST_Covers(p::geography, ST_Point(x + 0.5, y + 0.5)::geography)),
+	count(*) FILTER (WHERE ST_CoveredBy(ST_Point(x + 0.5, y + 0.5)::geography, p::geography))
+FROM generate_series(-1, 10) x, generate_series(-1, 10) y,
+( VALUES ('POLYGON((0 0, 10 0, 10 10, 0 10, 0 0),(4 4, 6 4, 6 6, 4 6, 4 4))') ) AS v(p);
@@ -101,6 +101,16 @@ FROM knn_recheck_geog As a
 	WHERE a.gid IN(500000,500010,1000)
 ORDER BY a.gid;
 
+-- cached distances match the uncached call exactly, in both argument orders
+CREATE FUNCTION knn_recheck_uncached(a geography, b geography) RETURNS float8 AS
+$$ DECLARE d float8; BEGIN EXECUTE 'SELECT $1 <-> $2' INTO d USING a, b; RETURN d; END $$ LANGUAGE plpgsql;
+SELECT '#4g' As t,
+	count(*) FILTER (WHERE q <-> geog <> knn_recheck_uncached(q, geog)) As cached_first,
+	count(*) FILTER (WHERE geog <-> q <> knn_recheck_uncached(geog, q)) As cached_second
+FROM knn_recheck_geog, (VALUES ('POINT(-95.3 -10.7)'::geography)) AS v(q)
+WHERE gid % 97 = 0 OR gid >= 500000;
+DROP FUNCTION knn_recheck_uncached(geography, geography);
+
 
 -- create index and repeat
 CREATE INDEX idx_knn_recheck_geog_gist ON knn_recheck_geog USING gist(geog);
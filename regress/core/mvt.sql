@@ -508,6 +508,12 @@ FROM (
 	SELECT NULL::integer AS c1, NULL::geometry AS geom
 	WHERE false
 ) AS q;
+-- Features packed well past the initial size of the features buffer
+SELECT 'TA10_many', length(ST_AsMVT(q))
+FROM (
+	SELECT ST_Point(i % 4096, i % 4096) AS geom
+	FROM generate_series(0, 9999) AS i
+) AS q;
 
 -- Strings and text
 SELECT 'TA11', encode(ST_AsMVT(q, 'test', 4096, 'geom'), 'base64') FROM (
@@ -0,0 +1,68 @@
+-- Grid partitioned spatial joins return the same rows as nested loops
+create table pj_a as
+  select i as id, st_buffer(st_makepoint(i % 20, i / 20), 0.4 + (i % 3) * 0.3) as g
+  from generate_series(0, 399) i;
+create table pj_b as
+  select i as id, st_makepoint((i * 7) % 23 + 0.25, (i * 11) % 19 + 0.5) as g
+  from generate_series(0, 299) i;
+insert into pj_a values (1000, null), (1001, 'POLYGON EMPTY'), (1002, 'LINESTRING(-5 -5, 30 30)');
+insert into pj_b values (1000, null), (1001, 'POINT EMPTY'), (1002, 'LINESTRING(0 18, 19 0)');
+analyze pj_a;
+analyze pj_b;
+
+create function pj_plan(q text) returns boolean language plpgsql as $$
+declare
+  plan json;
+begin
+  execute 'explain (format json) ' || q into plan;
+  return plan::text like '%SpatialPartitionJoin%';
+end
+$$;
+
+create table pj_expected as
+  select 'intersects' as q, count(*) as n, sum(a.id * 1000 + b.id) as s
+    from pj_a a join pj_b b on st_intersects(a.g, b.g)
+  union all
+  select 'dwithin', count(*), sum(a.id * 1000 + b.id)
+    from pj_a a join pj_b b on st_dwithin(a.g, b.g, 1.5)
+  union all
+  select 'overlaps', count(*), sum(a.id * 1000 + b.id)
+    from pj_a a join pj_b b on a.g && b.g;
+
+set postgis.partition_join = on;
+set enable_nestloop = off;
+set enable_hashjoin = off;
+set enable_mergejoin = off;
+
+select 'plan_00', pj_plan('select * from pj_a a join pj_b b on st_intersects(a.g, b.g)');
+select 'plan_01', pj_plan('select * from pj_a a join pj_b b on st_dwithin(b.g, a.g, 1.5)');
+select 'plan_02', pj_plan('select * from pj_a a join pj_b b on a.g && b.g and a.id < b.id');
+
+select 'join_00', n = (select n from pj_expected where q = 'intersects'), s = (select s from pj_expected where q = 'intersects')
+  from (select count(*) as n, sum(a.id * 1000 + b.id) as s from pj_a a join pj_b b on st_intersects(a.g, b.g)) j;
+select 'join_01', n = (select n from pj_expected where q = 'dwithin'), s = (select s from pj_expected where q = 'dwithin')
+  from (select count(*) as n, sum(a.id * 1000 + b.id) as s from pj_a a join pj_b b on st_dwithin(a.g, b.g, 1.5)) j;
+select 'join_02', n = (select n from pj_expected where q = 'overlaps'), s = (select s from pj_expected where q = 'overlaps')
+  from (select count(*) as n, sum(a.id * 1000 + b.id) as s from pj_a a join pj_b b on a.g && b.g) j;
+select 'join_03', count(*) from pj_a a join pj_b b on st_intersects(a.g, b.g) where a.g is null or st_isempty(b.g);
+
+-- Inputs beyond hash_mem are spilled and joined band by band
+set work_mem = '64kB';
+set hash_mem_multiplier = 1;
+select 'spill_00', pj_plan('select * from pj_a a join pj_b b on st_intersects(a.g, b.g)');
+select 'spill_01', n = (select n from pj_expected where q = 'intersects'), s = (select s from pj_expected where q = 'intersects')
+  from (select count(*) as n, sum(a.id * 1000 + b.id) as s from pj_a a join pj_b b on st_intersects(a.g, b.g)) j;
+select 'spill_02', n = (select n from pj_expected where q = 'dwithin'), s = (select s from pj_expected where q = 'dwithin')
+  from (select count(*) as n, sum(a.id * 1000 + b.id) as s from pj_a a join pj_b b on st_dwithin(a.g, b.g, 1.5)) j;
+reset hash_mem_multiplier;
+reset work_mem;
+
+reset enable_mergejoin;
+reset enable_hashjoin;
+reset enable_nestloop;
+reset postgis.partition_join;
+
+drop table pj_expected;
+drop function pj_plan(text);
+drop table pj_a;
+drop table pj_b;
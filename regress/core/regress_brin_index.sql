@@ -96,6 +96,32 @@ SELECT 'scan_idx', qnodes('select * from test where the_geom &&& ST_MakePoint(0,
 
 DROP INDEX brin_4d;
 
+-- 2D multi-box
+CREATE INDEX brin_2d_multi on test using brin (the_geom brin_geometry_inclusion_multi_ops_2d (boxes_per_range = 4));
+
+set enable_indexscan = off;
+set enable_bitmapscan = on;
+set enable_seqscan = off;
+
+SELECT 'scan_idx', qnodes('select * from test where the_geom && ST_MakePoint(0,0)');
+ select num,ST_astext(the_geom) from test where the_geom && 'BOX(125 125,135 135)'::box2d order by num;
+
+SELECT 'scan_idx', qnodes('select * from test where ST_MakePoint(0,0) ~ the_geom');
+ select num,ST_astext(the_geom) from test where 'BOX(125 125,135 135)'::box2d ~ the_geom order by num;
+
+SELECT 'scan_idx', qnodes('select * from test where the_geom @ ST_MakePoint(0,0)');
+ select num,ST_astext(the_geom) from test where the_geom @ 'BOX(125 125,135 135)'::box2d order by num;
+
+DROP INDEX brin_2d_multi;
+
+-- 3D multi-box
+CREATE INDEX brin_3d_multi on test using brin (the_geom brin_geometry_inclusion_multi_ops_3d);
+
+SELECT 'scan_idx', qnodes('select * from test where the_geom &&& ST_MakePoint(0,0)');
+ select num,ST_astext(the_geom) from test where the_geom &&& 'BOX3D(125 125,135 135)'::box3d order by num;
+
+DROP INDEX brin_3d_multi;
+
 -- test adding rows and unsummarized ranges
 --
 
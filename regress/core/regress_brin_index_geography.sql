@@ -64,6 +64,17 @@ SELECT '#4608-2', count(*) FROM test where ST_CoveredBy(the_geog, ST_GeogFromTex
 
 DROP INDEX brin_geog;
 
+-- 2D multi-box
+CREATE INDEX brin_geog_multi on test using brin (the_geog brin_geography_inclusion_multi_ops) WITH (pages_per_range = 10);
+
+SELECT 'scan_idx', qnodes('select * from test where the_geog && ST_GeographyFromText(''SRID=4326;POLYGON((43. 42.,43. 43.,42. 43.,42. 42.,43. 42.))'')');
+ select num,ST_astext(the_geog) from test where the_geog && ST_GeographyFromText('SRID=4326;POLYGON((43. 42.,43. 43.,42. 43.,42. 42.,43. 42.))') order by num;
+
+SELECT 'scan_idx', qnodes('SELECT * FROM test WHERE the_geog IS NULL');
+ SELECT COUNT(num) FROM test WHERE the_geog IS NULL;
+
+DROP INDEX brin_geog_multi;
+
 -- #5564
 SET max_parallel_workers TO 2;
 CREATE TABLE random_points AS
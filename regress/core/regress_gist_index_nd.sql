@@ -81,6 +81,33 @@ where op = '~~=';
 
 select * from test_gist_idx_nd;
 
+-------------------------------------------------------------------------------
+-- Geography keys are 3D geocentric boxes, sorted along a space filling
+-- curve when the index is bulk built
+
+create table tbl_geog_nd as
+select i as k, ST_Buffer(ST_Point((i * 37) % 360 - 180, (i * 53) % 170 - 85)::geography, 200000) as g
+from generate_series(1, 2000) as i;
+
+set enable_indexscan = off;
+set enable_bitmapscan = off;
+set enable_seqscan = on;
+
+create temp table test_gist_idx_geog as
+select count(*) as noidx from tbl_geog_nd t1, tbl_geog_nd t2 where t1.g && t2.g;
+
+create index tbl_geog_nd_gist_idx on tbl_geog_nd using gist(g);
+
+set enable_indexscan = on;
+set enable_seqscan = off;
+
+select 'geog_nd', noidx = ( select count(*) from tbl_geog_nd t1, tbl_geog_nd t2 where t1.g && t2.g ),
+qnodes(' select count(*) from tbl_geog_nd t1, tbl_geog_nd t2 where t1.g && t2.g ')
+from test_gist_idx_geog;
+
+DROP TABLE tbl_geog_nd CASCADE;
+DROP TABLE test_gist_idx_geog;
+
 -------------------------------------------------------------------------------
 
 DROP TABLE tbl_geomcollection_nd CASCADE;
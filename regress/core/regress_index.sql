@@ -69,6 +69,15 @@ SELECT 'scan_seq', qnodes('select * from test where the_geom && ST_MakePoint(0,0
 SELECT 'gist 2d @ idx', qnodes('select * from test_gist_idx_2d where geom @ ST_MakeEnvelope(120,120,140,140)'), count(*) FROM test_gist_idx_2d WHERE geom @ ST_MakeEnvelope(120,120,140,140);
 SELECT 'gist 2d ~ idx', qnodes('select * from test_gist_idx_2d where geom ~ ST_MakePoint(125,125)'), count(*) FROM test_gist_idx_2d WHERE geom ~ ST_MakePoint(125,125);
 
+-- R*-tree node split strategy
+DROP INDEX quick_gist;
+CREATE INDEX quick_gist_rstar on test using gist (the_geom gist_geometry_ops_2d (split = 'rstar'));
+SELECT 'scan_rstar', qnodes('select * from test where the_geom && ST_MakePoint(0,0)');
+SELECT 'rstar &&', count(*) FROM test WHERE the_geom && 'BOX3D(125 125,135 135)'::box3d;
+SELECT 'rstar &&', count(*) FROM test WHERE the_geom && ST_MakeEnvelope(0,0,500,500);
+DROP INDEX quick_gist_rstar;
+CREATE INDEX quick_gist on test using gist (the_geom);
+
 CREATE FUNCTION estimate_error(qry text, tol int)
 RETURNS text
 LANGUAGE 'plpgsql' VOLATILE AS $$
@@ -273,3 +273,16 @@ select 'ST_SetEndM5', ST_AsText(ST_SetEndM('LINESTRING M EMPTY'::geometry, 999))
 select 'ST_SetEndM6', ST_AsText(ST_SetEndM('NURBSCURVE(2, (0 0, 1 1, 2 0))'::geometry, 999));
 select 'ST_SetEndM7', ST_AsText(ST_SetEndM('COMPOUNDCURVE M EMPTY'::geometry, 999));
 select 'ST_SetEndM8', ST_AsText(ST_SetEndM('POINT(1 2)'::geometry, 9));
+
+-- ST_IntersectsPoints
+select 'ST_IntersectsPoints1', ST_IntersectsPoints('POLYGON((0 0,10 0,10 10,0 10,0 0),(2 2,2 4,4 4,4 2,2 2))'::geometry,
+  ARRAY['POINT(5 5)'::geometry, 'POINT(3 3)', 'POINT(10 5)', 'POINT(3 4)', 'POINT(20 20)', 'POINT EMPTY', NULL]);
+with poly as (
+  select 'MULTIPOLYGON(((0 0,10 0,10 10,0 10,0 0),(2 2,2 8,8 8,8 2,2 2)),((4 4,6 4,5 6,4 4)))'::geometry as g
+), pts as (
+  select array_agg(ST_MakePoint(x * 0.5, y * 0.5)) as arr from generate_series(-2, 22) as x, generate_series(-2, 22) as y
+)
+select 'ST_IntersectsPoints2', count(*), bool_and(b = ST_Intersects(poly.g, p))
+from poly, pts, unnest(pts.arr, ST_IntersectsPoints(poly.g, pts.arr)) as u(p, b);
+select 'ST_IntersectsPoints3', ST_IntersectsPoints('POLYGON EMPTY'::geometry, ARRAY['POINT(0 0)'::geometry]);
+select 'ST_IntersectsPoints4', ST_IntersectsPoints('POLYGON((0 0,1 0,1 1,0 0))'::geometry, ARRAY['LINESTRING(0 0,1 1)'::geometry]);
@@ -292,3 +292,14 @@ SELECT 'covers311', ST_Covers('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0))', p) FROM
 ('LINESTRING(1 10, 10 10, 10 8)'),('LINESTRING(1 10, 10 10, 10 8)'),('LINESTRING(1 10, 10 10, 10 8)')
 ) AS v(p);
 
+
+-- Backend prepared geometry cache, reused by a second statement
+SET postgis.prepared_geometry_cache_size = 4;
+SELECT 'backendcache1', ST_Contains('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0))', p) FROM ( VALUES
+('LINESTRING(1 1, 2 2)'),('LINESTRING(1 1, 2 2)'),('LINESTRING(1 1, 2 2)')
+) AS v(p);
+SELECT 'backendcache2', ST_Contains('POLYGON((0 0, 0 10, 10 10, 10 0, 0 0))', p) FROM ( VALUES
+('LINESTRING(1 1, 2 2)'),('LINESTRING(1 1, 2 2)'),('LINESTRING(1 1, 2 2)')
+) AS v(p);
+SELECT 'backendcache3', hits, misses, entries FROM postgis_prepared_geometry_cache_stats();
+RESET postgis.prepared_geometry_cache_size;
@@ -39,4 +39,14 @@ SELECT 12, ST_AsEWKT(ST_Transform(
            ST_GeomFromEWKT('SRID=100002;POINT(16 48)'),
            'invalid projection'));
 
+--- test #13: multi-part geometries are transformed as a whole like part by part
+WITH g AS (SELECT ST_GeomFromEWKT(w) AS geom FROM (VALUES
+	('SRID=100002;MULTIPOLYGON(((16 48,17 48,17 49,16 48),(16.2 48.1,16.5 48.1,16.5 48.4,16.2 48.1)),((15 47,15.5 47,15.5 47.5,15 47)))'),
+	('SRID=100002;GEOMETRYCOLLECTION(POINT Z(16 48 100),LINESTRING Z(15 47 10,16 48 20))')
+	) AS v(w))
+SELECT 13, ST_OrderingEquals(
+	ST_Transform(geom, 100001),
+	(SELECT ST_Collect(ST_Transform((d).geom, 100001) ORDER BY (d).path) FROM ST_Dump(geom) AS d)
+	) FROM g;
+
 DELETE FROM spatial_ref_sys WHERE srid in (100001, 100002);
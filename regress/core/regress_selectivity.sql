@@ -2199,6 +2199,37 @@ select 'selectivity_09', 'estimated', _postgis_selectivity('regular_overdots','g
 select 'selectivity_10', 'actual', 1;
 select 'selectivity_09', 'estimated', _postgis_selectivity('regular_overdots','g','LINESTRING(0 0, 12 12)');
 
+-- Adaptive histogram
+set postgis.adaptive_histogram = on;
+analyze regular_overdots;
+select 'adaptive_00', (_postgis_stats('regular_overdots','g')::json->>'nodes')::integer > 1;
+select 'adaptive_01', abs(_postgis_selectivity('regular_overdots','g','LINESTRING(0 0, 11 3.5)') - 1068.0/2127.0) < 0.1;
+select 'adaptive_02', _postgis_selectivity('regular_overdots','g','LINESTRING(11 11, 12 12)');
+select 'adaptive_03', _postgis_selectivity('regular_overdots','g','LINESTRING(0 0, 12 12)');
+select 'adaptive_04', _postgis_join_selectivity('regular_overdots', 'g', 'regular_overdots', 'g') between 0 and 1;
+reset postgis.adaptive_histogram;
+
+-- Join selectivity of ST_DWithin grows with the radius
+create table dwithin_south as
+  select st_makepoint(x, x % 5) as g from generate_series(1, 100) x;
+create table dwithin_north as
+  select st_makepoint(x + 0.5, 50 + x % 5) as g from generate_series(1, 100) x;
+analyze dwithin_south;
+analyze dwithin_north;
+create function dwithin_rows(radius float8) returns float8 language plpgsql as $$
+declare
+  plan json;
+begin
+  execute format('explain (format json) select * from dwithin_south s join dwithin_north n on st_dwithin(s.g, n.g, %s)', radius) into plan;
+  return (plan->0->'Plan'->>'Plan Rows')::float8;
+end
+$$;
+select 'dwithin_00', dwithin_rows(0.001) < 10;
+select 'dwithin_01', dwithin_rows(100) > 1000;
+drop function dwithin_rows(float8);
+drop table dwithin_south;
+drop table dwithin_north;
+
 -- Clean
 drop table if exists regular_overdots;
 drop table if exists regular_overdots_ab;
@@ -83,6 +83,33 @@ select * from test_spgist_idx_3d;
 
 -------------------------------------------------------------------------------
 
+-- KNN ordering through the index must match the sequential sort
+set enable_indexscan = off;
+set enable_seqscan = on;
+
+create temp table knn_seq as
+select array_agg(d) as d from (
+	select g <<->> 'POINT(50 50 50)'::geometry as d from tbl_geomcollection
+	order by g <<->> 'POINT(50 50 50)'::geometry limit 20 ) foo;
+
+set enable_indexscan = on;
+set enable_seqscan = off;
+
+select '<<->>',
+	qnodes('select k from tbl_geomcollection order by g <<->> ''POINT(50 50 50)''::geometry limit 20'),
+	( select array_agg(d) from (
+		select g <<->> 'POINT(50 50 50)'::geometry as d from tbl_geomcollection
+		order by g <<->> 'POINT(50 50 50)'::geometry limit 20 ) foo ) = ( select d from knn_seq );
+
+-- An EMPTY ORDER BY argument must not raise
+select '<<->> empty', count(*) from (
+	select k from tbl_geomcollection
+	order by g <<->> 'POINT EMPTY'::geometry limit 5 ) foo;
+
+drop table knn_seq;
+
+-------------------------------------------------------------------------------
+
 DROP TABLE tbl_geomcollection CASCADE;
 DROP TABLE test_spgist_idx_3d CASCADE;
 DROP FUNCTION qnodes;
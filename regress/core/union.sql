@@ -85,6 +85,34 @@ INSERT INTO geoms SELECT ST_GeomFromText('POLYGON EMPTY') AS geom;
 SELECT ST_AsText(ST_Union(geom)) FROM geoms;
 
 
+-- Test in parallel mode with partial states dissolved in the workers
+
+SET postgis.parallel_union_dissolve = on;
+
+TRUNCATE TABLE geoms;
+
+WITH coords AS (SELECT * FROM generate_series(0, 19) AS x, generate_series(0, 19) AS y)
+INSERT INTO geoms
+SELECT ST_Square(1.0, x, y, ST_MakePoint(0, 0))
+FROM coords;
+
+WITH u AS (SELECT ST_Union(geom) AS g FROM geoms)
+SELECT ST_Area(g), ST_XMin((g)), ST_YMin(g), ST_XMax(g), ST_YMax(g), ST_NumGeometries(g) from u;
+
+WITH u AS (SELECT ST_Union(geom, -1.0) AS g FROM geoms)
+SELECT ST_Area(g), ST_XMin((g)), sT_YMin(g), ST_XMax(g), ST_YMax(g), ST_NumGeometries(g) from u;
+
+TRUNCATE TABLE geoms;
+
+INSERT INTO geoms (geom) VALUES (NULL), (NULL), (NULL), (NULL), (NULL);
+SELECT ST_Union(geom) IS NULL FROM geoms;
+
+INSERT INTO geoms SELECT ST_GeomFromText('POLYGON EMPTY') AS geom;
+SELECT ST_AsText(ST_Union(geom)) FROM geoms;
+
+RESET postgis.parallel_union_dissolve;
+
+
 DROP TABLE geoms;
 
 DROP PROCEDURE IF EXISTS p_force_parellel_mode(text);
@@ -63,6 +63,7 @@ SELECT
 
 -- Add view using ST_ClusterKMeans windowing function
 -- NOTE: 3.2.0 changed it to add max_radius parameter
+-- NOTE: 3.7.0 changed it to add batch_size parameter
 CREATE VIEW upgrade_view_test_clusterkmeans AS
 SELECT
 	ST_ClusterKMeans(g1, 1) OVER ()
@@ -0,0 +1,139 @@
+#!/bin/sh
+#
+# Compare the node split strategies of the 2D GiST index on a table.
+#
+# For each strategy an index is built on the given geometry column, and a
+# fixed sample of && queries is run against it, half of them centered on
+# rows of the table and half spread uniformly over its extent. The index
+# pages each query reads are taken from EXPLAIN (ANALYZE, BUFFERS).
+#
+# The table must be in the search_path, and should have no other index on
+# the column, which the planner could pick instead.
+# Connection parameters are taken from the usual PG* environment variables.
+#
+
+usage() {
+  echo "Usage: $0 [-n <queries>] [-s <size>] <table> <column>"
+  echo "Options:"
+  echo "\t-n <queries>  Number of queries to run per strategy (default 1000)"
+  echo "\t-s <size>     Half width of the query boxes (default 1/100 of the table extent)"
+}
+
+QUERIES=1000
+SIZE=0
+STRATEGIES="double_sorting rstar"
+while test -n "$1"; do
+  case "$1" in
+    -n) shift; QUERIES=$1 ;;
+    -s) shift; SIZE=$1 ;;
+    -h|--help) usage; exit 0 ;;
+    -*) echo "Unknown option $1" >&2; usage >&2; exit 1 ;;
+    *)
+      if test -z "$TABLE"; then TABLE=$1
+      elif test -z "$COLUMN"; then COLUMN=$1
+      else usage >&2; exit 1
+      fi
+      ;;
+  esac
+  shift
+done
+
+if test -z "$TABLE" -o -z "$COLUMN"; then
+  usage >&2
+  exit 1
+fi
+
+setup_sql() {
+  cat <<'EOF'
+\pset footer off
+
+CREATE TEMP TABLE gist_split_queries AS
+WITH params AS (
+  SELECT box,
+    CASE WHEN :size > 0 THEN :size
+    ELSE greatest(ST_XMax(box) - ST_XMin(box), ST_YMax(box) - ST_YMin(box)) / 100
+    END AS size
+  FROM (SELECT ST_Extent(:"col")::geometry AS box FROM :"tbl") AS ext
+),
+srid AS (
+  SELECT ST_SRID(:"col") AS srid FROM :"tbl" LIMIT 1
+),
+dense AS (
+  SELECT ST_PointOnSurface(:"col") AS center
+  FROM :"tbl"
+  WHERE NOT ST_IsEmpty(:"col")
+  ORDER BY md5(ctid::text)
+  LIMIT :queries / 2
+),
+uniform AS (
+  SELECT ST_MakePoint(
+    ST_XMin(box) + (ST_XMax(box) - ST_XMin(box)) * ((i * 0.6180339887) % 1),
+    ST_YMin(box) + (ST_YMax(box) - ST_YMin(box)) * ((i * 0.7548776662) % 1)) AS center
+  FROM params, generate_series(1, :queries - :queries / 2) AS i
+)
+SELECT ST_SetSRID(ST_Expand(ST_Envelope(center), size), srid) AS box
+FROM (SELECT center FROM dense UNION ALL SELECT center FROM uniform) AS c, params, srid;
+
+CREATE FUNCTION pg_temp.gist_split_index_pages(tbl text, col text, q geometry)
+RETURNS bigint AS $$
+DECLARE
+  plan json;
+BEGIN
+  EXECUTE format('EXPLAIN (ANALYZE, BUFFERS, FORMAT JSON) SELECT count(*) FROM %I WHERE %I && %L::geometry',
+    tbl, col, q) INTO plan;
+  RETURN (
+    WITH RECURSIVE nodes(n) AS (
+      SELECT plan->0->'Plan'
+      UNION ALL
+      SELECT json_array_elements(n->'Plans') FROM nodes WHERE n->'Plans' IS NOT NULL
+    )
+    SELECT sum((n->>'Shared Hit Blocks')::bigint + (n->>'Shared Read Blocks')::bigint)
+    FROM nodes
+    WHERE n->>'Node Type' IN ('Bitmap Index Scan', 'Index Scan', 'Index Only Scan')
+  );
+END
+$$ LANGUAGE plpgsql;
+
+CREATE TEMP TABLE gist_split_results (
+  strategy text, build_ms float8, index_pages bigint,
+  avg_pages float8, max_pages bigint);
+
+SET enable_seqscan = off;
+EOF
+}
+
+# Build the index with a strategy, run the queries, and record the results
+strategy_sql() {
+  cat <<EOF
+SELECT clock_timestamp() AS t0 \gset
+CREATE INDEX gist_split_idx ON :"tbl" USING GIST (:"col" gist_geometry_ops_2d (split = '$1'));
+SELECT extract(epoch FROM clock_timestamp() - :'t0'::timestamptz) * 1000 AS build_ms \gset
+ANALYZE :"tbl";
+INSERT INTO gist_split_results
+SELECT '$1', :build_ms,
+  pg_relation_size('gist_split_idx') / current_setting('block_size')::int,
+  avg(p), max(p)
+FROM (
+  SELECT pg_temp.gist_split_index_pages(:'tbl', :'col', box) AS p
+  FROM gist_split_queries
+) AS q;
+DROP INDEX gist_split_idx;
+EOF
+}
+
+report_sql() {
+  cat <<'EOF'
+SELECT strategy, round(build_ms) AS build_ms, index_pages,
+  round(avg_pages::numeric, 2) AS avg_pages_per_query, max_pages
+FROM gist_split_results;
+EOF
+}
+
+{
+  setup_sql
+  for s in $STRATEGIES; do
+    strategy_sql $s
+  done
+  report_sql
+} | psql -X -q -v ON_ERROR_STOP=1 \
+  -v tbl="$TABLE" -v col="$COLUMN" -v queries="$QUERIES" -v size="$SIZE"